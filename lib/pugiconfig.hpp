@@ -26,6 +26,15 @@
 // Uncomment this to disable exceptions
 // #define PUGIXML_NO_EXCEPTIONS
 
+// Uncomment this to disable SSE2/AVX2/NEON character scanning in the parser and the writer
+// #define PUGIXML_NO_SIMD
+
+// Uncomment this to disable xml_writer_fd on POSIX platforms
+// #define PUGIXML_NO_POSIX_IO
+
+// Uncomment this to store node links as 32-bit offsets, which makes nodes and attributes smaller on 64-bit targets
+// #define PUGIXML_COMPACT
+
 // Set this to control attributes for public classes/functions, i.e.:
 // #define PUGIXML_API __declspec(dllexport) // to export all public symbols from DLL
 // #define PUGIXML_CLASS __declspec(dllimport) // to import all classes from DLL
@@ -44,6 +53,9 @@
 // Uncomment this to enable long long support
 // #define PUGIXML_HAS_LONG_LONG
 
+// Uncomment this to enable xpath_query::evaluate_node_set_parallel (needs C++11 std::thread)
+// #define PUGIXML_HAS_THREADS
+
 #endif
 
 /**
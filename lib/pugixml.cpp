@@ -20,17 +20,33 @@
 #include <stdio.h>
 #include <string.h>
 #include <assert.h>
+#include <limits.h>
+#include <float.h>
+#include <locale.h>
+#include <math.h>
 
 #ifdef PUGIXML_WCHAR_MODE
 #	include <wchar.h>
 #endif
 
+#ifdef PUGIXML_HAS_POSIX_IO
+#	include <errno.h>
+#	include <fcntl.h>
+#	include <unistd.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <sys/uio.h>
+#endif
+
 #ifndef PUGIXML_NO_XPATH
-#	include <math.h>
-#	include <float.h>
 #	ifdef PUGIXML_NO_EXCEPTIONS
 #		include <setjmp.h>
 #	endif
+#	ifdef PUGIXML_HAS_THREADS
+#		include <thread>
+#		include <mutex>
+#		include <condition_variable>
+#	endif
 #endif
 
 #ifndef PUGIXML_NO_STL
@@ -42,6 +58,20 @@
 // For placement new
 #include <new>
 
+// SIMD character scanning; only used for 8-bit char_t
+#if !defined(PUGIXML_NO_SIMD) && !defined(PUGIXML_WCHAR_MODE) && defined(__GNUC__)
+#	if defined(__AVX2__)
+#		include <immintrin.h>
+#		define PUGI__SIMD_AVX2
+#	elif defined(__SSE2__)
+#		include <emmintrin.h>
+#		define PUGI__SIMD_SSE2
+#	elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#		include <arm_neon.h>
+#		define PUGI__SIMD_NEON
+#	endif
+#endif
+
 #ifdef _MSC_VER
 #	pragma warning(push)
 #	pragma warning(disable: 4127) // conditional expression is constant
@@ -107,6 +137,11 @@ using std::memcpy;
 using std::memmove;
 #endif
 
+// Number conversions take shortcuts that are only correctly rounded when double arithmetic has no extended precision intermediates
+#if (defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD == 0) || (defined(__FLT_EVAL_METHOD__) && __FLT_EVAL_METHOD__ == 0) || defined(_M_X64) || defined(_M_ARM)
+#	define PUGI__EXACT_DOUBLE
+#endif
+
 // In some environments MSVC is a compiler but the CRT lacks certain MSVC-specific features
 #if defined(_MSC_VER) && !defined(__S3E__)
 #	define PUGI__MSVC_CRT_VERSION _MSC_VER
@@ -279,6 +314,14 @@ PUGI__NS_BEGIN
 
 	#define PUGI__NODETYPE(n) static_cast<xml_node_type>(((n)->header & impl::xml_memory_page_type_mask) + 1)
 
+#ifdef PUGIXML_COMPACT
+	#define PUGI__GETPAGE_IMPL(header) (header).get_page()
+#else
+	#define PUGI__GETPAGE_IMPL(header) reinterpret_cast<impl::xml_memory_page*>((header) & impl::xml_memory_page_pointer_mask)
+#endif
+
+	#define PUGI__GETPAGE(n) PUGI__GETPAGE_IMPL((n)->header)
+
 	struct xml_allocator;
 
 	struct xml_memory_page
@@ -292,6 +335,7 @@ PUGI__NS_BEGIN
 			result->next = 0;
 			result->busy_size = 0;
 			result->freed_size = 0;
+			result->data_size = 0;
 
 			return result;
 		}
@@ -303,6 +347,18 @@ PUGI__NS_BEGIN
 
 		size_t busy_size;
 		size_t freed_size;
+		size_t data_size;
+	};
+
+	// Pages kept for reuse by a document in memory reuse or arena mode, and the caller-owned block that arena pages are carved from
+	struct xml_page_pool
+	{
+		xml_memory_page* free_pages;
+		bool reuse;
+
+		char* arena;
+		size_t arena_size;
+		size_t arena_used;
 	};
 
 	struct xml_memory_string_header
@@ -311,32 +367,167 @@ PUGI__NS_BEGIN
 		uint16_t full_size; // 0 if string occupies whole page
 	};
 
+#ifdef PUGIXML_COMPACT
+	// Full pointers for compact pointer fields whose target is out of 32-bit range, keyed by the address of the field
+	class compact_hash_table
+	{
+	public:
+		compact_hash_table(): _items(0), _capacity(0), _count(0)
+		{
+		}
+
+		// Drops all entries but keeps the storage
+		void clear()
+		{
+			if (_items) memset(_items, 0, _capacity * sizeof(item_t));
+
+			_count = 0;
+		}
+
+		void release()
+		{
+			if (_items) xml_memory::deallocate(_items);
+
+			_items = 0;
+			_capacity = 0;
+			_count = 0;
+		}
+
+		void* find(const void* key) const
+		{
+			if (_capacity == 0) return 0;
+
+			for (size_t bucket = hash(key) & (_capacity - 1); _items[bucket].key; bucket = (bucket + 1) & (_capacity - 1))
+				if (_items[bucket].key == key) return _items[bucket].value;
+
+			return 0;
+		}
+
+		void insert(const void* key, void* value)
+		{
+			// reserve() keeps a quarter of the table free, so there is always an empty bucket
+			assert(_count < _capacity);
+
+			size_t bucket = hash(key) & (_capacity - 1);
+
+			while (_items[bucket].key && _items[bucket].key != key) bucket = (bucket + 1) & (_capacity - 1);
+
+			if (!_items[bucket].key) ++_count;
+
+			_items[bucket].key = key;
+			_items[bucket].value = value;
+		}
+
+		// Makes sure that the next few inserts do not need to grow the table (insert can't fail)
+		bool reserve(size_t extra = 16)
+		{
+			if (_count + extra >= _capacity - _capacity / 4) return rehash(_count + extra);
+
+			return true;
+		}
+
+	private:
+		struct item_t
+		{
+			const void* key;
+			void* value;
+		};
+
+		item_t* _items;
+		size_t _capacity;
+		size_t _count;
+
+		static size_t hash(const void* key)
+		{
+			// objects are at least 4-byte aligned, so the low bits carry no information
+			uintptr_t h = reinterpret_cast<uintptr_t>(key) >> 2;
+
+			return static_cast<size_t>(h ^ (h >> 15));
+		}
+
+		bool rehash(size_t count)
+		{
+			size_t capacity = 32;
+			while (count >= capacity - capacity / 4) capacity *= 2;
+
+			item_t* items = static_cast<item_t*>(xml_memory::allocate(capacity * sizeof(item_t)));
+			if (!items) return false;
+
+			memset(items, 0, capacity * sizeof(item_t));
+
+			item_t* old_items = _items;
+			size_t old_capacity = _capacity;
+
+			_items = items;
+			_capacity = capacity;
+			_count = 0;
+
+			for (size_t i = 0; i < old_capacity; ++i)
+				if (old_items[i].key) insert(old_items[i].key, old_items[i].value);
+
+			if (old_items) xml_memory::deallocate(old_items);
+
+			return true;
+		}
+	};
+#endif
+
 	struct xml_allocator
 	{
-		xml_allocator(xml_memory_page* root): _root(root), _busy_size(root->busy_size)
+		xml_allocator(xml_memory_page* root): _root(root), _busy_size(root->busy_size), _pool()
 		{
 		}
 
 		xml_memory_page* allocate_page(size_t data_size)
 		{
+			// pages kept by reset() are all regular sized
+			if (data_size == xml_memory_page_size && _pool.free_pages)
+			{
+				xml_memory_page* free_page = _pool.free_pages;
+				_pool.free_pages = free_page->next;
+
+				xml_memory_page* page = xml_memory_page::construct(free_page);
+
+				page->allocator = _root->allocator;
+				page->data_size = data_size;
+
+				return page;
+			}
+
 			size_t size = sizeof(xml_memory_page) + data_size;
+			char* page_memory;
+
+			if (_pool.arena)
+			{
+				// carve the page out of the arena; the arena is only rewound as a whole, so there is no offset to record
+				uintptr_t arena = reinterpret_cast<uintptr_t>(_pool.arena);
+				size_t offset = ((arena + _pool.arena_used + (xml_memory_page_alignment - 1)) & ~(xml_memory_page_alignment - 1)) - arena;
+
+				if (offset > _pool.arena_size || size > _pool.arena_size - offset) return 0;
+
+				page_memory = _pool.arena + offset;
+				_pool.arena_used = offset + size;
+			}
+			else
+			{
+				// allocate block with some alignment, leaving memory for worst-case padding
+				void* memory = xml_memory::allocate(size + xml_memory_page_alignment);
+				if (!memory) return 0;
 
-			// allocate block with some alignment, leaving memory for worst-case padding
-			void* memory = xml_memory::allocate(size + xml_memory_page_alignment);
-			if (!memory) return 0;
+				// align to next page boundary (note: this guarantees at least 1 usable byte before the page)
+				page_memory = reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(memory) + xml_memory_page_alignment) & ~(xml_memory_page_alignment - 1));
 
-			// align to next page boundary (note: this guarantees at least 1 usable byte before the page)
-			char* page_memory = reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(memory) + xml_memory_page_alignment) & ~(xml_memory_page_alignment - 1));
+				// record the offset for freeing the memory block
+				assert(page_memory > memory && page_memory - static_cast<char*>(memory) <= 127);
+				page_memory[-1] = static_cast<char>(page_memory - static_cast<char*>(memory));
+			}
 
 			// prepare page structure
 			xml_memory_page* page = xml_memory_page::construct(page_memory);
 			assert(page);
 
 			page->allocator = _root->allocator;
-
-			// record the offset for freeing the memory block
-			assert(page_memory > memory && page_memory - static_cast<char*>(memory) <= 127);
-			page_memory[-1] = static_cast<char>(page_memory - static_cast<char*>(memory));
+			page->data_size = data_size;
 
 			return page;
 		}
@@ -348,10 +539,47 @@ PUGI__NS_BEGIN
 			xml_memory::deallocate(page_memory - page_memory[-1]);
 		}
 
+		// Returns a page that is no longer used to the pool if the document keeps its memory, or to the heap otherwise
+		void release_page(xml_memory_page* page)
+		{
+			if (page->data_size == xml_memory_page_size && (_pool.reuse || _pool.arena))
+			{
+				page->next = _pool.free_pages;
+				_pool.free_pages = page;
+			}
+			else if (!_pool.arena) deallocate_page(page);
+
+			// large pages carved from the arena are reclaimed when the arena is rewound
+		}
+
+		// Frees the kept pages; arena pages are just forgotten since the arena owns them
+		void release_pool()
+		{
+			if (!_pool.arena)
+			{
+				while (_pool.free_pages)
+				{
+					xml_memory_page* next = _pool.free_pages->next;
+
+					deallocate_page(_pool.free_pages);
+
+					_pool.free_pages = next;
+				}
+			}
+
+			_pool.free_pages = 0;
+			_pool.arena_used = 0;
+		}
+
 		void* allocate_memory_oob(size_t size, xml_memory_page*& out_page);
 
 		void* allocate_memory(size_t size, xml_memory_page*& out_page)
 		{
+		#ifdef PUGIXML_COMPACT
+			// links to the new object may need the far pointer table, and storing into it can't fail
+			if (!_hash.reserve()) return 0;
+		#endif
+
 			if (_busy_size + size > xml_memory_page_size) return allocate_memory_oob(size, out_page);
 
 			void* buf = reinterpret_cast<char*>(_root) + sizeof(xml_memory_page) + _busy_size;
@@ -393,7 +621,7 @@ PUGI__NS_BEGIN
 					page->next->prev = page->prev;
 
 					// deallocate
-					deallocate_page(page);
+					release_page(page);
 				}
 			}
 		}
@@ -449,6 +677,12 @@ PUGI__NS_BEGIN
 
 		xml_memory_page* _root;
 		size_t _busy_size;
+
+		xml_page_pool _pool;
+
+	#ifdef PUGIXML_COMPACT
+		compact_hash_table _hash;
+	#endif
 	};
 
 	PUGI__FN_NO_INLINE void* xml_allocator::allocate_memory_oob(size_t size, xml_memory_page*& out_page)
@@ -491,8 +725,156 @@ PUGI__NS_BEGIN
 	}
 PUGI__NS_END
 
+#ifdef PUGIXML_COMPACT
+PUGI__NS_BEGIN
+	// Object header that stores the offset of the object from its page instead of the page pointer; flags take the low 8 bits
+	class compact_header
+	{
+	public:
+		compact_header(xml_memory_page* page, unsigned int flags)
+		{
+			PUGI__STATIC_ASSERT(xml_memory_page_size < (1 << 23));
+
+			ptrdiff_t offset = reinterpret_cast<char*>(this) - reinterpret_cast<char*>(page);
+			assert(offset > 0 && offset < (1 << 24) && flags < 256);
+
+			_data = static_cast<uint32_t>(offset << 8) | flags;
+		}
+
+		void operator&=(uintptr_t mod)
+		{
+			_data &= static_cast<uint32_t>(mod);
+		}
+
+		void operator|=(uintptr_t mod)
+		{
+			_data |= static_cast<uint32_t>(mod);
+		}
+
+		operator uintptr_t() const
+		{
+			return _data;
+		}
+
+		xml_memory_page* get_page() const
+		{
+			const char* page = reinterpret_cast<const char*>(this) - (_data >> 8);
+
+			return const_cast<xml_memory_page*>(reinterpret_cast<const xml_memory_page*>(static_cast<const void*>(page)));
+		}
+
+	private:
+		uint32_t _data;
+	};
+
+	// Pointer stored as a 32-bit offset from its own address; header_offset is the distance back to the header of the object
+	// that holds the pointer, which leads to the far pointer table of the document for targets that are out of range
+	template <typename T, size_t header_offset> class compact_pointer
+	{
+	public:
+		compact_pointer(): _data(0)
+		{
+		}
+
+		void operator=(const compact_pointer& rhs)
+		{
+			*this = static_cast<T*>(rhs);
+		}
+
+		void operator=(T* value)
+		{
+			if (!value)
+			{
+				_data = 0;
+				return;
+			}
+
+			ptrdiff_t offset = reinterpret_cast<char*>(value) - reinterpret_cast<char*>(this);
+
+			if (offset > -2147483647 && offset <= 2147483647 && offset != 0)
+				_data = static_cast<uint32_t>(offset);
+			else
+			{
+				_data = far_marker;
+				get_allocator()->_hash.insert(this, value);
+			}
+		}
+
+		operator T*() const
+		{
+			if (_data == 0) return 0;
+
+			if (_data == far_marker) return static_cast<T*>(get_allocator()->_hash.find(this));
+
+			// sign-extend the offset
+			ptrdiff_t offset = (_data & 0x80000000) ? -static_cast<ptrdiff_t>(~_data + 1) : static_cast<ptrdiff_t>(_data);
+
+			return reinterpret_cast<T*>(const_cast<char*>(reinterpret_cast<const char*>(this)) + offset);
+		}
+
+		T* operator->() const
+		{
+			return *this;
+		}
+
+	private:
+		static const uint32_t far_marker = 0x80000000;
+
+		uint32_t _data;
+
+		// Non-copyable semantics (a copied offset would point somewhere else)
+		compact_pointer(const compact_pointer&);
+
+		xml_allocator* get_allocator() const
+		{
+			const compact_header* header = reinterpret_cast<const compact_header*>(reinterpret_cast<const char*>(this) - header_offset);
+
+			return header->get_page()->allocator;
+		}
+	};
+PUGI__NS_END
+#endif
+
 namespace pugi
 {
+#ifdef PUGIXML_COMPACT
+	// Same structures with the page pointer and the links packed into 32 bits; names and values stay full pointers since
+	// they usually point into the parse buffer, which is not near the pages
+	struct xml_attribute_struct
+	{
+		xml_attribute_struct(impl::xml_memory_page* page): header(page, 0), name(0), value(0)
+		{
+		}
+
+		impl::compact_header header;
+
+		impl::compact_pointer<xml_attribute_struct, 4> prev_attribute_c;	///< Previous attribute (cyclic list)
+
+		char_t* name;	///< Pointer to attribute name.
+		char_t*	value;	///< Pointer to attribute value.
+
+		impl::compact_pointer<xml_attribute_struct, 8 + 2 * sizeof(char_t*)> next_attribute;	///< Next attribute
+	};
+
+	struct xml_node_struct
+	{
+		xml_node_struct(impl::xml_memory_page* page, xml_node_type type): header(page, type - 1), name(0), value(0)
+		{
+		}
+
+		impl::compact_header header;
+
+		impl::compact_pointer<xml_node_struct, 4> parent;	///< Pointer to parent
+
+		char_t* name;	///< Pointer to element name.
+		char_t* value;	///< Pointer to any associated string data.
+
+		impl::compact_pointer<xml_node_struct, 8 + 2 * sizeof(char_t*)> first_child;			///< First child
+		impl::compact_pointer<xml_node_struct, 12 + 2 * sizeof(char_t*)> prev_sibling_c;		///< Left brother (cyclic list)
+		impl::compact_pointer<xml_node_struct, 16 + 2 * sizeof(char_t*)> next_sibling;			///< Right brother
+		impl::compact_pointer<xml_attribute_struct, 20 + 2 * sizeof(char_t*)> first_attribute;	///< First attribute
+	};
+#else
 	/// A 'name=value' XML attribute structure.
 	struct xml_attribute_struct
 	{
@@ -533,6 +915,7 @@ namespace pugi
 		
 		xml_attribute_struct*	first_attribute;		///< First attribute
 	};
+#endif
 }
 
 PUGI__NS_BEGIN
@@ -540,31 +923,124 @@ PUGI__NS_BEGIN
 	{
 		char_t* buffer;
 		xml_extra_buffer* next;
+
+		// nonzero if buffer is a file mapping made by load_file_mmap
+		size_t mapping_size;
+	};
+
+#ifndef PUGIXML_NO_XPATH
+	struct xml_attribute_index_key
+	{
+		char_t* element;
+		char_t* attribute;
+	};
+
+	struct xml_attribute_index_entry
+	{
+		xml_node_struct* node;
+		const char_t* value;
+		unsigned int hash;
+		unsigned int key;
+
+		xml_attribute_index_entry* next; // next entry in the same bucket, in document order
+	};
+
+	// Element lookup by attribute value for the (element, attribute) name pairs registered with xml_document::add_attribute_index
+	struct xml_attribute_index
+	{
+		xml_attribute_index_key* keys;
+		size_t key_count;
+
+		xml_attribute_index_entry* entries;
+		size_t entry_capacity;
+
+		xml_attribute_index_entry** buckets;
+		size_t bucket_count;
+
+		// entries point into the tree, so any change to it marks the index out of date until the next load rebuilds it
+		bool current;
 	};
 
+	PUGI__FN void destroy_attribute_index(xml_attribute_index* index)
+	{
+		for (size_t i = 0; i < index->key_count; ++i)
+		{
+			xml_memory::deallocate(index->keys[i].element);
+			xml_memory::deallocate(index->keys[i].attribute);
+		}
+
+		if (index->keys) xml_memory::deallocate(index->keys);
+		if (index->entries) xml_memory::deallocate(index->entries);
+		if (index->buckets) xml_memory::deallocate(index->buckets);
+
+		xml_memory::deallocate(index);
+	}
+#else
+	struct xml_attribute_index;
+#endif
+
+	struct xml_push_parser;
+
 	struct xml_document_struct: public xml_node_struct, public xml_allocator
 	{
-		xml_document_struct(xml_memory_page* page): xml_node_struct(page, node_document), xml_allocator(page), buffer(0), extra_buffers(0)
+		xml_document_struct(xml_memory_page* page): xml_node_struct(page, node_document), xml_allocator(page), buffer(0), extra_buffers(0), attribute_index(0), push(0)
 		{
 		}
 
 		const char_t* buffer;
 
 		xml_extra_buffer* extra_buffers;
+
+		xml_attribute_index* attribute_index;
+
+		// state of load_begin/load_chunk/load_end
+		xml_push_parser* push;
 	};
 
 	inline xml_allocator& get_allocator(const xml_node_struct* node)
 	{
 		assert(node);
 
-		return *reinterpret_cast<xml_memory_page*>(node->header & xml_memory_page_pointer_mask)->allocator;
+		return *PUGI__GETPAGE(node)->allocator;
 	}
 
 	template <typename Object> inline xml_document_struct& get_document(const Object* object)
 	{
 		assert(object);
 
-		return *static_cast<xml_document_struct*>(reinterpret_cast<xml_memory_page*>(object->header & xml_memory_page_pointer_mask)->allocator);
+		return *static_cast<xml_document_struct*>(PUGI__GETPAGE(object)->allocator);
+	}
+
+	inline void document_changed(xml_allocator* alloc)
+	{
+	#ifndef PUGIXML_NO_XPATH
+		xml_attribute_index* index = static_cast<xml_document_struct*>(alloc)->attribute_index;
+
+		if (index) index->current = false;
+	#else
+		(void)alloc;
+	#endif
+	}
+
+	template <typename Object> inline void document_changed(const Object* object)
+	{
+		document_changed(PUGI__GETPAGE(object)->allocator);
+	}
+
+#ifndef PUGIXML_NO_XPATH
+	PUGI__FN bool attribute_index_build(xml_attribute_index* index, xml_node_struct* root);
+#endif
+
+	// Rebuilds an out of date attribute index. This is only called by functions that change the document, never by XPath
+	// evaluation, so that concurrent queries on one document only read the index.
+	inline void update_attribute_index(xml_document_struct* doc)
+	{
+	#ifndef PUGIXML_NO_XPATH
+		// if memory runs out the index stays out of date and queries scan instead
+		if (doc->attribute_index && !doc->attribute_index->current) attribute_index_build(doc->attribute_index, doc);
+	#else
+		(void)doc;
+	#endif
 	}
 PUGI__NS_END
 
@@ -574,6 +1050,7 @@ PUGI__NS_BEGIN
 	{
 		xml_memory_page* page;
 		void* memory = alloc.allocate_memory(sizeof(xml_attribute_struct), page);
+		if (!memory) return 0;
 
 		return new (memory) xml_attribute_struct(page);
 	}
@@ -582,6 +1059,7 @@ PUGI__NS_BEGIN
 	{
 		xml_memory_page* page;
 		void* memory = alloc.allocate_memory(sizeof(xml_node_struct), page);
+		if (!memory) return 0;
 
 		return new (memory) xml_node_struct(page, type);
 	}
@@ -593,7 +1071,7 @@ PUGI__NS_BEGIN
 		if (header & impl::xml_memory_page_name_allocated_mask) alloc.deallocate_string(a->name);
 		if (header & impl::xml_memory_page_value_allocated_mask) alloc.deallocate_string(a->value);
 
-		alloc.deallocate_memory(a, sizeof(xml_attribute_struct), reinterpret_cast<xml_memory_page*>(header & xml_memory_page_pointer_mask));
+		alloc.deallocate_memory(a, sizeof(xml_attribute_struct), PUGI__GETPAGE(a));
 	}
 
 	inline void destroy_node(xml_node_struct* n, xml_allocator& alloc)
@@ -621,11 +1099,13 @@ PUGI__NS_BEGIN
 			child = next;
 		}
 
-		alloc.deallocate_memory(n, sizeof(xml_node_struct), reinterpret_cast<xml_memory_page*>(header & xml_memory_page_pointer_mask));
+		alloc.deallocate_memory(n, sizeof(xml_node_struct), PUGI__GETPAGE(n));
 	}
 
 	inline void append_node(xml_node_struct* child, xml_node_struct* node)
 	{
+		document_changed(node);
+
 		child->parent = node;
 
 		xml_node_struct* head = node->first_child;
@@ -647,6 +1127,8 @@ PUGI__NS_BEGIN
 
 	inline void prepend_node(xml_node_struct* child, xml_node_struct* node)
 	{
+		document_changed(node);
+
 		child->parent = node;
 
 		xml_node_struct* head = node->first_child;
@@ -665,6 +1147,8 @@ PUGI__NS_BEGIN
 
 	inline void insert_node_after(xml_node_struct* child, xml_node_struct* node)
 	{
+		document_changed(node);
+
 		xml_node_struct* parent = node->parent;
 
 		child->parent = parent;
@@ -682,6 +1166,8 @@ PUGI__NS_BEGIN
 
 	inline void insert_node_before(xml_node_struct* child, xml_node_struct* node)
 	{
+		document_changed(node);
+
 		xml_node_struct* parent = node->parent;
 
 		child->parent = parent;
@@ -699,6 +1185,8 @@ PUGI__NS_BEGIN
 
 	inline void remove_node(xml_node_struct* node)
 	{
+		document_changed(node);
+
 		xml_node_struct* parent = node->parent;
 
 		if (node->next_sibling)
@@ -718,6 +1206,8 @@ PUGI__NS_BEGIN
 
 	inline void append_attribute(xml_attribute_struct* attr, xml_node_struct* node)
 	{
+		document_changed(node);
+
 		xml_attribute_struct* head = node->first_attribute;
 
 		if (head)
@@ -737,6 +1227,8 @@ PUGI__NS_BEGIN
 
 	inline void prepend_attribute(xml_attribute_struct* attr, xml_node_struct* node)
 	{
+		document_changed(node);
+
 		xml_attribute_struct* head = node->first_attribute;
 
 		if (head)
@@ -753,6 +1245,8 @@ PUGI__NS_BEGIN
 
 	inline void insert_attribute_after(xml_attribute_struct* attr, xml_attribute_struct* place, xml_node_struct* node)
 	{
+		document_changed(node);
+
 		if (place->next_attribute)
 			place->next_attribute->prev_attribute_c = attr;
 		else
@@ -765,6 +1259,8 @@ PUGI__NS_BEGIN
 
 	inline void insert_attribute_before(xml_attribute_struct* attr, xml_attribute_struct* place, xml_node_struct* node)
 	{
+		document_changed(node);
+
 		if (place->prev_attribute_c->next_attribute)
 			place->prev_attribute_c->next_attribute = attr;
 		else
@@ -777,6 +1273,8 @@ PUGI__NS_BEGIN
 
 	inline void remove_attribute(xml_attribute_struct* attr, xml_node_struct* node)
 	{
+		document_changed(node);
+
 		if (attr->next_attribute)
 			attr->next_attribute->prev_attribute_c = attr->prev_attribute_c;
 		else
@@ -1273,14 +1771,142 @@ PUGI__NS_BEGIN
 	#define PUGI__IS_CHARTYPE(c, ct) PUGI__IS_CHARTYPE_IMPL(c, ct, chartype_table)
 	#define PUGI__IS_CHARTYPEX(c, ct) PUGI__IS_CHARTYPE_IMPL(c, ct, chartypex_table)
 
-	PUGI__FN bool is_little_endian()
-	{
-		unsigned int ui = 1;
+#if defined(PUGI__SIMD_AVX2) || defined(PUGI__SIMD_SSE2) || defined(PUGI__SIMD_NEON)
+	#define PUGI__SIMD
 
-		return *reinterpret_cast<unsigned char*>(&ui) == 1;
-	}
+	// Aligned loads may read past the terminator but never past the end of the page; tell ASan that this is intended
+#if defined(__has_feature)
+#	if __has_feature(address_sanitizer)
+#		define PUGI__SIMD_NO_SANITIZE __attribute__((no_sanitize_address))
+#	endif
+#elif defined(__SANITIZE_ADDRESS__)
+#	define PUGI__SIMD_NO_SANITIZE __attribute__((no_sanitize_address))
+#endif
 
-	PUGI__FN xml_encoding get_wchar_encoding()
+#ifndef PUGI__SIMD_NO_SANITIZE
+#	define PUGI__SIMD_NO_SANITIZE
+#endif
+
+#if defined(PUGI__SIMD_AVX2)
+	typedef __m256i simd_vector_t;
+	typedef uint32_t simd_mask_t;
+
+	static const size_t simd_width = 32;
+	static const unsigned int simd_mask_bits_per_char = 1;
+
+	PUGI__FN PUGI__SIMD_NO_SANITIZE simd_vector_t simd_load(const char_t* block) { return _mm256_load_si256(reinterpret_cast<const __m256i*>(block)); }
+	PUGI__FN simd_vector_t simd_eq(simd_vector_t v, char c) { return _mm256_cmpeq_epi8(v, _mm256_set1_epi8(c)); }
+	PUGI__FN simd_vector_t simd_le(simd_vector_t v, char c) { return _mm256_cmpeq_epi8(_mm256_min_epu8(v, _mm256_set1_epi8(c)), v); }
+	PUGI__FN simd_vector_t simd_or(simd_vector_t a, simd_vector_t b) { return _mm256_or_si256(a, b); }
+	PUGI__FN simd_mask_t simd_movemask(simd_vector_t v) { return static_cast<simd_mask_t>(_mm256_movemask_epi8(v)); }
+	PUGI__FN unsigned int simd_ctz(simd_mask_t mask) { return __builtin_ctz(mask); }
+#elif defined(PUGI__SIMD_SSE2)
+	typedef __m128i simd_vector_t;
+	typedef uint32_t simd_mask_t;
+
+	static const size_t simd_width = 16;
+	static const unsigned int simd_mask_bits_per_char = 1;
+
+	PUGI__FN PUGI__SIMD_NO_SANITIZE simd_vector_t simd_load(const char_t* block) { return _mm_load_si128(reinterpret_cast<const __m128i*>(block)); }
+	PUGI__FN simd_vector_t simd_eq(simd_vector_t v, char c) { return _mm_cmpeq_epi8(v, _mm_set1_epi8(c)); }
+	PUGI__FN simd_vector_t simd_le(simd_vector_t v, char c) { return _mm_cmpeq_epi8(_mm_min_epu8(v, _mm_set1_epi8(c)), v); }
+	PUGI__FN simd_vector_t simd_or(simd_vector_t a, simd_vector_t b) { return _mm_or_si128(a, b); }
+	PUGI__FN simd_mask_t simd_movemask(simd_vector_t v) { return static_cast<simd_mask_t>(_mm_movemask_epi8(v)); }
+	PUGI__FN unsigned int simd_ctz(simd_mask_t mask) { return __builtin_ctz(mask); }
+#else
+	typedef uint8x16_t simd_vector_t;
+	typedef unsigned long long simd_mask_t;
+
+	// NEON has no movemask; narrowing each 16-bit lane by 4 leaves a nibble per character instead
+	static const size_t simd_width = 16;
+	static const unsigned int simd_mask_bits_per_char = 4;
+
+	PUGI__FN PUGI__SIMD_NO_SANITIZE simd_vector_t simd_load(const char_t* block) { return vld1q_u8(reinterpret_cast<const uint8_t*>(block)); }
+	PUGI__FN simd_vector_t simd_eq(simd_vector_t v, char c) { return vceqq_u8(v, vdupq_n_u8(static_cast<uint8_t>(c))); }
+	PUGI__FN simd_vector_t simd_le(simd_vector_t v, char c) { return vcleq_u8(v, vdupq_n_u8(static_cast<uint8_t>(c))); }
+	PUGI__FN simd_vector_t simd_or(simd_vector_t a, simd_vector_t b) { return vorrq_u8(a, b); }
+	PUGI__FN simd_mask_t simd_movemask(simd_vector_t v) { return vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(v), 4)), 0); }
+	PUGI__FN unsigned int simd_ctz(simd_mask_t mask) { return __builtin_ctzll(mask); }
+#endif
+
+	// Returns a mask of characters in the block that have chartype ct; covers the sets used for scanning text (not ct_symbol/ct_start_symbol)
+	template <int ct> PUGI__FN simd_mask_t simd_chartype_mask(const char_t* block)
+	{
+		simd_vector_t v = simd_load(block);
+		simd_vector_t m = simd_or(simd_eq(v, 0), simd_eq(v, '\r'));
+
+		if (ct & (ct_parse_pcdata | ct_parse_attr | ct_parse_attr_ws)) m = simd_or(m, simd_eq(v, '&'));
+		if (ct & ct_parse_pcdata) m = simd_or(m, simd_eq(v, '<'));
+		if (ct & (ct_parse_attr | ct_parse_attr_ws)) m = simd_or(m, simd_or(simd_eq(v, '"'), simd_eq(v, '\'')));
+		if (ct & (ct_parse_attr_ws | ct_space)) m = simd_or(m, simd_or(simd_eq(v, '\n'), simd_eq(v, '\t')));
+		if (ct & ct_space) m = simd_or(m, simd_eq(v, ' '));
+		if (ct & (ct_parse_cdata | ct_parse_comment)) m = simd_or(m, simd_eq(v, '>'));
+		if (ct & ct_parse_cdata) m = simd_or(m, simd_eq(v, ']'));
+		if (ct & ct_parse_comment) m = simd_or(m, simd_eq(v, '-'));
+
+		return simd_movemask(m);
+	}
+
+	// Returns the first character in s that has chartype ct; the string has to be 0-terminated.
+	// Blocks are loaded aligned, so the block holding the terminator may read past the end of the string, but never into another page.
+	template <int ct> PUGI__FN char_t* simd_scan_chartype(char_t* s)
+	{
+		size_t misalign = reinterpret_cast<uintptr_t>(s) & (simd_width - 1);
+		const char_t* block = s - misalign;
+
+		simd_mask_t mask = simd_chartype_mask<ct>(block) >> (misalign * simd_mask_bits_per_char);
+		if (mask) return s + simd_ctz(mask) / simd_mask_bits_per_char;
+
+		for (;;)
+		{
+			block += simd_width;
+
+			mask = simd_chartype_mask<ct>(block);
+			if (mask) return const_cast<char_t*>(block) + simd_ctz(mask) / simd_mask_bits_per_char;
+		}
+	}
+
+	// Returns a mask of characters in the block that have to be escaped on output with chartypex ctx (see chartypex_table)
+	template <int ctx> PUGI__FN simd_mask_t simd_chartypex_mask(const char_t* block)
+	{
+		simd_vector_t v = simd_load(block);
+		simd_vector_t special = simd_or(simd_eq(v, '&'), simd_or(simd_eq(v, '<'), simd_eq(v, '>')));
+		simd_vector_t allowed = simd_eq(v, '\t');
+
+		if (ctx & ctx_special_attr) special = simd_or(special, simd_eq(v, '"'));
+		else allowed = simd_or(allowed, simd_or(simd_eq(v, '\r'), simd_eq(v, '\n')));
+
+		// control characters (including the terminator) except for the allowed whitespace
+		return simd_movemask(special) | (simd_movemask(simd_le(v, 31)) & ~simd_movemask(allowed));
+	}
+
+	// Returns the first character in s that has to be escaped or the terminator; same block loading rules as simd_scan_chartype
+	template <int ctx> PUGI__FN const char_t* simd_scan_chartypex(const char_t* s)
+	{
+		size_t misalign = reinterpret_cast<uintptr_t>(s) & (simd_width - 1);
+		const char_t* block = s - misalign;
+
+		simd_mask_t mask = simd_chartypex_mask<ctx>(block) >> (misalign * simd_mask_bits_per_char);
+		if (mask) return s + simd_ctz(mask) / simd_mask_bits_per_char;
+
+		for (;;)
+		{
+			block += simd_width;
+
+			mask = simd_chartypex_mask<ctx>(block);
+			if (mask) return block + simd_ctz(mask) / simd_mask_bits_per_char;
+		}
+	}
+#endif
+
+	PUGI__FN bool is_little_endian()
+	{
+		unsigned int ui = 1;
+
+		return *reinterpret_cast<unsigned char*>(&ui) == 1;
+	}
+
+	PUGI__FN xml_encoding get_wchar_encoding()
 	{
 		PUGI__STATIC_ASSERT(sizeof(wchar_t) == 2 || sizeof(wchar_t) == 4);
 
@@ -1749,16 +2375,18 @@ PUGI__NS_BEGIN
 		return target_length >= length && (target_length < reuse_threshold || target_length - length < target_length / 2);
 	}
 
-	PUGI__FN bool strcpy_insitu(char_t*& dest, uintptr_t& header, uintptr_t header_mask, const char_t* source)
+	template <typename Header> PUGI__FN bool strcpy_insitu(char_t*& dest, Header& header, uintptr_t header_mask, const char_t* source)
 	{
 		assert(header);
 
+		document_changed(PUGI__GETPAGE_IMPL(header)->allocator);
+
 		size_t source_length = strlength(source);
 
 		if (source_length == 0)
 		{
 			// empty string and null pointer are equivalent, so just deallocate old memory
-			xml_allocator* alloc = reinterpret_cast<xml_memory_page*>(header & xml_memory_page_pointer_mask)->allocator;
+			xml_allocator* alloc = PUGI__GETPAGE_IMPL(header)->allocator;
 
 			if (header & header_mask) alloc->deallocate_string(dest);
 			
@@ -1777,7 +2405,7 @@ PUGI__NS_BEGIN
 		}
 		else
 		{
-			xml_allocator* alloc = reinterpret_cast<xml_memory_page*>(header & xml_memory_page_pointer_mask)->allocator;
+			xml_allocator* alloc = PUGI__GETPAGE_IMPL(header)->allocator;
 
 			// allocate new buffer
 			char_t* buf = alloc->allocate_string(source_length + 1);
@@ -1988,6 +2616,11 @@ PUGI__NS_BEGIN
 	#define PUGI__SCANFOR(X)            { while (*s != 0 && !(X)) ++s; }
 	#define PUGI__SCANWHILE(X)          { while (X) ++s; }
 	#define PUGI__SCANWHILE_UNROLL(X)   { for (;;) { char_t ss = s[0]; if (PUGI__UNLIKELY(!(X))) { break; } ss = s[1]; if (PUGI__UNLIKELY(!(X))) { s += 1; break; } ss = s[2]; if (PUGI__UNLIKELY(!(X))) { s += 2; break; } ss = s[3]; if (PUGI__UNLIKELY(!(X))) { s += 3; break; } s += 4; } }
+#ifdef PUGI__SIMD
+	#define PUGI__SCANFOR_CHARTYPE(ct)  { s = simd_scan_chartype<ct>(s); }
+#else
+	#define PUGI__SCANFOR_CHARTYPE(ct)  PUGI__SCANWHILE_UNROLL(!PUGI__IS_CHARTYPE(ss, ct))
+#endif
 	#define PUGI__ENDSEG()              { ch = *s; *s = 0; ++s; }
 	#define PUGI__THROW_ERROR(err, m)   return error_offset = m, error_status = err, static_cast<char_t*>(0)
 	#define PUGI__CHECK_ERROR(err, m)   { if (*s == 0) PUGI__THROW_ERROR(err, m); }
@@ -1998,7 +2631,7 @@ PUGI__NS_BEGIN
 		
 		while (true)
 		{
-			PUGI__SCANWHILE_UNROLL(!PUGI__IS_CHARTYPE(ss, ct_parse_comment));
+			PUGI__SCANFOR_CHARTYPE(ct_parse_comment);
 		
 			if (*s == '\r') // Either a single 0x0d or 0x0d 0x0a pair
 			{
@@ -2026,7 +2659,7 @@ PUGI__NS_BEGIN
 			
 		while (true)
 		{
-			PUGI__SCANWHILE_UNROLL(!PUGI__IS_CHARTYPE(ss, ct_parse_cdata));
+			PUGI__SCANFOR_CHARTYPE(ct_parse_cdata);
 			
 			if (*s == '\r') // Either a single 0x0d or 0x0d 0x0a pair
 			{
@@ -2060,7 +2693,7 @@ PUGI__NS_BEGIN
 
 			while (true)
 			{
-				PUGI__SCANWHILE_UNROLL(!PUGI__IS_CHARTYPE(ss, ct_parse_pcdata));
+				PUGI__SCANFOR_CHARTYPE(ct_parse_pcdata);
 
 				if (*s == '<') // PCDATA ends here
 				{
@@ -2140,7 +2773,7 @@ PUGI__NS_BEGIN
 
 			while (true)
 			{
-				PUGI__SCANWHILE_UNROLL(!PUGI__IS_CHARTYPE(ss, ct_parse_attr_ws | ct_space));
+				PUGI__SCANFOR_CHARTYPE(ct_parse_attr_ws | ct_space);
 				
 				if (*s == end_quote)
 				{
@@ -2181,7 +2814,7 @@ PUGI__NS_BEGIN
 
 			while (true)
 			{
-				PUGI__SCANWHILE_UNROLL(!PUGI__IS_CHARTYPE(ss, ct_parse_attr_ws));
+				PUGI__SCANFOR_CHARTYPE(ct_parse_attr_ws);
 				
 				if (*s == end_quote)
 				{
@@ -2217,7 +2850,7 @@ PUGI__NS_BEGIN
 
 			while (true)
 			{
-				PUGI__SCANWHILE_UNROLL(!PUGI__IS_CHARTYPE(ss, ct_parse_attr));
+				PUGI__SCANFOR_CHARTYPE(ct_parse_attr);
 				
 				if (*s == end_quote)
 				{
@@ -2249,7 +2882,7 @@ PUGI__NS_BEGIN
 
 			while (true)
 			{
-				PUGI__SCANWHILE_UNROLL(!PUGI__IS_CHARTYPE(ss, ct_parse_attr));
+				PUGI__SCANFOR_CHARTYPE(ct_parse_attr);
 				
 				if (*s == end_quote)
 				{
@@ -2307,11 +2940,15 @@ PUGI__NS_BEGIN
 
 	struct xml_parser
 	{
+	#ifdef PUGIXML_COMPACT
+		xml_allocator& alloc; // a local copy would not share the far pointer table with the document
+	#else
 		xml_allocator alloc;
+	#endif
 		char_t* error_offset;
 		xml_parse_status error_status;
 		
-		xml_parser(const xml_allocator& alloc_): alloc(alloc_), error_offset(0), error_status(status_ok)
+		xml_parser(xml_allocator& alloc_): alloc(alloc_), error_offset(0), error_status(status_ok)
 		{
 		}
 
@@ -2348,7 +2985,7 @@ PUGI__NS_BEGIN
 				PUGI__SCANFOR(s[0] == '-' && s[1] == '-' && s[2] == '>'); // no need for ENDSWITH because --> can't terminate proper doctype
 				if (!*s) PUGI__THROW_ERROR(status_bad_doctype, s);
 
-				s += 4;
+				s += 3;
 			}
 			else PUGI__THROW_ERROR(status_bad_doctype, s);
 
@@ -2890,7 +3527,7 @@ PUGI__NS_BEGIN
 				return make_parse_result(PUGI__OPTSET(parse_fragment) ? status_ok : status_no_document_element);
 
 			// get last child of the root before parsing
-			xml_node_struct* last_root_child = root->first_child ? root->first_child->prev_sibling_c : 0;
+			xml_node_struct* last_root_child = root->first_child ? root->first_child->prev_sibling_c + 0 : 0;
 	
 			// create parser on stack
 			xml_parser parser(alloc_);
@@ -2905,8 +3542,10 @@ PUGI__NS_BEGIN
 			// perform actual parsing
 			parser.parse_tree(buffer_data, root, optmsk, endch);
 
+		#ifndef PUGIXML_COMPACT
 			// update allocator state
 			alloc_ = parser.alloc;
+		#endif
 
 			xml_parse_result result = make_parse_result(parser.error_status, parser.error_offset ? parser.error_offset - buffer : 0);
 			assert(result.offset >= 0 && static_cast<size_t>(result.offset) <= length);
@@ -3105,6 +3744,18 @@ PUGI__NS_BEGIN
 		xml_buffered_writer(xml_writer& writer_, xml_encoding user_encoding): writer(writer_), bufsize(0), encoding(get_write_encoding(user_encoding))
 		{
 			PUGI__STATIC_ASSERT(bufcapacity >= 8);
+
+			// without conversion the scratch space is not needed, so the whole storage holds output and the writer gets larger blocks
+			if (encoding == get_write_native_encoding())
+			{
+				buffer = storage.data_native;
+				capacity = bufcapacitynative;
+			}
+			else
+			{
+				buffer = storage.converted.data_char;
+				capacity = bufcapacity;
+			}
 		}
 
 		~xml_buffered_writer()
@@ -3129,11 +3780,11 @@ PUGI__NS_BEGIN
 			else
 			{
 				// convert chunk
-				size_t result = convert_buffer_output(scratch.data_char, scratch.data_u8, scratch.data_u16, scratch.data_u32, data, size, encoding);
-				assert(result <= sizeof(scratch));
+				size_t result = convert_buffer_output(scratch().data_char, scratch().data_u8, scratch().data_u16, scratch().data_u32, data, size, encoding);
+				assert(result <= sizeof(scratch()));
 
 				// write data
-				writer.write(scratch.data_u8, result);
+				writer.write(scratch().data_u8, result);
 			}
 		}
 
@@ -3143,7 +3794,7 @@ PUGI__NS_BEGIN
 			flush();
 
 			// handle large chunks
-			if (length > bufcapacity)
+			if (length > capacity)
 			{
 				if (encoding == get_write_native_encoding())
 				{
@@ -3180,7 +3831,7 @@ PUGI__NS_BEGIN
 		{
 			size_t offset = bufsize;
 
-			if (offset + length <= bufcapacity)
+			if (offset + length <= capacity)
 			{
 				memcpy(buffer + offset, data, length * sizeof(char_t));
 				bufsize = offset + length;
@@ -3196,11 +3847,11 @@ PUGI__NS_BEGIN
 			// write the part of the string that fits in the buffer
 			size_t offset = bufsize;
 
-			while (*data && offset < bufcapacity)
+			while (*data && offset < capacity)
 				buffer[offset++] = *data++;
 
 			// write the rest
-			if (offset < bufcapacity)
+			if (offset < capacity)
 			{
 				bufsize = offset;
 			}
@@ -3219,7 +3870,7 @@ PUGI__NS_BEGIN
 		void write(char_t d0)
 		{
 			size_t offset = bufsize;
-			if (offset > bufcapacity - 1) offset = flush();
+			if (offset > capacity - 1) offset = flush();
 
 			buffer[offset + 0] = d0;
 			bufsize = offset + 1;
@@ -3228,7 +3879,7 @@ PUGI__NS_BEGIN
 		void write(char_t d0, char_t d1)
 		{
 			size_t offset = bufsize;
-			if (offset > bufcapacity - 2) offset = flush();
+			if (offset > capacity - 2) offset = flush();
 
 			buffer[offset + 0] = d0;
 			buffer[offset + 1] = d1;
@@ -3238,7 +3889,7 @@ PUGI__NS_BEGIN
 		void write(char_t d0, char_t d1, char_t d2)
 		{
 			size_t offset = bufsize;
-			if (offset > bufcapacity - 3) offset = flush();
+			if (offset > capacity - 3) offset = flush();
 
 			buffer[offset + 0] = d0;
 			buffer[offset + 1] = d1;
@@ -3249,7 +3900,7 @@ PUGI__NS_BEGIN
 		void write(char_t d0, char_t d1, char_t d2, char_t d3)
 		{
 			size_t offset = bufsize;
-			if (offset > bufcapacity - 4) offset = flush();
+			if (offset > capacity - 4) offset = flush();
 
 			buffer[offset + 0] = d0;
 			buffer[offset + 1] = d1;
@@ -3261,7 +3912,7 @@ PUGI__NS_BEGIN
 		void write(char_t d0, char_t d1, char_t d2, char_t d3, char_t d4)
 		{
 			size_t offset = bufsize;
-			if (offset > bufcapacity - 5) offset = flush();
+			if (offset > capacity - 5) offset = flush();
 
 			buffer[offset + 0] = d0;
 			buffer[offset + 1] = d1;
@@ -3274,7 +3925,7 @@ PUGI__NS_BEGIN
 		void write(char_t d0, char_t d1, char_t d2, char_t d3, char_t d4, char_t d5)
 		{
 			size_t offset = bufsize;
-			if (offset > bufcapacity - 6) offset = flush();
+			if (offset > capacity - 6) offset = flush();
 
 			buffer[offset + 0] = d0;
 			buffer[offset + 1] = d1;
@@ -3297,18 +3948,36 @@ PUGI__NS_BEGIN
 				10240
 			#endif
 			,
-			bufcapacity = bufcapacitybytes / (sizeof(char_t) + 4)
+			bufcapacity = bufcapacitybytes / (sizeof(char_t) + 4),
+			bufcapacitynative = bufcapacitybytes / sizeof(char_t)
 		};
 
-		char_t buffer[bufcapacity];
-
-		union
+		union scratch_t
 		{
 			uint8_t data_u8[4 * bufcapacity];
 			uint16_t data_u16[2 * bufcapacity];
 			uint32_t data_u32[bufcapacity];
 			char_t data_char[bufcapacity];
-		} scratch;
+		};
+
+		union
+		{
+			char_t data_native[bufcapacitynative];
+
+			struct
+			{
+				char_t data_char[bufcapacity];
+				scratch_t scratch;
+			} converted;
+		} storage;
+
+		scratch_t& scratch()
+		{
+			return storage.converted.scratch;
+		}
+
+		char_t* buffer;
+		size_t capacity;
 
 		xml_writer& writer;
 		size_t bufsize;
@@ -3321,9 +3990,28 @@ PUGI__NS_BEGIN
 		{
 			const char_t* prev = s;
 			
+		#ifdef PUGI__SIMD
+			// most attribute values are shorter than a block, and a scalar scan is cheaper for those
+			for (int group = 0; ; ++group)
+			{
+				if (PUGI__IS_CHARTYPEX(s[0], type)) break;
+				if (PUGI__IS_CHARTYPEX(s[1], type)) { s += 1; break; }
+				if (PUGI__IS_CHARTYPEX(s[2], type)) { s += 2; break; }
+				if (PUGI__IS_CHARTYPEX(s[3], type)) { s += 3; break; }
+
+				s += 4;
+
+				if (group == 3)
+				{
+					s = (type == ctx_special_attr) ? simd_scan_chartypex<ctx_special_attr>(s) : simd_scan_chartypex<ctx_special_pcdata>(s);
+					break;
+				}
+			}
+		#else
 			// While *s is a usual symbol
 			PUGI__SCANWHILE_UNROLL(!PUGI__IS_CHARTYPEX(ss, type));
-		
+		#endif
+
 			writer.write_buffer(prev, static_cast<size_t>(s - prev));
 
 			switch (*s)
@@ -3720,7 +4408,7 @@ PUGI__NS_BEGIN
 		return true;
 	}
 
-	PUGI__FN void node_copy_string(char_t*& dest, uintptr_t& header, uintptr_t header_mask, char_t* source, uintptr_t& source_header, xml_allocator* alloc)
+	template <typename Header> PUGI__FN void node_copy_string(char_t*& dest, Header& header, uintptr_t header_mask, char_t* source, Header& source_header, xml_allocator* alloc)
 	{
 		assert(!dest && (header & header_mask) == 0);
 
@@ -3809,65 +4497,279 @@ PUGI__NS_BEGIN
 	}
 
 	// get value with conversion functions
-	PUGI__FN int get_integer_base(const char_t* value)
+	template <typename U> PUGI__FN U string_to_integer(const char_t* value, U minneg, U maxpos)
 	{
+		U result = 0;
 		const char_t* s = value;
 
 		while (PUGI__IS_CHARTYPE(*s, ct_space))
 			s++;
 
-		if (*s == '-')
-			s++;
+		bool negative = (*s == '-');
+
+		s += (*s == '+' || *s == '-');
+
+		bool overflow = false;
+
+		if (s[0] == '0' && (s[1] | ' ') == 'x')
+		{
+			s += 2;
+
+			// since overflow detection relies on length of the sequence skip leading zeros
+			while (*s == '0')
+				s++;
+
+			const char_t* start = s;
+
+			for (;;)
+			{
+				if (static_cast<unsigned>(*s - '0') < 10)
+					result = result * 16 + static_cast<U>(*s - '0');
+				else if (static_cast<unsigned>((*s | ' ') - 'a') < 6)
+					result = result * 16 + static_cast<U>((*s | ' ') - 'a' + 10);
+				else
+					break;
+
+				s++;
+			}
+
+			size_t digits = static_cast<size_t>(s - start);
+
+			overflow = digits > sizeof(U) * 2;
+		}
+		else
+		{
+			// since overflow detection relies on length of the sequence skip leading zeros
+			while (*s == '0')
+				s++;
+
+			const char_t* start = s;
+
+			for (;;)
+			{
+				if (static_cast<unsigned>(*s - '0') < 10)
+					result = result * 10 + static_cast<U>(*s - '0');
+				else
+					break;
+
+				s++;
+			}
+
+			size_t digits = static_cast<size_t>(s - start);
 
-		return (s[0] == '0' && (s[1] == 'x' || s[1] == 'X')) ? 16 : 10;
+			PUGI__STATIC_ASSERT(sizeof(U) == 8 || sizeof(U) == 4 || sizeof(U) == 2);
+
+			const size_t max_digits10 = sizeof(U) == 8 ? 20 : sizeof(U) == 4 ? 10 : 5;
+			const char_t max_lead = sizeof(U) == 8 ? '1' : sizeof(U) == 4 ? '4' : '6';
+			const size_t high_bit = sizeof(U) * 8 - 1;
+
+			// a number with the maximum digit count overflows unless it starts low enough; with the top digit equal, wraparound clears the high bit
+			overflow = digits >= max_digits10 && !(digits == max_digits10 && (*start < max_lead || (*start == max_lead && result >> high_bit)));
+		}
+
+		// out of range values saturate instead of wrapping around
+		if (negative)
+			return (overflow || result > minneg) ? 0 - minneg : 0 - result;
+		else
+			return (overflow || result > maxpos) ? maxpos : result;
 	}
 
-	PUGI__FN int get_value_int(const char_t* value, int def)
+	// Parses a decimal number with at most 15 significant digits and a small exponent the way strtod would: both the digits and
+	// the power of ten are exact doubles then, so the one multiply or divide rounds correctly (Clinger's fast path).
+	// Returns false for anything else (more digits, large exponents, hex, inf/nan, no digits), which is left to strtod.
+	PUGI__FN bool string_to_double_fast(const char_t* value, double& out_result)
 	{
-		if (!value) return def;
+	#ifdef PUGI__EXACT_DOUBLE
+		static const double powers_of_ten[] =
+		{
+			1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+			1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+		};
 
-		int base = get_integer_base(value);
+		const int max_digits = 15;
+		const int max_power = 22;
 
-	#ifdef PUGIXML_WCHAR_MODE
-		return static_cast<int>(wcstol(value, 0, base));
+		const char_t* s = value;
+
+		while (PUGI__IS_CHARTYPE(*s, ct_space))
+			s++;
+
+		bool negative = (*s == '-');
+
+		s += (*s == '+' || *s == '-');
+
+		// hexadecimal floats
+		if (s[0] == '0' && (s[1] | ' ') == 'x') return false;
+
+		double mantissa = 0;
+		int digits = 0;
+		int exponent = 0;
+		bool any = false;
+
+		// leading zeros are not significant
+		while (*s == '0')
+		{
+			s++;
+			any = true;
+		}
+
+		for (; static_cast<unsigned>(*s - '0') < 10; ++s)
+		{
+			if (digits == max_digits) return false;
+
+			mantissa = mantissa * 10 + (*s - '0');
+			digits++;
+			any = true;
+		}
+
+		if (*s == '.')
+		{
+			s++;
+
+			if (digits == 0)
+			{
+				for (; *s == '0'; ++s)
+				{
+					exponent--;
+					any = true;
+				}
+			}
+
+			for (; static_cast<unsigned>(*s - '0') < 10; ++s)
+			{
+				if (digits == max_digits) return false;
+
+				mantissa = mantissa * 10 + (*s - '0');
+				digits++;
+				exponent--;
+				any = true;
+			}
+		}
+
+		if (!any) return false;
+
+		// an exponent only counts with at least one digit, like in strtod
+		if ((*s | ' ') == 'e')
+		{
+			const char_t* e = s + 1;
+
+			bool exponent_negative = (*e == '-');
+
+			e += (*e == '+' || *e == '-');
+
+			if (static_cast<unsigned>(*e - '0') < 10)
+			{
+				int value_exponent = 0;
+
+				for (; static_cast<unsigned>(*e - '0') < 10; ++e)
+				{
+					if (value_exponent > 1000) return false;
+
+					value_exponent = value_exponent * 10 + (*e - '0');
+				}
+
+				exponent += exponent_negative ? -value_exponent : value_exponent;
+			}
+		}
+
+		if (mantissa == 0)
+		{
+			out_result = negative ? -0.0 : 0.0;
+			return true;
+		}
+
+		// 123e25 is 123000e22, which is still exact
+		if (exponent > max_power && digits + exponent - max_power <= max_digits)
+		{
+			mantissa *= powers_of_ten[exponent - max_power];
+			exponent = max_power;
+		}
+
+		if (exponent > max_power || exponent < -max_power) return false;
+
+		double result = (exponent < 0) ? mantissa / powers_of_ten[-exponent] : mantissa * powers_of_ten[exponent];
+
+		out_result = negative ? -result : result;
+		return true;
 	#else
-		return static_cast<int>(strtol(value, 0, base));
+		// with extended precision intermediates the fast path would round twice
+		(void)value;
+		(void)out_result;
+
+		return false;
 	#endif
 	}
 
-	PUGI__FN unsigned int get_value_uint(const char_t* value, unsigned int def)
+	PUGI__FN double string_to_double(const char_t* value)
 	{
-		if (!value) return def;
+		double result;
+		if (string_to_double_fast(value, result)) return result;
+
+		// strtod expects the decimal point of the current locale, so hand it the number with that one in place of '.'
+		char_t point = static_cast<char_t>(*localeconv()->decimal_point);
+
+		if (point == '.')
+		{
+		#ifdef PUGIXML_WCHAR_MODE
+			return wcstod(value, 0);
+		#else
+			return strtod(value, 0);
+		#endif
+		}
+
+		char_t buffer[128];
+		size_t length = 0;
+
+		const char_t* s = value;
 
-		int base = get_integer_base(value);
+		while (PUGI__IS_CHARTYPE(*s, ct_space))
+			s++;
+
+		for (; length + 1 < sizeof(buffer) / sizeof(buffer[0]); ++length, ++s)
+		{
+			char_t ch = *s;
+
+			if (ch == '.') ch = point;
+			else if (!(static_cast<unsigned>(ch - '0') < 10 || static_cast<unsigned>((ch | ' ') - 'a') < 26 || ch == '+' || ch == '-')) break;
+
+			buffer[length] = ch;
+		}
+
+		buffer[length] = 0;
 
 	#ifdef PUGIXML_WCHAR_MODE
-		return static_cast<unsigned int>(wcstoul(value, 0, base));
+		return wcstod(buffer, 0);
 	#else
-		return static_cast<unsigned int>(strtoul(value, 0, base));
+		return strtod(buffer, 0);
 	#endif
 	}
 
+	PUGI__FN int get_value_int(const char_t* value, int def)
+	{
+		if (!value) return def;
+
+		return static_cast<int>(string_to_integer<unsigned int>(value, 0 - static_cast<unsigned int>(INT_MIN), INT_MAX));
+	}
+
+	PUGI__FN unsigned int get_value_uint(const char_t* value, unsigned int def)
+	{
+		if (!value) return def;
+
+		return string_to_integer<unsigned int>(value, 0, UINT_MAX);
+	}
+
 	PUGI__FN double get_value_double(const char_t* value, double def)
 	{
 		if (!value) return def;
 
-	#ifdef PUGIXML_WCHAR_MODE
-		return wcstod(value, 0);
-	#else
-		return strtod(value, 0);
-	#endif
+		return string_to_double(value);
 	}
 
 	PUGI__FN float get_value_float(const char_t* value, float def)
 	{
 		if (!value) return def;
 
-	#ifdef PUGIXML_WCHAR_MODE
-		return static_cast<float>(wcstod(value, 0));
-	#else
-		return static_cast<float>(strtod(value, 0));
-	#endif
+		return static_cast<float>(string_to_double(value));
 	}
 
 	PUGI__FN bool get_value_bool(const char_t* value, bool def)
@@ -3886,103 +4788,760 @@ PUGI__NS_BEGIN
 	{
 		if (!value) return def;
 
-		int base = get_integer_base(value);
-
-	#ifdef PUGIXML_WCHAR_MODE
-		#ifdef PUGI__MSVC_CRT_VERSION
-			return _wcstoi64(value, 0, base);
-		#else
-			return wcstoll(value, 0, base);
-		#endif
-	#else
-		#ifdef PUGI__MSVC_CRT_VERSION
-			return _strtoi64(value, 0, base);
-		#else
-			return strtoll(value, 0, base);
-		#endif
-	#endif
+		return static_cast<long long>(string_to_integer<unsigned long long>(value, 0 - static_cast<unsigned long long>(LLONG_MIN), LLONG_MAX));
 	}
 
 	PUGI__FN unsigned long long get_value_ullong(const char_t* value, unsigned long long def)
 	{
 		if (!value) return def;
 
-		int base = get_integer_base(value);
-
-	#ifdef PUGIXML_WCHAR_MODE
-		#ifdef PUGI__MSVC_CRT_VERSION
-			return _wcstoui64(value, 0, base);
-		#else
-			return wcstoull(value, 0, base);
-		#endif
-	#else
-		#ifdef PUGI__MSVC_CRT_VERSION
-			return _strtoui64(value, 0, base);
-		#else
-			return strtoull(value, 0, base);
-		#endif
-	#endif
+		return string_to_integer<unsigned long long>(value, 0, ULLONG_MAX);
 	}
 #endif
 
-	// set value with conversion functions
-	PUGI__FN bool set_value_buffer(char_t*& dest, uintptr_t& header, uintptr_t header_mask, char (&buf)[128])
+	template <typename U> PUGI__FN char_t* integer_to_string(char_t* begin, char_t* end, U value, bool negative)
 	{
-	#ifdef PUGIXML_WCHAR_MODE
-		char_t wbuf[128];
-		impl::widen_ascii(wbuf, buf);
+		char_t* result = end - 1;
+		U rest = negative ? 0 - value : value;
 
-		return strcpy_insitu(dest, header, header_mask, wbuf);
-	#else
-		return strcpy_insitu(dest, header, header_mask, buf);
-	#endif
-	}
+		do
+		{
+			*result-- = static_cast<char_t>('0' + (rest % 10));
+			rest /= 10;
+		}
+		while (rest);
+
+		assert(result >= begin);
+		(void)begin;
+
+		*result = '-';
+
+		return result + !negative;
+	}
+
+	// Shortest round-trip formatting uses Schubfach (R. Giulietti, "The Schubfach way to render doubles", 2020): the value is
+	// scaled by a power of ten with a few 64-bit multiplications, and of the decimals inside its rounding interval the one
+	// with the fewest digits is picked, the closest one if there are two.
+
+	// g(k) = floor(10^-k 2^-r) + 1 for k in [-324, 292], where r makes 2^125 <= g(k) < 2^126, split into the high and low
+	// 63 bits. Generated with exact rational arithmetic; floats use the high half only.
+	static const uint64_t schubfach_table[617][2] =
+	{
+		{0x4f0cedc95a718dd4, 0x5b01e8b09aa0d1b5}, {0x7e7b160ef71c1621, 0x119ca780f767b5ee},
+		{0x652f44d8c5b011b4, 0x0e16ec672c52f7f2}, {0x50f29d7a37c00e29, 0x581256b8f0425ff5},
+		{0x40c21794f96671ba, 0x79a84560c0351991}, {0x679cf287f570b5f7, 0x75da089acd21c281},
+		{0x52e3f5399126f7f9, 0x44ae6d48a41b0201}, {0x424ff76140ebf994, 0x36f1f106e9af34cd},
+		{0x6a198bcece465c20, 0x57e981a4a918547b}, {0x54e13ca571d1e34d, 0x2cbace1d541376c9},
+		{0x43e763b78e4182a4, 0x23c8a4e44342c56e}, {0x6ca56c58e39c043a, 0x060dd4a06b9e08b0},
+		{0x56eabd13e9499cfb, 0x1e7176e6bc7e6d59}, {0x458897432107b0c8, 0x7ec12bebc9febde1},
+		{0x6f40f20501a5e7a7, 0x7e01dfdfa9979635}, {0x5900c19d9aeb1fb9, 0x4b34b319547944f7},
+		{0x4733ce17af227fc7, 0x55c3c27aa9fa9d93}, {0x71ec7cf2b1d0cc72, 0x560603f7765dc8ea},
+		{0x5b2397288e40a38e, 0x7804cff92b7e3a55}, {0x48e945ba0b66e93f, 0x13370cc755fe9511},
+		{0x74a86f90123e41fe, 0x51f1ae0bbcca881b}, {0x5d538c7341cb67fe, 0x74c1580963d539af},
+		{0x4aa93d29016f8665, 0x43cde0078310faf3}, {0x77752ea8024c0a3c, 0x0616333f381b2b1e},
+		{0x5f90f22001d66e96, 0x3811c298f9af55b1}, {0x4c73f4e667debede, 0x600e35472e25de28},
+		{0x7a532170a6313164, 0x3349eed849d6303f}, {0x61dc1ac084f42783, 0x42a18be03b11c033},
+		{0x4e49af006a5cec69, 0x1bb46fe695a7ccf5}, {0x7d42b19a43c7e0a8, 0x2c53e63dbc3fae55},
+		{0x64355ae1cfd31a20, 0x237651cafcffbeaa}, {0x502aaf1b0ca8e1b3, 0x35f8416f30cc9888},
+		{0x402225af3d53e7c2, 0x5e603458f3d6e06d}, {0x669d0918621fd937, 0x4a3386f4b957cd7b},
+		{0x52173a79e8197a92, 0x6e8f9f2a2ddfd796}, {0x41ac2ec7ece12edb, 0x720c7f54f17fdfab},
+		{0x69137e0cae3517c6, 0x1ce0cbbb1bffcc45}, {0x540f980a24f74638, 0x171a3c95afffd69e},
+		{0x433facd4ea5f6b60, 0x127b63aaf3331218}, {0x6b991487dd657899, 0x6a5f05de51eb5026},
+		{0x5614106cb11dfa14, 0x5518d17ea7ef7352}, {0x44dcd9f08db194dd, 0x2a7a41321ff2c2a8},
+		{0x6e2e2980e2b5bafb, 0x5d906850331e043f}, {0x5824ee00b55e2f2f, 0x647386a68f4b3699},
+		{0x4683f19a2ab1bf59, 0x36c2d21ed908f87b}, {0x70d31c29dde93228, 0x579e1cfe280e5a5d},
+		{0x5a427cee4b20f4ed, 0x2c7e7d98200b7b7e}, {0x483530bea280c3f1, 0x09fecae019a2c932},
+		{0x73884dfdd0ce064e, 0x43314499c29e0eb6}, {0x5c6d0b3173d8050b, 0x4f5a9d47cee4d891},
+		{0x49f0d5c129799da2, 0x72aee4397250ad41}, {0x764e22cea8c295d1, 0x377e39f583b44868},
+		{0x5ea4e8a553cede41, 0x12cb61913629d387}, {0x4bb72084430be500, 0x756f8140f8217605},
+		{0x792500d39e796e67, 0x6f18cece59cf233c}, {0x60ea670fb1fabeb9, 0x3f470bd847d8e8fd},
+		{0x4d885272f4c89894, 0x329f3cad064720ca}, {0x7c0d50b7ee0dc0ed, 0x37652de1a3a50143},
+		{0x633dda2cbe716724, 0x2c50f1814fb73436}, {0x4f64ae8a31f45283, 0x3d0d8e010c92902b},
+		{0x7f077da9e986ea6b, 0x7b48e334e0ea8045}, {0x659f97bb2138bb89, 0x49071c2a4d88669d},
+		{0x514c796280fa2fa1, 0x20d27ceea46d1ee4}, {0x4109fab533fb594d, 0x670eca58838a7f1d},
+		{0x680ff788532bc216, 0x0b4add5a6c10cb62}, {0x533ff939dc2301ab, 0x22a24aaebcda3c4e},
+		{0x4299942e49b59aef, 0x354ea22563e1c9d8}, {0x6a8f537d42bc2b18, 0x554a9d089fcfa95a},
+		{0x553f75fdcefcef46, 0x776ee406e63fbaae}, {0x4432c4cb0bfd8c38, 0x5f8be99f1e996225},
+		{0x6d1e07ab466279f4, 0x327975cb64289d08}, {0x574b3955d1e86190, 0x28612b091ced4a6d},
+		{0x45d5c777db204e0d, 0x06b4226db0bdd524}, {0x6fbc72595e9a167b, 0x24536a491ac95506},
+		{0x59638eade54811fc, 0x1d0f883a7bd44405}, {0x4782d88b1dd34196, 0x4a72d361fca9d004},
+		{0x726af411c952028a, 0x43eaebcffaa94cd3}, {0x5b88c3416ddb353b, 0x4fef230cc88770a9},
+		{0x493a35cdf17c2a96, 0x0cbf4f3d6d3926ee}, {0x7529efafe8c6aa89, 0x61321862485b717c},
+		{0x5dbb262653d22207, 0x675b46b506af8dfd}, {0x4afc1e850fdb4e6c, 0x52af6bc405593e64},
+		{0x77f9ca6e7fc54a47, 0x377f12d33bc1fd6d}, {0x5ffb085866376e9f, 0x45ff42429634cabd},
+		{0x4cc8d379eb5f8bb2, 0x6b329b68782a3bcb}, {0x7adaebf64565ac51, 0x2b842bda59dd2c77},
+		{0x6248bcc5045156a7, 0x3c69bcaeae4a89f9}, {0x4ea0970403744552, 0x6387ca25583ba194},
+		{0x7dcdbe6cd253a21e, 0x05a6103bc05f68ed}, {0x64a498570ea94e7e, 0x37b80cfc99e5ed8a},
+		{0x5083ad1272210b98, 0x2c933d96e184be08}, {0x40695741f4e73c79, 0x7075cadf1ad09807},
+		{0x670ef2032171fa5c, 0x4d8944982ae759a4}, {0x52725b35b45b2eb0, 0x3e076a135585e150},
+		{0x41f515c49048f226, 0x64d2bb42aad1810d}, {0x698822d41a0e503e, 0x07b7920444826815},
+		{0x546ce8a9ae71d9cb, 0x1fc60e69d0685344}, {0x438a53baf1f4ae3c, 0x196b3ebb0d20429d},
+		{0x6c1085f7e9877d2d, 0x0f11fdf815006a94}, {0x56739e5fee05fdbd, 0x58db319344005543},
+		{0x45294b7ff19e6497, 0x60af5adc3666aa9c}, {0x6ea878ccb5ca3a8c, 0x344bc4938a3dddc7},
+		{0x5886c70a2b082ed6, 0x5d096a0fa1cb17d2}, {0x46d238d4ef39bf12, 0x173abb3fb4a27975},
+		{0x71505aee4b8f981d, 0x0b912b992103f588}, {0x5aa6af25093face4, 0x0940efadb4032ad3},
+		{0x488558ea6dcc8a50, 0x07672624900288a9}, {0x74088e43e2e0dd4c, 0x723ea36db337410e},
+		{0x5cd3a5031be71770, 0x5b654f8af5c5cda5}, {0x4a42ea68e31f45f3, 0x62b772d5916b0aeb},
+		{0x76d1770e38320986, 0x0458b7bc1bde77dd}, {0x5f0df8d82cf4d46b, 0x1d13c630164b9318},
+		{0x4c0b2d79bd90a9ef, 0x30dc9e8cdea2dc13}, {0x79ab7bf5fc1aa97f, 0x0160fdae31049351},
+		{0x6155fcc4c9aeedff, 0x1ab3fe24f403a90e}, {0x4dde63d0a158be65, 0x6229981d9002eda5},
+		{0x7c97061a9bc130a2, 0x69dc2695b337e2a1}, {0x63ac04e2163426e8, 0x54b01ede28f9821b},
+		{0x4fbcd0b4de901f20, 0x43c018b1ba6134e2}, {0x7f9481216419cb67, 0x1f99c11c5d68549d},
+		{0x6610674de9ae3c52, 0x4c7b00e37ded107e}, {0x51a6b90b21583042, 0x09fc00b5fe574065},
+		{0x41522da2811359ce, 0x3b3000919845cd1d}, {0x68837c3734ebc2e3, 0x784ccdb5c06fae95},
+		{0x539c635f5d8968b6, 0x2d0a3e2b00595877}, {0x42e382b2b13aba2b, 0x3da1cb5599e11393},
+		{0x6b059deab52ac378, 0x629c7888f634ec1e}, {0x559e17eef755692d, 0x3549fa072b5d89b1},
+		{0x447e798bf91120f1, 0x1107fb38ef7e07c1}, {0x6d9728dff4e834b5, 0x01a65ec17f300c68},
+		{0x57ac20b32a535d5d, 0x4e1eb23465c009ed}, {0x46234d5c21dc4ab1, 0x24e55b5d1e333b24},
+		{0x70387bc69c93aab5, 0x216ef894fd1ec506}, {0x59c6c96bb076222a, 0x4df2607730e56a6c},
+		{0x47d23abc8d2b4e88, 0x3e5b805f5a5121f0}, {0x72e9f79415121740, 0x63c59a322a1b697f},
+		{0x5bee5fa9aa74df67, 0x03047b5b54e2bacc}, {0x498b7fbaeec3e5ec, 0x0269fc4910b5623d},
+		{0x75abff917e063cac, 0x6a432d41b45569fb}, {0x5e2332dacb38308a, 0x21cf5767c37787fc},
+		{0x4b4f5be23c2cf3a1, 0x67d912b9692c6cca}, {0x787ef969f9e185cf, 0x595b5128a8471476},
+		{0x60659454c7e79e3f, 0x6115da86ed05a9f8}, {0x4d1e1043d31fb1cc, 0x4dab1538bd9e2193},
+		{0x7b634d3951cc4fad, 0x62ab552795c9cf52}, {0x62b5d7610e3d0c8b, 0x0222aa86116e3f75},
+		{0x4ef7df80d830d6d5, 0x4e822204dabe992a}, {0x7e59659af38157bc, 0x17369cd49130f510},
+		{0x65145148c2cddfc9, 0x5f5ee3dd40f3f740}, {0x50dd0dd3cf0b196e, 0x1918b64a9a5cc5cd},
+		{0x40b0d7dca5a27abe, 0x4746f83baeb09e3e}, {0x678159610903f797, 0x253e59f91780fd2f},
+		{0x52cde11a6d9cc612, 0x50feae60df9a6426}, {0x423e4daebe1704db, 0x5a65584d7faeb685},
+		{0x69fd4917968b3af9, 0x10a226e265e4573b}, {0x54caa0dfaba29594, 0x0d4e8581eb1d1295},
+		{0x43d54d7fbc821143, 0x243ed134bc174211}, {0x6c887bff94034ed2, 0x06cae85460253682},
+		{0x56d396661002a574, 0x6bd586a9e6842b9b}, {0x457611eb40021df7, 0x09779eee52035616},
+		{0x6f234fdeccd02ff1, 0x5bf297e3b66bbcef}, {0x58e90cb23d73598e, 0x165bacb62b8963f3},
+		{0x4720d6f4fdf5e13e, 0x451623c4efa11cc2}, {0x71ce24bb2fefceca, 0x3b569fa17f682e03},
+		{0x5b0b5095bff30bd5, 0x15dee61acc535803}, {0x48d5da11665c0977, 0x2b18b8157042accf},
+		{0x74895ce8a3c6758b, 0x5e8df355806aae18}, {0x5d3ab0ba1c9ec46f, 0x653e5c4466bbbe7a},
+		{0x4a955a2e7d4bd059, 0x3765169d1efc9861}, {0x77555d172edfb3c2, 0x256e8a94fe60f3cf},
+		{0x5f777dac257fc301, 0x6abed543feb3f63f}, {0x4c5f97bceacc9c01, 0x3bcbddcffef65e99},
+		{0x7a328c6177adc668, 0x5fac961997f0975b}, {0x61c209e792f16b86, 0x7fbd44e1465a12af},
+		{0x4e34d4b9425abc6b, 0x7fca9d810514dbbf}, {0x7d21545b9d5dfa46, 0x32ddc8ce6e87c5ff},
+		{0x641aa9e2e44b2e9e, 0x5be4a0a525396b32}, {0x501554b5836f587e, 0x7cb6e6ea842def5c},
+		{0x4011109135f2ad32, 0x30925255368b25e3}, {0x6681b41b89844850, 0x4db6ea21f0dea304},
+		{0x52015ce2d469d373, 0x57c5881b2718826a}, {0x419ab0b576bb0f8f, 0x5fd139af527a01ef},
+		{0x68f781225791b27f, 0x4c81f5e550c3364a}, {0x53f9341b79415b99, 0x239b2b1dda35c508},
+		{0x432dc3492dcde2e1, 0x02e288e4ae916a6d}, {0x6b7c6ba849496b01, 0x516a74a1174f10ae},
+		{0x55fd22ed076def34, 0x4121f6e745d8da25}, {0x44ca82573924bf5d, 0x1a8192529e4714eb},
+		{0x6e10d08b8ea1322e, 0x5d9c1d50fd3e87dd}, {0x580d73a2d880f4f2, 0x17b01773fdcb9fe4},
+		{0x4671294f139a5d8e, 0x4626792997d61984}, {0x70b50ee4ec2a2f4a, 0x3d0a5b75bfbcf59f},
+		{0x5a2a7250bcee8c3b, 0x4a6eaf916630c47f}, {0x4821f50d63f209c9, 0x21f2260deb5a36cc},
+		{0x736988156cb6760e, 0x69837016455d247a}, {0x5c546cddf091f80b, 0x6e02c011d1175062},
+		{0x49dd23e4c074c66f, 0x719bccdb0dac404e}, {0x762e9fd467213d7f, 0x68f947c4e2ad33b0},
+		{0x5e8bb3105280fdff, 0x6d94396a4ef0f627}, {0x4ba2f5a6a8673199, 0x3e102deea58d91b9},
+		{0x7904bc3dda3eb5c2, 0x3019e3176f48e927}, {0x60d09697e1cbc49b, 0x4014b5ac590720ec},
+		{0x4d73abacb4a303af, 0x4cdd5e237a6c1a57}, {0x7bec45e12104d2b2, 0x47c8969f2a46908a},
+		{0x63236b1a80d0a88e, 0x6ca0787f5505406f}, {0x4f4f88e200a6ed3f, 0x0a19f9ff773766bf},
+		{0x7ee5a7d0010b1531, 0x5cf65ccbf1f23dfe}, {0x6584864000d5aa8e, 0x172b7d6ff4c1cb32},
+		{0x5136d1cccd77bba4, 0x78ef978cc3ce3c28}, {0x40f8a7d70ac62fb7, 0x13f2dfa3cfd83020},
+		{0x67f43fbe77a37f8b, 0x398499061959e699}, {0x5329cc985fb5ffa2, 0x6136e0d1ade18548},
+		{0x4287d6e04c91994f, 0x00f8b3daf181376d}, {0x6a72f166e0e8f54b, 0x1b27862b1c01f247},
+		{0x5528c11f1a53f76f, 0x2f52d1bc1667f506}, {0x44209a7f48432c59, 0x0c424163451ff738},
+		{0x6d00f7320d3846f4, 0x7a039bd208332526}, {0x5733f8f4d76038c3, 0x7b361641a028ea85},
+		{0x45c32d90ac4cfa36, 0x2f5e78348020bb9e}, {0x6f9eaf4de07b29f0, 0x4bca59ed99cdf8fc},
+		{0x594bbf71806287f3, 0x563b7b247b0b2d96}, {0x476fcc5acd1b9ff6, 0x11c92f50626f57ac},
+		{0x724c7a2ae1c5ccbd, 0x02db7ee703e55912}, {0x5b7061bbe7d17097, 0x1be2cbec031de0dc},
+		{0x4926b496530df3ac, 0x164f09899c17e716}, {0x750aba8a1e7cb913, 0x3d4b4275c68ca4f0},
+		{0x5da22ed4e530940f, 0x4aa29b916ba3b726}, {0x4ae825771dc07672, 0x6ee87c74561c9285},
+		{0x77d9d58b62cd8a51, 0x3173fa53bcfa8408}, {0x5fe177a2b5713b74, 0x278ffb7630c869a0},
+		{0x4cb45fb55df42f90, 0x1fa662c4f3d387b3}, {0x7aba32bbc986b280, 0x32a3d13b1fb8d91f},
+		{0x622e8efca1388ecd, 0x0ee9742f4c93e0e6}, {0x4e8ba596e760723d, 0x58bac3590a0fe71e},
+		{0x7dac3c24a5671d2f, 0x412ad228101971c9}, {0x6489c9b6eab8e426, 0x00ef0e8673478e3b},
+		{0x506e3af8bbc71ceb, 0x1a58d86b8f6c71c9}, {0x40582f2d6305b0bc, 0x1513e0560c56c16e},
+		{0x66f37eaf04d5e793, 0x3b530089ad579be2}, {0x525c6558d0ab1fa9, 0x15dc006e2446164f},
+		{0x41e384470d55b2ed, 0x5e4999f1b69e783f}, {0x696c06d81555eb15, 0x7d428fe92430c065},
+		{0x54566be0111188de, 0x31020cba835a3384}, {0x4378564cda746d7e, 0x5a680a2ecf7b5c69},
+		{0x6bf3bd47c3ed7bfd, 0x770cdd17b25efa42}, {0x565c976c9cbdfccb, 0x1270b0dfc1e59502},
+		{0x4516df8a16fe63d5, 0x5b8d5a4c9b1e10ce}, {0x6e8aff4357fd6c89, 0x127bc3adc4fce7b0},
+		{0x586f329c466456d4, 0x0ec96957d0ca52f3}, {0x46bf5bb038504576, 0x3f07877973d50f29},
+		{0x71322c4d26e6d58a, 0x31a5a58f1fbb4b75}, {0x5a8e89d75252446e, 0x5aeaead8e62f6f91},
+		{0x487207df750e9d25, 0x2f22557a51bf8c74}, {0x73e9a63254e42ea2, 0x1836ef2a1c65ad86},
+		{0x5cbaeb5b771cf21b, 0x2cf8bf54e3848ad2}, {0x4a2f22af927d8e7c, 0x23fa32aa4f9d3bdb},
+		{0x76b1d118ea627d93, 0x5329eaaa18fb92f8}, {0x5ef4a74721e86476, 0x0f54bbbb472fa8c6},
+		{0x4bf6ec38e7ed1d2b, 0x25dd62fc38f2ed6c}, {0x798b138e3fe1c845, 0x22fbd1938e517bdf},
+		{0x613c0fa4ffe7d36a, 0x4f2fdadc71dac97f}, {0x4dc9a61d998642bb, 0x58f3157d27e23acc},
+		{0x7c75d695c2706ac5, 0x74b82261d969f7ad}, {0x63917877cec0556b, 0x10934eb4adee5fbe},
+		{0x4fa793930bcd1122, 0x4075d8908b251965}, {0x7f7285b812e1b504, 0x00bc8db411d4f56e},
+		{0x65f537c675815d9c, 0x66fd3e29a7dd9125}, {0x5190f96b91344ae3, 0x6bfdcb54864ada84},
+		{0x4140c78940f6a24f, 0x6ffe3c439ea2486a}, {0x6867a5a867f103b2, 0x7ffd2d38fdd073dc},
+		{0x53861e2053273628, 0x6664242d97d9f64a}, {0x42d1b1b375b8f820, 0x51e9b68adfe191d5},
+		{0x6ae91c5255f4c034, 0x1ca924116635b621}, {0x558749db77f70029, 0x63ba83411e915e81},
+		{0x446c3b15f9926687, 0x6962029a7edab201}, {0x6d79f82328ea3da6, 0x0f03375d97c45001},
+		{0x5794c6828721caeb, 0x259c2c4adfd04001}, {0x46109eced2816f22, 0x5149bd08b30d0001},
+		{0x701a97b150cf1837, 0x3542c80deb480001}, {0x59aedfc10d7279c5, 0x7768a00b22a00001},
+		{0x47bf19673df52e37, 0x79208008e8800001}, {0x72cb5bd86321e38c, 0x5b67334174000001},
+		{0x5bd5e313828182d6, 0x7c528f6790000001}, {0x4977e8dc68679bdf, 0x16a872b940000001},
+		{0x758ca7c70d7292fe, 0x5773eac200000001}, {0x5e0a1fd271287598, 0x45f6556800000001},
+		{0x4b3b4ca85a86c47a, 0x04c5112000000001}, {0x785ee10d5da46d90, 0x07a1b50000000001},
+		{0x604be73de4838ad9, 0x52e7c40000000001}, {0x4d0985cb1d3608ae, 0x0f1fd00000000001},
+		{0x7b426fab61f00de3, 0x31cc800000000001}, {0x629b8c891b267182, 0x5b0a000000000001},
+		{0x4ee2d6d415b85ace, 0x7c08000000000001}, {0x7e37be2022c0914b, 0x1340000000000001},
+		{0x64f964e68233a76f, 0x2900000000000001}, {0x50c783eb9b5c85f2, 0x5400000000000001},
+		{0x409f9cbc7c4a04c2, 0x1000000000000001}, {0x6765c793fa10079d, 0x0000000000000001},
+		{0x52b7d2dcc80cd2e4, 0x0000000000000001}, {0x422ca8b0a00a4250, 0x0000000000000001},
+		{0x69e10de76676d080, 0x0000000000000001}, {0x54b40b1f852bda00, 0x0000000000000001},
+		{0x43c33c1937564800, 0x0000000000000001}, {0x6c6b935b8bbd4000, 0x0000000000000001},
+		{0x56bc75e2d6310000, 0x0000000000000001}, {0x4563918244f40000, 0x0000000000000001},
+		{0x6f05b59d3b200000, 0x0000000000000001}, {0x58d15e1762800000, 0x0000000000000001},
+		{0x470de4df82000000, 0x0000000000000001}, {0x71afd498d0000000, 0x0000000000000001},
+		{0x5af3107a40000000, 0x0000000000000001}, {0x48c2739500000000, 0x0000000000000001},
+		{0x746a528800000000, 0x0000000000000001}, {0x5d21dba000000000, 0x0000000000000001},
+		{0x4a817c8000000000, 0x0000000000000001}, {0x7735940000000000, 0x0000000000000001},
+		{0x5f5e100000000000, 0x0000000000000001}, {0x4c4b400000000000, 0x0000000000000001},
+		{0x7a12000000000000, 0x0000000000000001}, {0x61a8000000000000, 0x0000000000000001},
+		{0x4e20000000000000, 0x0000000000000001}, {0x7d00000000000000, 0x0000000000000001},
+		{0x6400000000000000, 0x0000000000000001}, {0x5000000000000000, 0x0000000000000001},
+		{0x4000000000000000, 0x0000000000000001}, {0x6666666666666666, 0x3333333333333334},
+		{0x51eb851eb851eb85, 0x0f5c28f5c28f5c29}, {0x4189374bc6a7ef9d, 0x5916872b020c49bb},
+		{0x68db8bac710cb295, 0x74f0d844d013a92b}, {0x53e2d6238da3c211, 0x43f3e0370cdc8755},
+		{0x431bde82d7b634da, 0x698fe69270b06c44}, {0x6b5fca6af2bd215e, 0x0f4ca41d811a46d4},
+		{0x55e63b88c230e77e, 0x3f70834acdae9f10}, {0x44b82fa09b5a52cb, 0x4c5a02a23e254c0d},
+		{0x6df37f675ef6eadf, 0x2d5cd10396a21347}, {0x57f5ff85e592557f, 0x3de3da69454e75d3},
+		{0x465e6604b7a84465, 0x7e4fe1edd10b9175}, {0x709709a125da0709, 0x4a19697c81ac1bef},
+		{0x5a126e1a84ae6c07, 0x54e1213067bce326}, {0x480ebe7b9d58566c, 0x43e74dc052fd8285},
+		{0x734aca5f6226f0ad, 0x530baf9a1e626a6d}, {0x5c3bd5191b525a24, 0x426fbfae7eb521f1},
+		{0x49c97747490eae83, 0x4ebfcc8b9890e7f4}, {0x760f253edb4ab0d2, 0x4acc7a78f41b0cba},
+		{0x5e72843249088d75, 0x223d2ec729af3d62}, {0x4b8ed0283a6d3df7, 0x34fdbf05baf29781},
+		{0x78e480405d7b9658, 0x54c931a2c4b758cf}, {0x60b6cd004ac94513, 0x5d6dc14f03c5e0a5},
+		{0x4d5f0a66a23a9da9, 0x31249aa59c9e4d51}, {0x7bcb43d769f762a8, 0x4ea0f76f60fd4882},
+		{0x63090312bb2c4eed, 0x254d92bf80caa068}, {0x4f3a68dbc8f03f24, 0x1dd7a89933d54d20},
+		{0x7ec3daf941806506, 0x62f2a75b86221500}, {0x65697bfa9acd1d9f, 0x025bb91604e810cd},
+		{0x51212ffbaf0a7e18, 0x684960de6a5340a4}, {0x40e7599625a1fe7a, 0x203ab3e521dc33b6},
+		{0x67d88f56a29cca5d, 0x19f7863b696052bd}, {0x5313a5dee87d6eb0, 0x7b2c6b62bab37564},
+		{0x42761e4bed31255a, 0x2f56bc4efbc2c450}, {0x6a5696dfe1e83bc3, 0x655793b192d13a1a},
+		{0x5512124cb4b9c969, 0x377942f475742e7b}, {0x440e750a2a2e3aba, 0x5f9435905df68b96},
+		{0x6ce3ee76a9e3912a, 0x65b9ef4d63241289}, {0x571cbec554b60dbb, 0x6afb25d782834207},
+		{0x45b0989ddd5e7163, 0x08c8eb12cecf6806}, {0x6f80f42fc8971bd1, 0x5adb11b7b14bd9a3},
+		{0x5933f68ca078e30e, 0x157c0e2c8dd647b5}, {0x475cc53d4d2d8271, 0x5dfcd823a4ab6c91},
+		{0x722e086215159d82, 0x632e269f6ddf141b}, {0x5b5806b4ddaae468, 0x4f581ee5f17f4349},
+		{0x49133890b1558386, 0x72ace584c1329c3b}, {0x74eb8db44eef38d7, 0x6aae3c079b842d2a},
+		{0x5d893e29d8bf60ac, 0x5558300616035755}, {0x4ad431bb13cc4d56, 0x7779c004de6912ab},
+		{0x77b9e92b52e07bbe, 0x258f99a163db5111}, {0x5fc7edbc424d2fcb, 0x37a614811caf740d},
+		{0x4c9ff163683dbfd5, 0x7951aa00e3bf900b}, {0x7a998238a6c932ef, 0x754f7667d2cc19ab},
+		{0x6214682d523a8f26, 0x2aa5f8530f09ae22}, {0x4e76b9bddb620c1e, 0x55519375a5a1581b},
+		{0x7d8ac2c95f034697, 0x3bb5b8bc3c3559c5}, {0x646f023ab2690545, 0x7c9160969691149e},
+		{0x5058ce955b87376b, 0x16dab3ababa743b2}, {0x40470baaaf9f5f88, 0x78aef622efb902f5},
+		{0x66d812aab29898db, 0x0de4bd04b2c19e54}, {0x524675555bad4715, 0x57ea30d08f014b76},
+		{0x41d1f7777c8a9f44, 0x4654f3da0c01092c}, {0x694ff258c7443207, 0x23bb1fc346680eac},
+		{0x543ff513d29cf4d2, 0x4fc8e635d1ecd88a}, {0x43665da9754a5d75, 0x263a51c4a7f0ad3b},
+		{0x6bd6fc425543c8bb, 0x56c3b607731aaec4}, {0x5645969b77696d62, 0x789c919f8f488bd0},
+		{0x4504787c5f878ab5, 0x46e3a7b2d906d640}, {0x6e6d8d93cc0c1122, 0x3e390c515b3e239a},
+		{0x5857a4763cd6741b, 0x4b60d6a77c31b615}, {0x46ac8391ca4529af, 0x55e7121f968e2b44},
+		{0x711405b6106ea919, 0x0971b698f0e3786d}, {0x5a766af80d255414, 0x078e2bad8d82c6bd},
+		{0x485ebbf9a41ddcdc, 0x6c71bc8ad79bd231}, {0x73cac65c39c96161, 0x2d82c7448c2c8382},
+		{0x5ca23849c7d44de7, 0x3e023903a356cf9b}, {0x4a1b603b06437185, 0x7e682d9c82abd949},
+		{0x76923391a39f1c09, 0x4a4048fa6aac8edb}, {0x5edb5c7482e5b007, 0x55003a61eef07249},
+		{0x4be2b05d35848cd2, 0x773361e7f259f507}, {0x796ab3c855a0e151, 0x3eb89ca6508fee71},
+		{0x6122296d114d810d, 0x7efa16eb73a6585b}, {0x4db4edf0daa4673e, 0x3261abef8fb846af},
+		{0x7c54afe7c43a3eca, 0x1d691318e5f3a44b}, {0x6376f31fd02e98a1, 0x64540f471e5c836f},
+		{0x4f925c1973587a1b, 0x0376729f4b7d35f3}, {0x7f50935bebc0c35e, 0x38bd84321261efeb},
+		{0x65da0f7cbc9a35e5, 0x13cad0280eb4bfef}, {0x517b3f96fd482b1d, 0x5ca240200bc3ccbf},
+		{0x412f66126439bc17, 0x63b50019a3030a33}, {0x684bd683d38f9359, 0x1f88002904d1a9ea},
+		{0x536fdecfdc72dc47, 0x32d3335403daee55}, {0x42bfe57316c249d2, 0x5bdc291003158b77},
+		{0x6acca251be03a951, 0x12f9db4cd1bc1258}, {0x557081dafe695440, 0x7594af70a7c9a847},
+		{0x445a017bfebaa9cd, 0x4476f2c0863aed06}, {0x6d5ccf2ccac442e2, 0x3a57eacda3917b3c},
+		{0x577d728a3bd03581, 0x7b7988a482dac8fd}, {0x45fdf53b630cf79b, 0x15fad3b6cf156d97},
+		{0x6ffcbb923814bf5e, 0x565e1f8ae4ef15be}, {0x5996fc74f9aa32b2, 0x11e4e608b725aaff},
+		{0x47abfd2a6154f55b, 0x27ea51a0928488cc}, {0x72acc843ceee555e, 0x7310829a84074146},
+		{0x5bbd6d030bf1dde5, 0x42739baed005cdd2}, {0x49645735a327e4b7, 0x4ec2e2f24004a4a8},
+		{0x756d5855d1d96df2, 0x4ad16b1d333aa10c}, {0x5df11377db1457f5, 0x2241227dc2954da3},
+		{0x4b2742c648dd132a, 0x4e9a81fe35443e1c}, {0x783ed13d4161b844, 0x175d9cc9eed39694},
+		{0x603240fdcde7c69c, 0x7917b0a18bdc7876}, {0x4cf500cb0b1fd217, 0x1412f3b46fe39392},
+		{0x7b219ade7832e9be, 0x535185ed7fd285b6}, {0x628148b1f9c25498, 0x42a79e57997537c5},
+		{0x4ecdd3c1949b76e0, 0x3552e512e12a9304}, {0x7e161f9c20f8be33, 0x6eeb081e3510eb39},
+		{0x64de7fb01a609829, 0x3f226ce4f740bc2e}, {0x50b1ffc0151a1354, 0x3281f0b72c33c9be},
+		{0x408e66334414dc43, 0x42018d5f568fd498}, {0x674a3d1ed354939f, 0x1ccf48988a7fba8d},
+		{0x52a1ca7f0f76dc7f, 0x30a5d3ad3b99620b}, {0x421b0865a5f8b065, 0x73b7dc8a96144e6f},
+		{0x69c4da3c3cc11a3c, 0x52bfc7442353b0b1}, {0x549d7b6363cdae96, 0x756639034f7626f4},
+		{0x43b12f82b63e2545, 0x4451c735d92b525d}, {0x6c4eb26abd303ba2, 0x3a1c71efc1deea2e},
+		{0x56a55b889759c94e, 0x61b05b2634b254f2}, {0x45511606df7b0772, 0x1af37c1e908eaa5b},
+		{0x6ee8233e325e7250, 0x2b1f2cfdb41776f8}, {0x58b9b5cb5b7ec1d9, 0x6f4c23fe29ac5f2d},
+		{0x46faf7d5e2cbce47, 0x72a34ffe87bd18f1}, {0x71918c896adfb073, 0x04387ffda5fb5b1b},
+		{0x5adad6d4557fc05c, 0x0360666484c915af}, {0x48af1243779966b0, 0x02b3851d3707448c},
+		{0x744b506bf28f0ab3, 0x1dec082ebe720746}, {0x5d090d2328726ef5, 0x64bcd358985b3905},
+		{0x4a6da41c205b8bf7, 0x6a30a913ad15c738}, {0x7715d36033c5acbf, 0x5d1aa81f7b560b8c},
+		{0x5f44a919c3048a32, 0x7daeece5fc44d609}, {0x4c36edae359d3b5b, 0x7e258a51969d7808},
+		{0x79f17c49ef61f893, 0x16a276e8f0fbf33f}, {0x618dfd07f2b4c6dc, 0x121b9253f3fcc299},
+		{0x4e0b30d328909f16, 0x41afa84329970214}, {0x7cdeb4850db431bd, 0x4f7f739ea8f19ced},
+		{0x63e55d373e29c164, 0x3f99294bba5ae3f1}, {0x4feab0f8fe87cde9, 0x7fadbaa2fb7be98d},
+		{0x7fdde7f4ca72e30f, 0x7f7c5dd1925fdc15}, {0x664b1ff7085be8d9, 0x4c637e4141e649ab},
+		{0x51d5b32c06afed7a, 0x704f983434b83aef}, {0x4177c2899ef32462, 0x26a6135cf6f9c8bf},
+		{0x68bf9da8fe51d3d0, 0x3dd685618b294132}, {0x53cc7e20cb74a973, 0x4b12044e08edcdc2},
+		{0x4309fe80a2c3bac2, 0x6f419d0b3a57d7ce}, {0x6b4330cdd1392ad1, 0x320294dec3bfbfb0},
+		{0x55cf5a3e40fa88a7, 0x419baa4bcfcc995a}, {0x44a5e1cb672ed3b9, 0x1ae2eea30ca3ade1},
+		{0x6dd636123eb152c1, 0x77d17dd1add2afcf}, {0x57de91a832277567, 0x797464a7be42263f},
+		{0x464ba7b9c1b92ab9, 0x4790508631ce84ff}, {0x70790c5c6928445c, 0x0c1a1a704fb0d4cc},
+		{0x59fa7049edb9d049, 0x567b4859d95a43d6}, {0x47fb8d07f161736e, 0x11fc39e17aae9cab},
+		{0x732c14d98235857d, 0x032d2968c44a9445}, {0x5c2343e134f79dfd, 0x4f575453d03ba9d1},
+		{0x49b5cfe75d92e4ca, 0x72ac4376402fbb0e}, {0x75efb30bc8eb07ab, 0x0446d256cd192b49},
+		{0x5e595c096d88d2ef, 0x1d0575123dadbc3a}, {0x4b7ab0078ad3dbf2, 0x4a6ac40e97be302f},
+		{0x78c44cd8de1fc650, 0x771139b0f2c9e6b1}, {0x609d0a4718196b73, 0x78da948d8f07ebc1},
+		{0x4d4a6e9f467abc5c, 0x60aedd3e0c065634}, {0x7baa4a9870c46094, 0x344afb9679a3bd20},
+		{0x62eea2138d69e6dd, 0x103bfc78614fca80}, {0x4f254e760abb1f17, 0x26966393810ca200},
+		{0x7ea21723445e9825, 0x2423d2859b476999}, {0x654e78e9037ee01d, 0x69b642047c392148},
+		{0x510b93ed9c658017, 0x6e2b680396941aa0}, {0x40d60ff149eaccdf, 0x71bc53361210154d},
+		{0x67bce64edcaae166, 0x1c6085235019bbae}, {0x52fd850be3bbe784, 0x7d1a041c40149625},
+		{0x42646a6fe9631f9d, 0x4a7b367d0010781d}, {0x6a3a43e642383295, 0x5d91f0c8001a59c8},
+		{0x54fb698501c68ede, 0x17a7f3d3334847d4}, {0x43fc546a67d20be4, 0x79532975c2a03976},
+		{0x6cc6ed770c83463b, 0x0eeb75893766c256}, {0x57058ac5a39c382f, 0x25892ad42c523512},
+		{0x459e089e1c7cf9bf, 0x37a0ef102374f742}, {0x6f6340fcfa618f98, 0x59017e8038bb2536},
+		{0x591c33fd951ad946, 0x7a67986693c8ea91}, {0x4749c33144157a9f, 0x151fad1edca0bba8},
+		{0x720f9eb539bbf765, 0x0832ae97c76792a5}, {0x5b3fb22a94965f84, 0x068ef21305ec7551},
+		{0x48ffc1bbaa11e603, 0x1ed8c1a8d189f774}, {0x74cc692c434fd66b, 0x4af4690e1c0ff253},
+		{0x5d705423690cab89, 0x225d20d816732843}, {0x4ac0434f873d5607, 0x35174d79ab8f5369},
+		{0x779a054c0b955672, 0x21bee25c45b21f0e}, {0x5fae6aa33c77785b, 0x3498b5169e2818d8},
+		{0x4c8b888296c5f9e2, 0x5d46f7454b534713}, {0x7a78da6a8ad65c9d, 0x7ba4bed545520b52},
+		{0x61fa48553bdeb07e, 0x2fb6ff110441a2a8}, {0x4e61d37763188d31, 0x72f8cc0d9d014eed},
+		{0x7d6952589e8daeb6, 0x1e5ae015c80217e1}, {0x645441e07ed7bef8, 0x1848b344a001acb4},
+		{0x504367e6cbdfcbf9, 0x603a2903b3348a2a}, {0x4035ecb8a3196ffb, 0x002e873628f6d4ee},
+		{0x66bcadf43828b32b, 0x19e40b89db2487e3}, {0x52308b29c686f5bc, 0x14b66fa17c1d3983},
+		{0x41c06f549ed25e30, 0x1091f2e7967dc79c}, {0x6933e554315096b3, 0x341cb7d8f0c93f5f},
+		{0x542984435aa6def5, 0x767d5fe0c0a0ff80}, {0x435469cf7bb8b25e, 0x2b977fe70080cc66},
+		{0x6bba42e592c11d63, 0x5f58cca4cd9ae0a3}, {0x562e9beadbcdb11c, 0x4c470a1d7148b3b6},
+		{0x44f216557ca48db0, 0x3d05a1b1276d5c92}, {0x6e5023bbfaa0e2b3, 0x7b3c35e83f1560e9},
+		{0x58401c96621a4ef6, 0x2f635e5365aab3ed}, {0x4699b0784e7b725e, 0x591c4b75eaeef658},
+		{0x70f5e726e3f8b6fd, 0x74fa125644b18a26}, {0x5a5e5285832d5f31, 0x43fb41de9d5ad4eb},
+		{0x484b75379c244c27, 0x4ffc34b2177bdd89}, {0x73abeebf603a1372, 0x4cc6bab68bf96274},
+		{0x5c898bcc4cfb42c2, 0x0a38955ed6611b90}, {0x4a07a309d72f689b, 0x21c6dde5784dafa7},
+		{0x76729e762518a75e, 0x693e2fd58d49190b}, {0x5ec2185e8413b918, 0x5431bfde0aa0e0d5},
+		{0x4bce79e536762dad, 0x29c1664b3bb3e711}, {0x794a5ca1f0bd15e2, 0x0f9bd6dec5eca4e8},
+		{0x61084a1b26fdab1b, 0x2616457f04bd50ba}, {0x4da03b48ebfe227c, 0x1e783798d09773c8},
+		{0x7c33920e46636a60, 0x30c058f480f252d9}, {0x635c74d8384f884d, 0x0d66ad9067284247},
+		{0x4f7d2a469372d370, 0x711ef14052869b6c}, {0x7f2eaa0a85848581, 0x34fe4ecd50d75f14},
+		{0x65beee6ed136d134, 0x2a650bd773df7f43}, {0x51658b8bda9240f6, 0x551da312c319329c},
+		{0x411e093caedb672b, 0x5db14f4235adc217}, {0x68300ec77e2bd845, 0x7c4ee536bc49368a},
+		{0x5359a56c64efe037, 0x7d0bea92303a9208}, {0x42ae1df050bfe693, 0x173cbba8269541a0},
+		{0x6ab02fe6e79970eb, 0x3ec792a6a422029a}, {0x5559bfebec7ac0bc, 0x3239421ee9b4cee1},
+		{0x4447ccbcbd2f0096, 0x5b6101b25490a581}, {0x6d3fadfac84b3424, 0x2bce691d541aa268},
+		{0x576624c8a03c29b6, 0x563eba7ddce21b87}, {0x45eb50a08030215e, 0x78322ecb171b4939},
+		{0x6fdee76733803564, 0x59e9e47824f87527}, {0x597f1f85c2ccf783, 0x6187e9f9b72d2a86},
+		{0x4798e6049bd72c69, 0x346cbb2e2c242205}, {0x728e3cd42c8b7a42, 0x20adf849e039d007},
+		{0x5ba4fd768a092e9b, 0x33be603b19c7d99f}, {0x4950cac53b3a8baf, 0x42feb3627b0647b3},
+		{0x754e113b91f745e5, 0x5197856a5e7072b8}, {0x5dd80dc941929e51, 0x27ac6abb7ec05bc6},
+		{0x4b133e3a9adbb1da, 0x52f05562cbcd1638}, {0x781ec9f75e2c4fc4, 0x1e4d556adfae89f3},
+		{0x6018a192b1bd0c9c, 0x7ea444557fbed4c3}, {0x4ce0814227ca707d, 0x4bb69d1132ff109c},
+		{0x7b00ced03faa4d95, 0x5f8a94e851981a93}, {0x62670bd9cc883e11, 0x32d543ed0e134875},
+		{0x4eb8d647d6d364da, 0x5bddcff0d80f6d2b}, {0x7df48a0c8aebd491, 0x12fc7fe7c018aeab},
+		{0x64c3a1a3a25643a7, 0x28c9ffec99ad5889}, {0x509c814fb511cfb9, 0x0707fff07af113a1},
+		{0x407d343fc40e3fc7, 0x1f39998d2f2742e7}, {0x672eb9ffa016cc71, 0x7ec28f484b7204a4},
+		{0x528bc7ffb345705b, 0x189ba5d36f8e6a1d}, {0x42096ccc8f6ac048, 0x7a161e42bfa521b1},
+		{0x69a8ae1418aacd41, 0x435696d132a1cf81}, {0x5486f1a9ad557101, 0x1c454574288172ce},
+		{0x439f27baf1112734, 0x169dd129ba0128a5}, {0x6c31d92b1b4ea520, 0x242fb50f9001daa1},
+		{0x568e4755af721db3, 0x368c90d940017bb4}, {0x453e9f77bf8e7e29, 0x120a0d7a999ac95d},
+		{0x6eca98bf98e3fd0e, 0x50101590f5c47561}, {0x58a213cc7a4ffda5, 0x26734473f7d05de8},
+		{0x46e80fd6c83ffe1d, 0x6b8f69f65fd9e4b9}, {0x71734c8ad9fffcfc, 0x45b24323cc8fd45c},
+		{0x5ac2a3a247fffd96, 0x6af502830a0ca9e3}, {0x489bb61b6ccccadf, 0x08c402026e7087e9},
+		{0x742c569247ae1164, 0x746cd003e3e73fdb}, {0x5cf04541d2f1a783, 0x76bd73364fec3315},
+		{0x4a59d101758e1f9c, 0x5efdf5c50cbcf5ab}, {0x76f61b3588e365c7, 0x4b2fefa1adfb22ab},
+		{0x5f2b48f7a0b5eb06, 0x08f3261af195b555}, {0x4c22a0c61a2b226b, 0x20c284e25ade2aab},
+		{0x79d1013cf6ab6a45, 0x1ad0d49d5e304444}, {0x617400fd9222bb6a, 0x48a7107de4f369d0},
+		{0x4df6673141b562bb, 0x53b8d9fe50c2bb0d}, {0x7cbd71e869223792, 0x52c15cca1ad12b48},
+		{0x63cac186ba81c60e, 0x75677d6e7bda8906}, {0x4fd5679efb9b04d8, 0x5dec645863153a6c},
+		{0x7fbbd8fe5f5e6e27, 0x497a3a2704eec3df}
+	};
 
-	PUGI__FN bool set_value_convert(char_t*& dest, uintptr_t& header, uintptr_t header_mask, int value)
+	// floor(log10(2^e)), floor(log10(3/4 2^e)) and floor(log2(10^e)) for the exponents of doubles; these rely on >> of a
+	// negative number rounding down, as it does on every supported compiler
+	PUGI__FN int floor_log10_pow2(int e)
 	{
-		char buf[128];
-		sprintf(buf, "%d", value);
-	
-		return set_value_buffer(dest, header, header_mask, buf);
+		return static_cast<int>(static_cast<int64_t>(e) * 661971961083LL >> 41);
 	}
 
-	PUGI__FN bool set_value_convert(char_t*& dest, uintptr_t& header, uintptr_t header_mask, unsigned int value)
+	PUGI__FN int floor_log10_three_quarters_pow2(int e)
 	{
-		char buf[128];
-		sprintf(buf, "%u", value);
+		return static_cast<int>((static_cast<int64_t>(e) * 661971961083LL - 274743187321LL) >> 41);
+	}
 
-		return set_value_buffer(dest, header, header_mask, buf);
+	PUGI__FN int floor_log2_pow10(int e)
+	{
+		return static_cast<int>(static_cast<int64_t>(e) * 913124641741LL >> 38);
 	}
 
-	PUGI__FN bool set_value_convert(char_t*& dest, uintptr_t& header, uintptr_t header_mask, double value)
+	// High 64 bits of a 64x64 bit product
+	PUGI__FN uint64_t multiply_high(uint64_t a, uint64_t b)
 	{
-		char buf[128];
-		sprintf(buf, "%g", value);
+	#ifdef __SIZEOF_INT128__
+		__extension__ typedef unsigned __int128 uint128_t;
 
-		return set_value_buffer(dest, header, header_mask, buf);
-	}
-	
-	PUGI__FN bool set_value_convert(char_t*& dest, uintptr_t& header, uintptr_t header_mask, bool value)
+		return static_cast<uint64_t>(static_cast<uint128_t>(a) * b >> 64);
+	#else
+		uint64_t a_low = static_cast<uint32_t>(a), a_high = a >> 32;
+		uint64_t b_low = static_cast<uint32_t>(b), b_high = b >> 32;
+
+		uint64_t low = a_low * b_low;
+		uint64_t middle = a_high * b_low + (low >> 32);
+		uint64_t carry = a_low * b_high + static_cast<uint32_t>(middle);
+
+		return a_high * b_high + (middle >> 32) + (carry >> 32);
+	#endif
+	}
+
+	// g x 2^-127, with the lowest bit set if anything nonzero was cut off
+	PUGI__FN uint64_t schubfach_round_to_odd(const uint64_t (&g)[2], uint64_t x)
 	{
-		return strcpy_insitu(dest, header, header_mask, value ? PUGIXML_TEXT("true") : PUGIXML_TEXT("false"));
+		const uint64_t mask = (static_cast<uint64_t>(1) << 63) - 1;
+
+		uint64_t high = multiply_high(g[0], x);
+		uint64_t middle = (g[0] * x >> 1) + multiply_high(g[1], x);
+
+		return (high + (middle >> 63)) | (((middle & mask) + mask) >> 63);
 	}
 
-#ifdef PUGIXML_HAS_LONG_LONG
-	PUGI__FN bool set_value_convert(char_t*& dest, uintptr_t& header, uintptr_t header_mask, long long value)
+	// g x 2^-95, with the lowest bit set if anything nonzero was cut off
+	PUGI__FN uint32_t schubfach_round_to_odd(uint64_t g, uint64_t x)
+	{
+		uint64_t high = multiply_high(g, x);
+
+		return static_cast<uint32_t>((high >> 31) | (((high & 0xffffffff) + 0xffffffff) >> 32));
+	}
+
+	// Finds the shortest digits * 10^exponent that reads back as the given finite double; returns the sign
+	PUGI__FN bool double_to_decimal(double value, uint64_t& digits, int& exponent)
+	{
+		uint64_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+
+		const uint64_t hidden_bit = static_cast<uint64_t>(1) << 52;
+
+		uint64_t c = bits & (hidden_bit - 1);
+		int biased_exponent = static_cast<int>(bits >> 52) & 0x7ff;
+		int q = biased_exponent ? biased_exponent - 1075 : -1074;
+
+		// the value is c 2^q
+		digits = 0;
+		exponent = 0;
+
+		if (biased_exponent)
+		{
+			c |= hidden_bit;
+
+			// integers below 2^53 are already their shortest form
+			if (q < 0 && q > -53 && (c & ((static_cast<uint64_t>(1) << -q) - 1)) == 0)
+			{
+				digits = c >> -q;
+				return (bits >> 63) != 0;
+			}
+		}
+		else if (c == 0)
+			return (bits >> 63) != 0;
+
+		// the interval is narrower below powers of two, since the next value down is twice as close
+		bool symmetric = c != hidden_bit || q == -1074;
+
+		uint64_t cb = c << 2;
+		uint64_t cb_right = cb + 2;
+		uint64_t cb_left = symmetric ? cb - 2 : cb - 1;
+
+		int k = symmetric ? floor_log10_pow2(q) : floor_log10_three_quarters_pow2(q);
+		int h = q + floor_log2_pow10(-k) + 2;
+
+		const uint64_t (&g)[2] = schubfach_table[k + 324];
+
+		// the value and the interval ends scaled by 4 10^-k
+		uint64_t vb = schubfach_round_to_odd(g, cb << h);
+		uint64_t vb_left = schubfach_round_to_odd(g, cb_left << h);
+		uint64_t vb_right = schubfach_round_to_odd(g, cb_right << h);
+
+		// interval ends are included when c is even, so that round-to-even reading gets the same value back
+		uint64_t odd = c & 1;
+		uint64_t s = vb >> 2;
+
+		if (s >= 10)
+		{
+			// one digit shorter; s / 10 * 10
+			uint64_t sp10 = 10 * multiply_high(s, 0x199999999999999aULL);
+			uint64_t tp10 = sp10 + 10;
+
+			bool sp10_in = vb_left + odd <= sp10 << 2;
+			bool tp10_in = (tp10 << 2) + odd <= vb_right;
+
+			if (sp10_in != tp10_in)
+			{
+				digits = sp10_in ? sp10 : tp10;
+				exponent = k;
+				return (bits >> 63) != 0;
+			}
+		}
+
+		uint64_t t = s + 1;
+
+		bool s_in = vb_left + odd <= s << 2;
+		bool t_in = (t << 2) + odd <= vb_right;
+
+		// if both or neither are in the interval, take the closer one, the even one on a tie
+		if (s_in != t_in)
+			digits = s_in ? s : t;
+		else
+			digits = vb < (s + t) << 1 || (vb == (s + t) << 1 && (s & 1) == 0) ? s : t;
+
+		exponent = k;
+		return (bits >> 63) != 0;
+	}
+
+	// Finds the shortest digits * 10^exponent that reads back as the given finite float; returns the sign
+	PUGI__FN bool float_to_decimal(float value, uint64_t& digits, int& exponent)
+	{
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+
+		const uint32_t hidden_bit = static_cast<uint32_t>(1) << 23;
+
+		uint32_t c = bits & (hidden_bit - 1);
+		int biased_exponent = static_cast<int>(bits >> 23) & 0xff;
+		int q = biased_exponent ? biased_exponent - 150 : -149;
+
+		digits = 0;
+		exponent = 0;
+
+		if (biased_exponent)
+		{
+			c |= hidden_bit;
+
+			if (q < 0 && q > -24 && (c & ((static_cast<uint32_t>(1) << -q) - 1)) == 0)
+			{
+				digits = c >> -q;
+				return (bits >> 31) != 0;
+			}
+		}
+		else if (c == 0)
+			return (bits >> 31) != 0;
+
+		bool symmetric = c != hidden_bit || q == -149;
+
+		uint64_t cb = static_cast<uint64_t>(c) << 2;
+		uint64_t cb_right = cb + 2;
+		uint64_t cb_left = symmetric ? cb - 2 : cb - 1;
+
+		int k = symmetric ? floor_log10_pow2(q) : floor_log10_three_quarters_pow2(q);
+		int h = q + floor_log2_pow10(-k) + 33;
+
+		uint64_t g = schubfach_table[k + 324][0] + 1;
+
+		uint32_t vb = schubfach_round_to_odd(g, cb << h);
+		uint32_t vb_left = schubfach_round_to_odd(g, cb_left << h);
+		uint32_t vb_right = schubfach_round_to_odd(g, cb_right << h);
+
+		uint32_t odd = c & 1;
+		uint32_t s = vb >> 2;
+
+		if (s >= 10)
+		{
+			uint32_t sp10 = s / 10 * 10;
+			uint32_t tp10 = sp10 + 10;
+
+			bool sp10_in = vb_left + odd <= sp10 << 2;
+			bool tp10_in = (tp10 << 2) + odd <= vb_right;
+
+			if (sp10_in != tp10_in)
+			{
+				digits = sp10_in ? sp10 : tp10;
+				exponent = k;
+				return (bits >> 31) != 0;
+			}
+		}
+
+		uint32_t t = s + 1;
+
+		bool s_in = vb_left + odd <= s << 2;
+		bool t_in = (t << 2) + odd <= vb_right;
+
+		if (s_in != t_in)
+			digits = s_in ? s : t;
+		else
+			digits = vb < (s + t) << 1 || (vb == (s + t) << 1 && (s & 1) == 0) ? s : t;
+
+		exponent = k;
+		return (bits >> 31) != 0;
+	}
+
+	// Writes digits * 10^exponent the way %g would with just enough precision, but in fixed-point whenever that is no longer
+	// than the exponent form: 0.001, 0.00015, 1e-05, 123000, 1.23e+15
+	PUGI__FN void decimal_to_string(char (&buf)[128], bool negative, uint64_t digits, int exponent)
+	{
+		char* out = buf;
+
+		if (negative) *out++ = '-';
+
+		if (digits == 0)
+		{
+			*out++ = '0';
+			*out = 0;
+			return;
+		}
+
+		while (digits % 10 == 0)
+		{
+			digits /= 10;
+			exponent++;
+		}
+
+		char text[32];
+		char* end = text + sizeof(text);
+		char* begin = end;
+
+		for (; digits; digits /= 10)
+			*--begin = static_cast<char>('0' + digits % 10);
+
+		int length = static_cast<int>(end - begin);
+
+		// the value is 0.ddd * 10^point
+		int point = length + exponent;
+
+		int scientific = point - 1;
+		int scientific_length = (length > 1 ? length + 1 : 1) + (scientific <= -100 || scientific >= 100 ? 5 : 4);
+		int fixed_length = point <= 0 ? 2 - point + length : (length > point ? length + 1 : point);
+
+		if (fixed_length <= scientific_length)
+		{
+			if (point <= 0)
+			{
+				*out++ = '0';
+				*out++ = '.';
+
+				for (int i = 0; i < -point; ++i) *out++ = '0';
+
+				memcpy(out, begin, static_cast<size_t>(length));
+				out += length;
+			}
+			else if (length > point)
+			{
+				memcpy(out, begin, static_cast<size_t>(point));
+				out += point;
+				*out++ = '.';
+				memcpy(out, begin + point, static_cast<size_t>(length - point));
+				out += length - point;
+			}
+			else
+			{
+				memcpy(out, begin, static_cast<size_t>(length));
+				out += length;
+
+				for (int i = length; i < point; ++i) *out++ = '0';
+			}
+		}
+		else
+		{
+			*out++ = *begin;
+
+			if (length > 1)
+			{
+				*out++ = '.';
+				memcpy(out, begin + 1, static_cast<size_t>(length - 1));
+				out += length - 1;
+			}
+
+			*out++ = 'e';
+			*out++ = scientific < 0 ? '-' : '+';
+
+			unsigned int magnitude = static_cast<unsigned int>(scientific < 0 ? -scientific : scientific);
+
+			if (magnitude >= 100) *out++ = static_cast<char>('0' + magnitude / 100);
+
+			*out++ = static_cast<char>('0' + magnitude / 10 % 10);
+			*out++ = static_cast<char>('0' + magnitude % 10);
+		}
+
+		*out = 0;
+	}
+
+	// Writes the shortest decimal that reads back as the same double
+	PUGI__FN void double_to_string(char (&buf)[128], double value)
+	{
+		if (value != value || value - value != value - value)
+		{
+			// nan and infinity
+			sprintf(buf, "%g", value);
+			return;
+		}
+
+		uint64_t digits;
+		int exponent;
+		bool negative = double_to_decimal(value, digits, exponent);
+
+		decimal_to_string(buf, negative, digits, exponent);
+	}
+
+	// Writes the shortest decimal that reads back as the same float. Printing the float as a double would give all the
+	// digits of the widened value (0.1f is 0.100000001490116...), so floats get their own, wider rounding interval.
+	PUGI__FN void float_to_string(char (&buf)[128], float value)
+	{
+		if (value != value || value - value != value - value)
+		{
+			// nan and infinity
+			sprintf(buf, "%g", static_cast<double>(value));
+			return;
+		}
+
+		uint64_t digits;
+		int exponent;
+		bool negative = float_to_decimal(value, digits, exponent);
+
+		decimal_to_string(buf, negative, digits, exponent);
+	}
+
+	// set value with conversion functions
+	template <typename Header> PUGI__FN bool set_value_buffer(char_t*& dest, Header& header, uintptr_t header_mask, char (&buf)[128])
+	{
+	#ifdef PUGIXML_WCHAR_MODE
+		char_t wbuf[128];
+		impl::widen_ascii(wbuf, buf);
+
+		return strcpy_insitu(dest, header, header_mask, wbuf);
+	#else
+		return strcpy_insitu(dest, header, header_mask, buf);
+	#endif
+	}
+
+	template <typename U, typename Header> PUGI__FN bool set_value_integer(char_t*& dest, Header& header, uintptr_t header_mask, U value, bool negative)
+	{
+		char_t buf[64];
+		char_t* end = buf + sizeof(buf) / sizeof(buf[0]) - 1;
+		char_t* begin = integer_to_string(buf, end, value, negative);
+
+		*end = 0;
+
+		return strcpy_insitu(dest, header, header_mask, begin);
+	}
+
+	template <typename Header> PUGI__FN bool set_value_convert(char_t*& dest, Header& header, uintptr_t header_mask, int value)
+	{
+		return set_value_integer<unsigned int>(dest, header, header_mask, value, value < 0);
+	}
+
+	template <typename Header> PUGI__FN bool set_value_convert(char_t*& dest, Header& header, uintptr_t header_mask, unsigned int value)
+	{
+		return set_value_integer<unsigned int>(dest, header, header_mask, value, false);
+	}
+
+	template <typename Header> PUGI__FN bool set_value_convert(char_t*& dest, Header& header, uintptr_t header_mask, double value)
 	{
 		char buf[128];
-		sprintf(buf, "%lld", value);
-	
+		double_to_string(buf, value);
+
 		return set_value_buffer(dest, header, header_mask, buf);
 	}
 
-	PUGI__FN bool set_value_convert(char_t*& dest, uintptr_t& header, uintptr_t header_mask, unsigned long long value)
+	template <typename Header> PUGI__FN bool set_value_convert(char_t*& dest, Header& header, uintptr_t header_mask, float value)
 	{
 		char buf[128];
-		sprintf(buf, "%llu", value);
-	
+		float_to_string(buf, value);
+
 		return set_value_buffer(dest, header, header_mask, buf);
 	}
+	
+	template <typename Header> PUGI__FN bool set_value_convert(char_t*& dest, Header& header, uintptr_t header_mask, bool value)
+	{
+		return strcpy_insitu(dest, header, header_mask, value ? PUGIXML_TEXT("true") : PUGIXML_TEXT("false"));
+	}
+
+#ifdef PUGIXML_HAS_LONG_LONG
+	template <typename Header> PUGI__FN bool set_value_convert(char_t*& dest, Header& header, uintptr_t header_mask, long long value)
+	{
+		return set_value_integer<unsigned long long>(dest, header, header_mask, value, value < 0);
+	}
+
+	template <typename Header> PUGI__FN bool set_value_convert(char_t*& dest, Header& header, uintptr_t header_mask, unsigned long long value)
+	{
+		return set_value_integer<unsigned long long>(dest, header, header_mask, value, false);
+	}
 #endif
 
 	// we need to get length of entire file to load it in memory; the only (relatively) sane way to do it is via seek/tell trick
@@ -4195,141 +5754,1316 @@ PUGI__NS_BEGIN
 
 		size_t max_suffix_size = sizeof(char_t);
 
-		// read stream data into memory (guard against stream exceptions with buffer holder)
-		buffer_holder buffer(xml_memory::allocate(read_length * sizeof(T) + max_suffix_size), xml_memory::deallocate);
-		if (!buffer.data) return status_out_of_memory;
+		// read stream data into memory (guard against stream exceptions with buffer holder)
+		buffer_holder buffer(xml_memory::allocate(read_length * sizeof(T) + max_suffix_size), xml_memory::deallocate);
+		if (!buffer.data) return status_out_of_memory;
+
+		stream.read(static_cast<T*>(buffer.data), static_cast<std::streamsize>(read_length));
+
+		// read may set failbit | eofbit in case gcount() is less than read_length (i.e. line ending conversion), so check for other I/O errors
+		if (stream.bad() || (!stream.eof() && stream.fail())) return status_io_error;
+
+		// return buffer
+		size_t actual_length = static_cast<size_t>(stream.gcount());
+		assert(actual_length <= read_length);
+		
+		*out_buffer = buffer.release();
+		*out_size = actual_length * sizeof(T);
+
+		return status_ok;
+	}
+
+	template <typename T> PUGI__FN xml_parse_result load_stream_impl(xml_document& doc, std::basic_istream<T>& stream, unsigned int options, xml_encoding encoding)
+	{
+		void* buffer = 0;
+		size_t size = 0;
+		xml_parse_status status = status_ok;
+
+		// if stream has an error bit set, bail out (otherwise tellg() can fail and we'll clear error bits)
+		if (stream.fail()) return make_parse_result(status_io_error);
+
+		// load stream to memory (using seek-based implementation if possible, since it's faster and takes less memory)
+		if (stream.tellg() < 0)
+		{
+			stream.clear(); // clear error flags that could be set by a failing tellg
+			status = load_stream_data_noseek(stream, &buffer, &size);
+		}
+		else
+			status = load_stream_data_seek(stream, &buffer, &size);
+
+		if (status != status_ok) return make_parse_result(status);
+
+		xml_encoding real_encoding = get_buffer_encoding(encoding, buffer, size);
+		
+		return doc.load_buffer_inplace_own(buffer, zero_terminate_buffer(buffer, size, real_encoding), options, real_encoding);
+	}
+#endif
+
+#if defined(PUGI__MSVC_CRT_VERSION) || defined(__BORLANDC__) || (defined(__MINGW32__) && (!defined(__STRICT_ANSI__) || defined(__MINGW64_VERSION_MAJOR)))
+	PUGI__FN FILE* open_file_wide(const wchar_t* path, const wchar_t* mode)
+	{
+		return _wfopen(path, mode);
+	}
+#else
+	PUGI__FN char* convert_path_heap(const wchar_t* str)
+	{
+		assert(str);
+
+		// first pass: get length in utf8 characters
+		size_t length = strlength_wide(str);
+		size_t size = as_utf8_begin(str, length);
+
+		// allocate resulting string
+		char* result = static_cast<char*>(xml_memory::allocate(size + 1));
+		if (!result) return 0;
+
+		// second pass: convert to utf8
+		as_utf8_end(result, size, str, length);
+
+		return result;
+	}
+
+	PUGI__FN FILE* open_file_wide(const wchar_t* path, const wchar_t* mode)
+	{
+		// there is no standard function to open wide paths, so our best bet is to try utf8 path
+		char* path_utf8 = convert_path_heap(path);
+		if (!path_utf8) return 0;
+
+		// convert mode to ASCII (we mirror _wfopen interface)
+		char mode_ascii[4] = {0};
+		for (size_t i = 0; mode[i]; ++i) mode_ascii[i] = static_cast<char>(mode[i]);
+
+		// try to open the utf8 path
+		FILE* result = fopen(path_utf8, mode_ascii);
+
+		// free dummy buffer
+		xml_memory::deallocate(path_utf8);
+
+		return result;
+	}
+#endif
+
+	PUGI__FN bool save_file_impl(const xml_document& doc, FILE* file, const char_t* indent, unsigned int flags, xml_encoding encoding)
+	{
+		if (!file) return false;
+
+		xml_writer_file writer(file);
+		doc.save(writer, indent, flags, encoding);
+
+		int result = ferror(file);
+
+		fclose(file);
+
+		return result == 0;
+	}
+
+#ifdef PUGIXML_HAS_POSIX_IO
+	// Writes all chunks, continuing after partial writes; does nothing after an error so that the first one is reported
+	PUGI__FN void write_fd(int fd, iovec* chunks, int count, int& error)
+	{
+		while (!error)
+		{
+			while (count > 0 && chunks->iov_len == 0)
+			{
+				++chunks;
+				--count;
+			}
+
+			if (count == 0) return;
+
+			ssize_t result = writev(fd, chunks, count);
+
+			if (result < 0)
+			{
+				if (errno != EINTR) error = errno;
+				continue;
+			}
+
+			size_t written = static_cast<size_t>(result);
+
+			for (; count > 0 && written >= chunks->iov_len; ++chunks, --count)
+				written -= chunks->iov_len;
+
+			if (count > 0)
+			{
+				chunks->iov_base = static_cast<char*>(chunks->iov_base) + written;
+				chunks->iov_len -= written;
+			}
+		}
+	}
+#endif
+
+	PUGI__FN xml_parse_result load_buffer_impl(xml_document_struct* doc, xml_node_struct* root, void* contents, size_t size, unsigned int options, xml_encoding encoding, bool is_mutable, bool own, char_t** out_buffer)
+	{
+		// check input buffer
+		assert(contents || size == 0);
+
+		// get actual encoding
+		xml_encoding buffer_encoding = impl::get_buffer_encoding(encoding, contents, size);
+
+		// get private buffer
+		char_t* buffer = 0;
+		size_t length = 0;
+
+		if (!impl::convert_buffer(buffer, length, buffer_encoding, contents, size, is_mutable)) return impl::make_parse_result(status_out_of_memory);
+		
+		// delete original buffer if we performed a conversion
+		if (own && buffer != contents && contents) impl::xml_memory::deallocate(contents);
+
+		// store buffer for offset_debug
+		doc->buffer = buffer;
+
+		// parse
+		xml_parse_result res = impl::xml_parser::parse(buffer, length, doc, root, options);
+
+		// remember encoding
+		res.encoding = buffer_encoding;
+
+		// grab onto buffer if it's our buffer, user is responsible for deallocating contents himself
+		if (own || buffer != contents) *out_buffer = buffer;
+
+		return res;
+	}
+PUGI__NS_END
+
+// Incremental loading
+PUGI__NS_BEGIN
+	// Finds where top-level children of the document element end in the incoming bytes, so that complete children can go through
+	// the regular parser while the rest of the stream is still arriving. The scanner only tracks tag boundaries and depth; all
+	// validation and conversion is left to the parser. Works on bytes, so it is only used for ASCII-compatible encodings.
+	struct xml_push_parser
+	{
+		enum phase_t
+		{
+			phase_prolog,	// before the end of the document element start tag
+			phase_children,	// inside the document element
+			phase_tail		// after the document element
+		};
+
+		enum token_t
+		{
+			token_start_element,
+			token_end_element,
+			token_comment,
+			token_cdata,
+			token_pi,
+			token_declaration
+		};
+
+		xml_document& document;
+		unsigned int options;
+		xml_encoding requested_encoding;
+		xml_encoding encoding; // encoding_auto until detected
+		bool incremental;
+
+		// bytes that have not been parsed yet; data[0] is at offset 'consumed' in the stream
+		char* data;
+		size_t size;
+		size_t capacity;
+		size_t consumed;
+
+		// scanner state; when in_token is set, a construct starts at scan and its end is searched from token_scan
+		size_t scan;
+		bool in_token;
+		token_t token;
+		size_t token_scan;
+		char token_quote;
+		size_t token_brackets;
+
+		phase_t phase;
+		size_t depth;
+		xml_node_struct* root;
+		char* root_name;
+		size_t root_name_length;
+
+		xml_parse_result result;
+
+		xml_push_parser(xml_document& document_, unsigned int options_, xml_encoding encoding_): document(document_), options(options_),
+			requested_encoding(encoding_), encoding(encoding_auto), incremental(false), data(0), size(0), capacity(0), consumed(0), scan(0),
+			in_token(false), token(token_start_element), token_scan(0), token_quote(0), token_brackets(0), phase(phase_prolog), depth(0),
+			root(0), root_name(0), root_name_length(0), result(make_parse_result(status_ok))
+		{
+		}
+
+		~xml_push_parser()
+		{
+			if (data) xml_memory::deallocate(data);
+			if (root_name) xml_memory::deallocate(root_name);
+		}
+
+		bool fail(xml_parse_status status, size_t offset)
+		{
+			result = make_parse_result(status, static_cast<ptrdiff_t>(consumed + offset));
+			result.encoding = encoding;
+
+			return false;
+		}
+
+		bool fail(const xml_parse_result& res)
+		{
+			return fail(res.status, static_cast<size_t>(res.offset));
+		}
+
+		bool append(const void* contents, size_t length)
+		{
+			if (length == 0) return true;
+
+			if (size + length > capacity)
+			{
+				size_t new_capacity = capacity ? capacity : 4096;
+				while (new_capacity < size + length) new_capacity *= 2;
+
+				char* new_data = static_cast<char*>(xml_memory::allocate(new_capacity));
+				if (!new_data) return fail(status_out_of_memory, size);
+
+				if (data)
+				{
+					memcpy(new_data, data, size);
+					xml_memory::deallocate(data);
+				}
+
+				data = new_data;
+				capacity = new_capacity;
+			}
+
+			memcpy(data + size, contents, length);
+			size += length;
+
+			return true;
+		}
+
+		// drops bytes that the parser has taken
+		void consume(size_t length)
+		{
+			assert(length <= size && length <= scan);
+
+			memmove(data, data + length, size - length);
+
+			size -= length;
+			scan -= length;
+			token_scan -= in_token ? length : 0;
+			consumed += length;
+		}
+
+		size_t name_length(size_t begin) const
+		{
+			size_t end = begin;
+
+			while (end < size && data[end] != ' ' && data[end] != '\t' && data[end] != '\r' && data[end] != '\n' && data[end] != '/' && data[end] != '>')
+				++end;
+
+			return end - begin;
+		}
+
+		bool match(size_t pos, const char* literal) const
+		{
+			for (; *literal; ++pos, ++literal)
+				if (pos >= size || data[pos] != *literal) return false;
+
+			return true;
+		}
+
+		// Determines the kind of construct that starts with < at scan; false if more bytes are needed to tell
+		bool classify()
+		{
+			if (scan + 1 >= size) return false;
+
+			size_t resume = scan + 1;
+
+			switch (data[scan + 1])
+			{
+			case '/':
+				token = token_end_element;
+				break;
+
+			case '?':
+				token = token_pi;
+				resume = scan + 2;
+				break;
+
+			case '!':
+				if (scan + 2 >= size) return false;
+
+				if (data[scan + 2] == '-')
+				{
+					if (scan + 4 > size) return false;
+
+					token = match(scan, "<!--") ? token_comment : token_declaration;
+					resume = scan + 4;
+				}
+				else if (data[scan + 2] == '[')
+				{
+					if (scan + 9 > size) return false;
+
+					token = match(scan, "<![CDATA[") ? token_cdata : token_declaration;
+					resume = scan + 9;
+				}
+				else
+					token = token_declaration;
+				break;
+
+			default:
+				token = token_start_element;
+			}
+
+			in_token = true;
+			token_scan = resume;
+			token_quote = 0;
+			token_brackets = 0;
+
+			return true;
+		}
+
+		bool find_literal(const char* literal, size_t length, size_t& end)
+		{
+			for (size_t pos = token_scan; pos + length <= size; ++pos)
+			{
+				const void* next = memchr(data + pos, literal[0], size - pos);
+				if (!next) break;
+
+				pos = static_cast<size_t>(static_cast<const char*>(next) - data);
+
+				if (pos + length <= size && memcmp(data + pos, literal, length) == 0)
+				{
+					end = pos + length;
+					return true;
+				}
+			}
+
+			// the end of the buffer may hold the start of the literal
+			if (size >= token_scan + length) token_scan = size - (length - 1);
+
+			return false;
+		}
+
+		// Finds the end of the current construct; false if more bytes are needed
+		bool find_token_end(size_t& end)
+		{
+			switch (token)
+			{
+			case token_comment:
+				return find_literal("-->", 3, end);
+
+			case token_cdata:
+				return find_literal("]]>", 3, end);
+
+			case token_pi:
+				return find_literal("?>", 2, end);
+
+			default:
+				for (size_t pos = token_scan; pos < size; )
+				{
+					if (token_quote)
+					{
+						const void* quote = memchr(data + pos, token_quote, size - pos);
+						if (!quote) break;
+
+						pos = static_cast<size_t>(static_cast<const char*>(quote) - data) + 1;
+						token_quote = 0;
+						continue;
+					}
+
+					char ch = data[pos++];
+
+					if (ch == '"' || ch == '\'')
+						token_quote = ch;
+					else if (ch == '>' && token_brackets == 0)
+					{
+						end = pos;
+						return true;
+					}
+					else if (token == token_declaration)
+					{
+						if (ch == '[') ++token_brackets;
+						else if (ch == ']' && token_brackets) --token_brackets;
+					}
+				}
+
+				token_scan = size;
+				return false;
+			}
+		}
+
+		// Parses the prolog and the document element start tag, closing the element so that the parser accepts it
+		bool start_document(size_t begin, size_t end, bool empty)
+		{
+			size_t length = name_length(begin + 1);
+			size_t closing = empty ? 0 : length + 3;
+
+			char* prolog = static_cast<char*>(xml_memory::allocate(end + closing));
+			if (!prolog) return fail(status_out_of_memory, begin);
+
+			memcpy(prolog, data, end);
+
+			if (!empty)
+			{
+				prolog[end] = '<';
+				prolog[end + 1] = '/';
+				memcpy(prolog + end + 2, data + begin + 1, length);
+				prolog[end + closing - 1] = '>';
+			}
+
+			xml_parse_result res = document.append_buffer(prolog, end + closing, options, encoding);
+
+			xml_memory::deallocate(prolog);
+
+			if (!res) return fail(res);
+
+			if (empty)
+			{
+				phase = phase_tail;
+			}
+			else
+			{
+				root_name = static_cast<char*>(xml_memory::allocate(length ? length : 1));
+				if (!root_name) return fail(status_out_of_memory, begin);
+
+				memcpy(root_name, data + begin + 1, length);
+				root_name_length = length;
+
+				root = document.internal_object()->first_child->prev_sibling_c;
+				phase = phase_children;
+				depth = 1;
+			}
+
+			consume(end);
+
+			return true;
+		}
+
+		// Parses complete children of the document element that are in data[0, end)
+		bool append_children(size_t end)
+		{
+			if (end == 0) return true;
+
+			xml_parse_result res = xml_node(root).append_buffer(data, end, options | parse_fragment, encoding);
+			if (!res) return fail(res);
+
+			consume(end);
+
+			return true;
+		}
+
+		bool end_document(size_t begin, size_t end)
+		{
+			if (!append_children(begin)) return false;
+
+			// the end tag is now at the start of the data
+			end -= begin;
+
+			size_t length = name_length(2);
+
+			if (length != root_name_length || memcmp(data + 2, root_name, length) != 0)
+				return fail(status_end_element_mismatch, 2 + length);
+
+			phase = phase_tail;
+			consume(end);
+
+			return true;
+		}
+
+		// The data holds the start of the end tag of the document element. Its error depends on how much of the name matches,
+		// so the tag is parsed after a copy of the start tag, which gives the status and offset of the regular parser. This
+		// goes through load_buffer rather than load_buffer_inplace because the two report different errors at the very end.
+		bool end_truncated_document()
+		{
+			size_t prefix = root_name_length + 2;
+
+			char* buffer = static_cast<char*>(xml_memory::allocate(prefix + size));
+			if (!buffer) return fail(status_out_of_memory, 0);
+
+			buffer[0] = '<';
+			memcpy(buffer + 1, root_name, root_name_length);
+			buffer[prefix - 1] = '>';
+			memcpy(buffer + prefix, data, size);
+
+			xml_document scratch;
+			xml_parse_result res = scratch.load_buffer(buffer, prefix + size, options, encoding);
+
+			xml_memory::deallocate(buffer);
+
+			assert(!res && static_cast<size_t>(res.offset) >= prefix);
+
+			return fail(res.status, static_cast<size_t>(res.offset) - prefix);
+		}
+
+		bool process()
+		{
+			size_t commit = 0;
+
+			while (phase != phase_tail)
+			{
+				if (!in_token)
+				{
+					const void* next = memchr(data + scan, '<', size - scan);
+
+					if (!next)
+					{
+						scan = size;
+						break;
+					}
+
+					scan = static_cast<size_t>(static_cast<const char*>(next) - data);
+
+					if (!classify()) break;
+				}
+
+				size_t end;
+				if (!find_token_end(end)) break;
+
+				size_t begin = scan;
+
+				in_token = false;
+				scan = end;
+
+				if (token == token_start_element)
+				{
+					bool empty = data[end - 2] == '/';
+
+					if (phase == phase_prolog)
+					{
+						if (!start_document(begin, end, empty)) return false;
+					}
+					else if (!empty)
+						++depth;
+					else if (depth == 1)
+						commit = end;
+				}
+				else if (token == token_end_element)
+				{
+					if (phase == phase_children)
+					{
+						if (depth == 1)
+						{
+							if (!end_document(begin, end)) return false;
+
+							commit = 0;
+						}
+						else if (--depth == 1)
+							commit = end;
+					}
+				}
+				else if (phase == phase_children && depth == 1)
+					commit = end;
+			}
+
+			return phase != phase_children || append_children(commit);
+		}
+
+		xml_parse_result feed(const void* contents, size_t length)
+		{
+			if (result && append(contents, length))
+			{
+				if (encoding == encoding_auto && (size >= 4 || requested_encoding != encoding_auto))
+				{
+					encoding = get_buffer_encoding(requested_encoding, data, size);
+				#ifdef PUGIXML_WCHAR_MODE
+					// errors are reported in converted characters, which the byte scanner does not count
+					incremental = false;
+				#else
+					incremental = encoding == encoding_utf8 || encoding == encoding_latin1;
+				#endif
+
+					result.encoding = encoding;
+				}
+
+				if (incremental) process();
+			}
+
+			return result;
+		}
+
+		xml_parse_result finish()
+		{
+			if (!result) return result;
+
+			if (encoding == encoding_auto) encoding = get_buffer_encoding(requested_encoding, data, size);
+
+			if (phase == phase_prolog)
+			{
+				// the document element has not started (or the input is not scanned), so this is a regular parse of everything
+				xml_parse_result res = document.append_buffer(data, size, options, encoding);
+				if (!res) fail(res);
+			}
+			else if (phase == phase_children)
+			{
+				if (in_token && token == token_end_element && depth == 1)
+				{
+					// the stream ended inside the end tag of the document element
+					size_t begin = scan;
+
+					if (append_children(begin)) end_truncated_document();
+				}
+				else
+				{
+					// the rest goes to the parser as is, including a construct the scanner has not seen the end of
+					scan = size;
+					in_token = false;
+
+					// the stream ended inside the document element; like the regular parser, report the last character
+					if (append_children(size))
+					{
+						fail(status_end_element_mismatch, 0);
+						--result.offset;
+					}
+				}
+			}
+			else
+			{
+				// comments and processing instructions after the document element; a tail without elements is fine here
+				xml_parse_result res = document.append_buffer(data, size, options, encoding);
+				if (!res && res.status != status_no_document_element) fail(res);
+			}
+
+			result.encoding = encoding;
+
+			return result;
+		}
+	};
+PUGI__NS_END
+
+// Streaming reader
+PUGI__NS_BEGIN
+	struct xml_reader_buffer_source: xml_reader_source
+	{
+		const uint8_t* data;
+		size_t size;
+
+		xml_reader_buffer_source(): data(0), size(0)
+		{
+		}
+
+		virtual size_t read(void* buffer, size_t buffer_size)
+		{
+			size_t result = size < buffer_size ? size : buffer_size;
+
+			memcpy(buffer, data, result);
+			data += result;
+			size -= result;
+
+			return result;
+		}
+	};
+
+	// Returns the length of the prefix of raw input that consists of whole characters in the specified encoding
+	PUGI__FN size_t get_complete_prefix_length(const uint8_t* data, size_t size, xml_encoding encoding)
+	{
+		if (encoding == encoding_utf8)
+		{
+			// find the lead byte of the last sequence (at most 3 continuation bytes back)
+			size_t lead = size;
+
+			while (lead > 0 && size - lead < 4)
+			{
+				--lead;
+				if ((data[lead] & 0xc0) != 0x80) break;
+			}
+
+			if (lead == size) return size;
+
+			uint8_t ch = data[lead];
+			size_t length = (ch < 0xc0) ? 1 : (ch < 0xe0) ? 2 : (ch < 0xf0) ? 3 : 4;
+
+			return lead + length > size ? lead : size;
+		}
+
+		if (encoding == encoding_utf16_le || encoding == encoding_utf16_be)
+		{
+			size_t length = size & ~static_cast<size_t>(1);
+			if (length == 0) return 0;
+
+			// don't split a surrogate pair
+			uint8_t high = (encoding == encoding_utf16_le) ? data[length - 1] : data[length - 2];
+
+			return (high >= 0xd8 && high <= 0xdb) ? length - 2 : length;
+		}
+
+		if (encoding == encoding_utf32_le || encoding == encoding_utf32_be) return size & ~static_cast<size_t>(3);
+
+		return size;
+	}
+PUGI__NS_END
+
+// The reader state lives in pugi::impl so the chartype macros resolve; xml_reader_struct is just the name the header knows it by
+namespace pugi
+{
+namespace impl
+{
+	struct xml_reader_impl
+	{
+		size_t capacity;
+
+		// decoded input; window[begin, end) has not been consumed yet and window[end] is always 0
+		char_t* window;
+		size_t begin, end;
+		size_t consumed;
+
+		// raw input that has not been decoded yet
+		uint8_t* raw;
+		size_t raw_size;
+		bool eof;
+
+		xml_reader_source* source;
+		xml_reader_source_file file_source;
+		impl::xml_reader_buffer_source buffer_source;
+		FILE* file;
+
+		unsigned int options;
+		xml_encoding encoding;
+		bool encoding_known;
+		impl::strconv_pcdata_t strconv_pcdata;
+		impl::strconv_attribute_t strconv_attribute;
+
+		// current event
+		xml_reader_event event;
+		char_t* name;
+		char_t* value;
+		char_t** attributes; // name/value pairs
+		size_t attribute_count;
+		size_t attribute_capacity;
+
+		size_t depth;
+		bool pending_end;
+		bool seen_element;
+
+		// a character that was replaced with 0 to terminate the last text event
+		bool restore;
+		size_t restore_pos;
+		char_t restore_char;
+
+		xml_parse_status status;
+		size_t error_offset;
+
+		xml_reader_impl(size_t window_size): capacity(window_size < 64 ? 64 : window_size), window(0), begin(0), end(0), consumed(0),
+			raw(0), raw_size(0), eof(true), source(0), file_source(0), file(0), options(0), encoding(encoding_auto), encoding_known(false),
+			strconv_pcdata(0), strconv_attribute(0), event(event_none), name(0), value(0), attributes(0), attribute_count(0), attribute_capacity(0),
+			depth(0), pending_end(false), seen_element(false), restore(false), restore_pos(0), restore_char(0), status(status_ok), error_offset(0)
+		{
+		}
+
+		~xml_reader_impl()
+		{
+			close();
+
+			if (window) impl::xml_memory::deallocate(window);
+			if (raw) impl::xml_memory::deallocate(raw);
+			if (attributes) impl::xml_memory::deallocate(attributes);
+		}
+
+		void close()
+		{
+			if (file) fclose(file);
+
+			file = 0;
+			source = 0;
+			event = event_none;
+		}
+
+		bool open(xml_reader_source* source_, unsigned int options_, xml_encoding encoding_)
+		{
+			source = source_;
+			options = options_;
+			encoding = encoding_;
+			encoding_known = false;
+			strconv_pcdata = impl::get_strconv_pcdata(options);
+			strconv_attribute = impl::get_strconv_attribute(options);
+
+			begin = end = consumed = raw_size = 0;
+			eof = false;
+			event = event_none;
+			name = value = 0;
+			attribute_count = 0;
+			depth = 0;
+			pending_end = seen_element = restore = false;
+			status = status_ok;
+			error_offset = 0;
+
+			if (!window) window = static_cast<char_t*>(impl::xml_memory::allocate((capacity + 1) * sizeof(char_t)));
+			if (!raw) raw = static_cast<uint8_t*>(impl::xml_memory::allocate(capacity * sizeof(char_t) + 4));
+			if (!window || !raw)
+			{
+				fail(status_out_of_memory, 0);
+				return false;
+			}
+
+			window[0] = 0;
+			refill();
+
+			// skip BOM
+		#ifdef PUGIXML_WCHAR_MODE
+			if (window[0] == 0xfeff) begin = 1;
+		#else
+			if (end >= 3 && window[0] == '\xef' && window[1] == '\xbb' && window[2] == '\xbf') begin = 3;
+		#endif
+
+			return status == status_ok;
+		}
+
+		bool open_file(FILE* file_, unsigned int options_, xml_encoding encoding_)
+		{
+			if (!file_)
+			{
+				fail(status_file_not_found, 0);
+				return false;
+			}
+
+			file = file_;
+			file_source = xml_reader_source_file(file_);
+
+			return open(&file_source, options_, encoding_);
+		}
+
+		xml_reader_event fail(xml_parse_status status_, size_t pos)
+		{
+			status = status_;
+			error_offset = consumed + pos;
+
+			return event = event_error;
+		}
+
+		bool is_native_encoding() const
+		{
+		#ifdef PUGIXML_WCHAR_MODE
+			return false; // convert_buffer takes care of endian swapping and utf16/utf32 wchar_t
+		#else
+			return encoding == encoding_utf8;
+		#endif
+		}
+
+		// Moves unconsumed data to the start of the window and decodes more input into the free space; returns false if no characters were added
+		bool refill()
+		{
+			if (begin > 0)
+			{
+				memmove(window, window + begin, (end - begin) * sizeof(char_t));
+				consumed += begin;
+				end -= begin;
+				begin = 0;
+				window[end] = 0;
+			}
+
+			size_t old_end = end;
+
+			while (end == old_end && (!eof || raw_size > 0))
+			{
+				// every input byte decodes to at most 2 char_t (latin1 to utf8), so size the read to always fit
+				size_t space = capacity - end;
+				size_t raw_limit = is_native_encoding() ? space * sizeof(char_t) : space / 2;
+
+				if (raw_limit <= raw_size) break;
+
+				if (!eof)
+				{
+					size_t read = source->read(raw + raw_size, raw_limit - raw_size);
+					if (read == 0) eof = true;
+					raw_size += read;
+				}
+
+				// wait for enough input to detect the encoding
+				if (!encoding_known)
+				{
+					if (raw_size < 4 && !eof) continue;
+
+					encoding = impl::get_buffer_encoding(encoding, raw, raw_size);
+					encoding_known = true;
+				}
+
+				size_t length = (eof || is_native_encoding()) ? raw_size : impl::get_complete_prefix_length(raw, raw_size, encoding);
+
+				if (is_native_encoding())
+				{
+					memcpy(window + end, raw, length);
+					end += length / sizeof(char_t);
+				}
+				else if (length > 0)
+				{
+					char_t* buffer = 0;
+					size_t buffer_length = 0;
+
+					if (!impl::convert_buffer(buffer, buffer_length, encoding, raw, length, false))
+					{
+						fail(status_out_of_memory, end);
+						return false;
+					}
+
+					// converted buffers are 0-terminated and the terminator is included in the length
+					assert(buffer_length > 0 && end + buffer_length - 1 <= capacity);
+					memcpy(window + end, buffer, (buffer_length - 1) * sizeof(char_t));
+					end += buffer_length - 1;
+
+					impl::xml_memory::deallocate(buffer);
+				}
+
+				memmove(raw, raw + length, raw_size - length);
+				raw_size -= length;
+			}
+
+			window[end] = 0;
+
+			return end > old_end;
+		}
+
+		// After refill() returns false: true if that was because the window is full rather than because the input ended
+		bool window_full() const
+		{
+			return !eof || raw_size > 0;
+		}
+
+		// Finds pattern at or after begin + offset, reading more input as needed; returns offset from begin or -1
+		ptrdiff_t find(size_t offset, const char_t* pattern)
+		{
+			size_t length = impl::strlength(pattern);
+
+			for (;;)
+			{
+				for (size_t i = begin + offset; i + length <= end; ++i)
+					if (window[i] == pattern[0] && memcmp(window + i, pattern, length * sizeof(char_t)) == 0)
+						return static_cast<ptrdiff_t>(i - begin);
+
+				if (!refill()) return -1;
+			}
+		}
+
+		// Skips everything up to and including pattern, discarding input as it goes so that the skipped data can be larger than the window
+		bool skip(size_t offset, const char_t* pattern)
+		{
+			size_t length = impl::strlength(pattern);
+
+			for (;;)
+			{
+				for (size_t i = begin + offset; i + length <= end; ++i)
+					if (window[i] == pattern[0] && memcmp(window + i, pattern, length * sizeof(char_t)) == 0)
+					{
+						begin = i + length;
+						return true;
+					}
+
+				// keep the last length - 1 characters in case the pattern straddles the refill
+				size_t keep = end - begin - offset < length - 1 ? end - begin - offset : length - 1;
+				begin = end - keep;
+				offset = 0;
+
+				if (!refill()) return false;
+			}
+		}
+
+		bool skip_doctype()
+		{
+			size_t i = begin + 2;
+			int bracket_depth = 0;
+
+			for (;;)
+			{
+				for (; i < end; ++i)
+				{
+					if (window[i] == '[') ++bracket_depth;
+					else if (window[i] == ']') --bracket_depth;
+					else if (window[i] == '>' && bracket_depth <= 0)
+					{
+						begin = i + 1;
+						return true;
+					}
+				}
+
+				begin = i = end;
+
+				if (!refill()) return false;
+
+				i = begin;
+			}
+		}
+
+		// Finds the '>' that ends a start tag, skipping over quoted attribute values; returns offset from begin or -1
+		ptrdiff_t find_tag_end()
+		{
+			for (;;)
+			{
+				char_t quote = 0;
+
+				for (size_t i = begin + 1; i < end; ++i)
+				{
+					if (quote)
+					{
+						if (window[i] == quote) quote = 0;
+					}
+					else if (window[i] == '"' || window[i] == '\'') quote = window[i];
+					else if (window[i] == '>') return static_cast<ptrdiff_t>(i - begin);
+				}
+
+				if (!refill()) return -1;
+			}
+		}
+
+		bool push_attribute(char_t* attr_name, char_t* attr_value)
+		{
+			if (attribute_count == attribute_capacity)
+			{
+				size_t new_capacity = attribute_capacity ? attribute_capacity * 2 : 16;
+
+				char_t** new_attributes = static_cast<char_t**>(impl::xml_memory::allocate(new_capacity * 2 * sizeof(char_t*)));
+				if (!new_attributes) return false;
+
+				if (attributes)
+				{
+					memcpy(new_attributes, attributes, attribute_count * 2 * sizeof(char_t*));
+					impl::xml_memory::deallocate(attributes);
+				}
+
+				attributes = new_attributes;
+				attribute_capacity = new_capacity;
+			}
+
+			attributes[attribute_count * 2] = attr_name;
+			attributes[attribute_count * 2 + 1] = attr_value;
+			++attribute_count;
+
+			return true;
+		}
+
+		// Returns where a run of text that does not fit in the window can be split without breaking a character, CR/LF pair or entity
+		size_t text_split()
+		{
+			size_t cut = end;
+
+		#ifdef PUGIXML_WCHAR_MODE
+			if (sizeof(wchar_t) == 2 && cut > begin && static_cast<unsigned int>(window[cut - 1]) - 0xd800 < 0x400) --cut;
+		#else
+			cut = begin + impl::get_complete_prefix_length(reinterpret_cast<uint8_t*>(window + begin), cut - begin, encoding_utf8);
+		#endif
+
+			if (cut > begin && window[cut - 1] == '\r') --cut;
+
+			for (size_t i = cut; i > begin && cut - i < 16; --i)
+			{
+				if (window[i - 1] == ';') break;
+				if (window[i - 1] == '&')
+				{
+					cut = i - 1;
+					break;
+				}
+			}
+
+			return cut > begin ? cut : end;
+		}
+
+		xml_reader_event read_text()
+		{
+			size_t cut = begin;
+			while (cut < end && window[cut] != '<') ++cut;
+
+			if (cut == end)
+			{
+				if (refill()) return event_none; // try again with more data
+
+				// refill moved the data to the start of the window even if it did not add any
+				cut = eof ? end : text_split();
+			}
+
+			bool ws_only = true;
+			for (size_t i = begin; i < cut && ws_only; ++i)
+				ws_only = PUGI__IS_CHARTYPE(window[i], ct_space) != 0;
+
+			// text outside of the document element is ignored, just like in xml_document
+			if (depth == 0 || (ws_only && !(options & parse_ws_pcdata)))
+			{
+				begin = cut;
+				return event_none;
+			}
+
+			restore = true;
+			restore_pos = cut;
+			restore_char = window[cut];
+			window[cut] = 0;
+
+			value = window + begin;
+			strconv_pcdata(value);
+			begin = cut;
+
+			return event = event_text;
+		}
+
+		xml_reader_event read_start_element()
+		{
+			ptrdiff_t tag_end = find_tag_end();
+			if (tag_end < 0) return fail(window_full() ? status_out_of_memory : status_bad_start_element, end);
+
+			char_t* s = window + begin + 1;
+
+			name = s;
+			PUGI__SCANWHILE(PUGI__IS_CHARTYPE(*s, ct_symbol));
+			char_t* name_end = s;
+
+			for (;;)
+			{
+				PUGI__SKIPWS();
+
+				if (*s == '>')
+				{
+					++s;
+					break;
+				}
+				else if (*s == '/')
+				{
+					if (s[1] != '>') return fail(status_bad_start_element, s - window);
+
+					pending_end = true;
+					s += 2;
+					break;
+				}
+				else if (PUGI__IS_CHARTYPE(*s, ct_start_symbol))
+				{
+					char_t* attr_name = s;
+					PUGI__SCANWHILE(PUGI__IS_CHARTYPE(*s, ct_symbol));
+					char_t* attr_name_end = s;
+
+					PUGI__SKIPWS();
+					if (*s != '=') return fail(status_bad_attribute, s - window);
+					++s;
 
-		stream.read(static_cast<T*>(buffer.data), static_cast<std::streamsize>(read_length));
+					PUGI__SKIPWS();
+					if (*s != '"' && *s != '\'') return fail(status_bad_attribute, s - window);
+					char_t quote = *s++;
 
-		// read may set failbit | eofbit in case gcount() is less than read_length (i.e. line ending conversion), so check for other I/O errors
-		if (stream.bad() || (!stream.eof() && stream.fail())) return status_io_error;
+					*attr_name_end = 0;
 
-		// return buffer
-		size_t actual_length = static_cast<size_t>(stream.gcount());
-		assert(actual_length <= read_length);
-		
-		*out_buffer = buffer.release();
-		*out_size = actual_length * sizeof(T);
+					char_t* attr_value = s;
+					s = strconv_attribute(s, quote);
+					if (!s) return fail(status_bad_attribute, attr_value - window);
 
-		return status_ok;
-	}
+					if (!push_attribute(attr_name, attr_value)) return fail(status_out_of_memory, attr_name - window);
+				}
+				else return fail(status_bad_start_element, s - window);
+			}
 
-	template <typename T> PUGI__FN xml_parse_result load_stream_impl(xml_document& doc, std::basic_istream<T>& stream, unsigned int options, xml_encoding encoding)
-	{
-		void* buffer = 0;
-		size_t size = 0;
-		xml_parse_status status = status_ok;
+			*name_end = 0;
+			begin = s - window;
 
-		// if stream has an error bit set, bail out (otherwise tellg() can fail and we'll clear error bits)
-		if (stream.fail()) return make_parse_result(status_io_error);
+			++depth;
+			seen_element = true;
 
-		// load stream to memory (using seek-based implementation if possible, since it's faster and takes less memory)
-		if (stream.tellg() < 0)
-		{
-			stream.clear(); // clear error flags that could be set by a failing tellg
-			status = load_stream_data_noseek(stream, &buffer, &size);
+			return event = event_start_element;
 		}
-		else
-			status = load_stream_data_seek(stream, &buffer, &size);
 
-		if (status != status_ok) return make_parse_result(status);
+		xml_reader_event read_end_element()
+		{
+			ptrdiff_t tag_end = find(2, PUGIXML_TEXT(">"));
+			if (tag_end < 0) return fail(window_full() ? status_out_of_memory : status_bad_end_element, end);
 
-		xml_encoding real_encoding = get_buffer_encoding(encoding, buffer, size);
-		
-		return doc.load_buffer_inplace_own(buffer, zero_terminate_buffer(buffer, size, real_encoding), options, real_encoding);
-	}
-#endif
+			char_t* s = window + begin + 2;
+			if (!PUGI__IS_CHARTYPE(*s, ct_start_symbol)) return fail(status_bad_end_element, s - window);
 
-#if defined(PUGI__MSVC_CRT_VERSION) || defined(__BORLANDC__) || (defined(__MINGW32__) && (!defined(__STRICT_ANSI__) || defined(__MINGW64_VERSION_MAJOR)))
-	PUGI__FN FILE* open_file_wide(const wchar_t* path, const wchar_t* mode)
-	{
-		return _wfopen(path, mode);
-	}
-#else
-	PUGI__FN char* convert_path_heap(const wchar_t* str)
-	{
-		assert(str);
+			name = s;
+			PUGI__SCANWHILE(PUGI__IS_CHARTYPE(*s, ct_symbol));
+			char_t* name_end = s;
 
-		// first pass: get length in utf8 characters
-		size_t length = strlength_wide(str);
-		size_t size = as_utf8_begin(str, length);
+			PUGI__SKIPWS();
+			if (*s != '>') return fail(status_bad_end_element, s - window);
 
-		// allocate resulting string
-		char* result = static_cast<char*>(xml_memory::allocate(size + 1));
-		if (!result) return 0;
+			*name_end = 0;
+			begin = s + 1 - window;
 
-		// second pass: convert to utf8
-		as_utf8_end(result, size, str, length);
+			if (depth == 0) return fail(status_end_element_mismatch, name - window);
+			--depth;
 
-		return result;
-	}
+			return event = event_end_element;
+		}
 
-	PUGI__FN FILE* open_file_wide(const wchar_t* path, const wchar_t* mode)
-	{
-		// there is no standard function to open wide paths, so our best bet is to try utf8 path
-		char* path_utf8 = convert_path_heap(path);
-		if (!path_utf8) return 0;
+		xml_reader_event read_cdata()
+		{
+			ptrdiff_t cdata_end = find(9, PUGIXML_TEXT("]]>"));
+			if (cdata_end < 0) return fail(window_full() ? status_out_of_memory : status_bad_cdata, end);
 
-		// convert mode to ASCII (we mirror _wfopen interface)
-		char mode_ascii[4] = {0};
-		for (size_t i = 0; mode[i]; ++i) mode_ascii[i] = static_cast<char>(mode[i]);
+			char_t* s = window + begin + 9;
+			begin += cdata_end + 3;
 
-		// try to open the utf8 path
-		FILE* result = fopen(path_utf8, mode_ascii);
+			if (depth == 0 || !(options & parse_cdata)) return event_none;
 
-		// free dummy buffer
-		xml_memory::deallocate(path_utf8);
+			value = s;
 
-		return result;
-	}
-#endif
+			if (options & parse_eol) impl::strconv_cdata(s, 0);
+			else window[begin - 3] = 0;
 
-	PUGI__FN bool save_file_impl(const xml_document& doc, FILE* file, const char_t* indent, unsigned int flags, xml_encoding encoding)
-	{
-		if (!file) return false;
+			return event = event_text;
+		}
 
-		xml_writer_file writer(file);
-		doc.save(writer, indent, flags, encoding);
+		xml_reader_event next()
+		{
+			if (!source || event == event_error || event == event_end_document) return event;
 
-		int result = ferror(file);
+			if (restore)
+			{
+				window[restore_pos] = restore_char;
+				restore = false;
+			}
 
-		fclose(file);
+			if (pending_end)
+			{
+				pending_end = false;
+				attribute_count = 0;
+				--depth;
 
-		return result == 0;
-	}
+				return event = event_end_element;
+			}
 
-	PUGI__FN xml_parse_result load_buffer_impl(xml_document_struct* doc, xml_node_struct* root, void* contents, size_t size, unsigned int options, xml_encoding encoding, bool is_mutable, bool own, char_t** out_buffer)
-	{
-		// check input buffer
-		assert(contents || size == 0);
+			name = value = 0;
+			attribute_count = 0;
 
-		// get actual encoding
-		xml_encoding buffer_encoding = impl::get_buffer_encoding(encoding, contents, size);
+			for (;;)
+			{
+				if (begin == end && !refill())
+				{
+					if (status != status_ok) return event_error;
+					if (depth > 0) return fail(status_end_element_mismatch, end);
+					if (!seen_element) return fail(status_no_document_element, end);
 
-		// get private buffer
-		char_t* buffer = 0;
-		size_t length = 0;
+					return event = event_end_document;
+				}
 
-		if (!impl::convert_buffer(buffer, length, buffer_encoding, contents, size, is_mutable)) return impl::make_parse_result(status_out_of_memory);
-		
-		// delete original buffer if we performed a conversion
-		if (own && buffer != contents && contents) impl::xml_memory::deallocate(contents);
+				xml_reader_event result = event_none;
 
-		// store buffer for offset_debug
-		doc->buffer = buffer;
+				if (window[begin] != '<')
+				{
+					result = read_text();
+				}
+				else
+				{
+					// make sure the markup type can be told apart
+					while (end - begin < 9 && refill()) {}
 
-		// parse
-		xml_parse_result res = impl::xml_parser::parse(buffer, length, doc, root, options);
+					char_t* s = window + begin;
 
-		// remember encoding
-		res.encoding = buffer_encoding;
+					if (s[1] == '/') result = read_end_element();
+					else if (s[1] == '?')
+					{
+						if (!skip(2, PUGIXML_TEXT("?>"))) return fail(status_bad_pi, end);
+					}
+					else if (s[1] == '!' && s[2] == '-' && s[3] == '-')
+					{
+						if (!skip(4, PUGIXML_TEXT("-->"))) return fail(status_bad_comment, end);
+					}
+					else if (s[1] == '!' && s[2] == '[' && s[3] == 'C' && s[4] == 'D' && s[5] == 'A' && s[6] == 'T' && s[7] == 'A' && s[8] == '[')
+						result = read_cdata();
+					else if (s[1] == '!')
+					{
+						if (!skip_doctype()) return fail(status_bad_doctype, end);
+					}
+					else if (PUGI__IS_CHARTYPE(s[1], ct_start_symbol)) result = read_start_element();
+					else return fail(status_unrecognized_tag, begin);
+				}
 
-		// grab onto buffer if it's our buffer, user is responsible for deallocating contents himself
-		if (own || buffer != contents) *out_buffer = buffer;
+				if (result != event_none) return result;
+			}
+		}
+	};
+}
 
-		return res;
-	}
-PUGI__NS_END
+	struct xml_reader_struct: impl::xml_reader_impl
+	{
+		explicit xml_reader_struct(size_t window_size): impl::xml_reader_impl(window_size)
+		{
+		}
+	};
+}
 
 namespace pugi
 {
@@ -4369,6 +7103,55 @@ namespace pugi
 	}
 #endif
 
+#ifdef PUGIXML_HAS_POSIX_IO
+	PUGI__FN xml_writer_fd::xml_writer_fd(int fd): _fd(fd), _error(0), _size(0)
+	{
+	}
+
+	PUGI__FN xml_writer_fd::~xml_writer_fd()
+	{
+		flush();
+	}
+
+	PUGI__FN void xml_writer_fd::write(const void* data, size_t size)
+	{
+		if (_size + size <= sizeof(_buffer))
+		{
+			memcpy(_buffer + _size, data, size);
+			_size += size;
+		}
+		else
+		{
+			// the chunk does not have to be copied if it goes out together with the collected data
+			iovec chunks[2];
+
+			chunks[0].iov_base = _buffer;
+			chunks[0].iov_len = _size;
+			chunks[1].iov_base = const_cast<void*>(data);
+			chunks[1].iov_len = size;
+
+			impl::write_fd(_fd, chunks, 2, _error);
+			_size = 0;
+		}
+	}
+
+	PUGI__FN void xml_writer_fd::flush()
+	{
+		iovec chunk;
+
+		chunk.iov_base = _buffer;
+		chunk.iov_len = _size;
+
+		impl::write_fd(_fd, &chunk, 1, _error);
+		_size = 0;
+	}
+
+	PUGI__FN int xml_writer_fd::error() const
+	{
+		return _error;
+	}
+#endif
+
 	PUGI__FN xml_tree_walker::xml_tree_walker(): _depth(0)
 	{
 	}
@@ -4544,6 +7327,12 @@ namespace pugi
 		set_value(rhs);
 		return *this;
 	}
+
+	PUGI__FN xml_attribute& xml_attribute::operator=(float rhs)
+	{
+		set_value(rhs);
+		return *this;
+	}
 	
 	PUGI__FN xml_attribute& xml_attribute::operator=(bool rhs)
 	{
@@ -4599,6 +7388,13 @@ namespace pugi
 
 		return impl::set_value_convert(_attr->value, _attr->header, impl::xml_memory_page_value_allocated_mask, rhs);
 	}
+
+	PUGI__FN bool xml_attribute::set_value(float rhs)
+	{
+		if (!_attr) return false;
+
+		return impl::set_value_convert(_attr->value, _attr->header, impl::xml_memory_page_value_allocated_mask, rhs);
+	}
 	
 	PUGI__FN bool xml_attribute::set_value(bool rhs)
 	{
@@ -4659,7 +7455,7 @@ namespace pugi
 
 	PUGI__FN xml_node::iterator xml_node::begin() const
 	{
-		return iterator(_root ? _root->first_child : 0, _root);
+		return iterator(_root ? _root->first_child + 0 : 0, _root);
 	}
 
 	PUGI__FN xml_node::iterator xml_node::end() const
@@ -4669,7 +7465,7 @@ namespace pugi
 	
 	PUGI__FN xml_node::attribute_iterator xml_node::attributes_begin() const
 	{
-		return attribute_iterator(_root ? _root->first_attribute : 0, _root);
+		return attribute_iterator(_root ? _root->first_attribute + 0 : 0, _root);
 	}
 
 	PUGI__FN xml_node::attribute_iterator xml_node::attributes_end() const
@@ -5246,8 +8042,12 @@ namespace pugi
 		// add extra buffer to the list
 		extra->buffer = buffer;
 		extra->next = doc->extra_buffers;
+		extra->mapping_size = 0;
 		doc->extra_buffers = extra;
 
+		// a chunked load appends many times and updates the index once, in load_end
+		if (!doc->push) impl::update_attribute_index(doc);
+
 		return res;
 	}
 
@@ -5610,6 +8410,13 @@ namespace pugi
 		return dn ? impl::set_value_convert(dn->value, dn->header, impl::xml_memory_page_value_allocated_mask, rhs) : false;
 	}
 
+	PUGI__FN bool xml_text::set(float rhs)
+	{
+		xml_node_struct* dn = _data_new();
+
+		return dn ? impl::set_value_convert(dn->value, dn->header, impl::xml_memory_page_value_allocated_mask, rhs) : false;
+	}
+
 	PUGI__FN bool xml_text::set(bool rhs)
 	{
 		xml_node_struct* dn = _data_new();
@@ -5657,6 +8464,12 @@ namespace pugi
 		return *this;
 	}
 
+	PUGI__FN xml_text& xml_text::operator=(float rhs)
+	{
+		set(rhs);
+		return *this;
+	}
+
 	PUGI__FN xml_text& xml_text::operator=(bool rhs)
 	{
 		set(rhs);
@@ -5933,14 +8746,147 @@ namespace pugi
 
 	PUGI__FN xml_document::~xml_document()
 	{
-		destroy();
+		destroy(false);
 	}
 
 	PUGI__FN void xml_document::reset()
 	{
-		destroy();
+		impl::xml_document_struct* doc = static_cast<impl::xml_document_struct*>(_root);
+
+		destroy(true);
+
+		// the new document structure is constructed in the same storage, so carry the pool over by hand
+		impl::xml_page_pool pool = doc->_pool;
+	#ifdef PUGIXML_COMPACT
+		impl::compact_hash_table hash = doc->_hash;
+	#endif
+		impl::xml_attribute_index* index = doc->attribute_index;
+
+		create();
+
+		static_cast<impl::xml_document_struct*>(_root)->_pool = pool;
+	#ifdef PUGIXML_COMPACT
+		static_cast<impl::xml_document_struct*>(_root)->_hash = hash;
+	#endif
+		static_cast<impl::xml_document_struct*>(_root)->attribute_index = index;
+
+	#ifndef PUGIXML_NO_XPATH
+		if (index) index->current = false;
+	#endif
+	}
+
+	PUGI__FN void xml_document::set_memory_reuse(bool reuse)
+	{
+		impl::xml_document_struct* doc = static_cast<impl::xml_document_struct*>(_root);
+
+		doc->_pool.reuse = reuse;
+
+		// pages in use go back to the heap as usual once they are freed, only the kept ones have to go now
+		if (!reuse && !doc->_pool.arena) doc->release_pool();
+	}
+
+	PUGI__FN void xml_document::set_arena(void* memory, size_t size)
+	{
+		impl::xml_document_struct* doc = static_cast<impl::xml_document_struct*>(_root);
+
+		bool reuse = doc->_pool.reuse;
+
+		// registered attribute indexes stay, the rest of the document goes
+		impl::xml_attribute_index* index = doc->attribute_index;
+		doc->attribute_index = 0;
+
+		destroy(false);
 		create();
+
+		doc = static_cast<impl::xml_document_struct*>(_root);
+
+		doc->_pool.reuse = reuse;
+		doc->_pool.arena = memory ? static_cast<char*>(memory) : 0;
+		doc->_pool.arena_size = memory ? size : 0;
+		doc->attribute_index = index;
+
+	#ifndef PUGIXML_NO_XPATH
+		if (index) index->current = false;
+	#endif
+	}
+
+#ifndef PUGIXML_NO_XPATH
+	PUGI__FN bool xml_document::add_attribute_index(const char_t* element, const char_t* attribute)
+	{
+		impl::xml_document_struct* doc = static_cast<impl::xml_document_struct*>(_root);
+
+		if (!element || !*element || !attribute || !*attribute) return false;
+
+		impl::xml_attribute_index* index = doc->attribute_index;
+
+		if (!index)
+		{
+			void* memory = impl::xml_memory::allocate(sizeof(impl::xml_attribute_index));
+			if (!memory) return false;
+
+			index = static_cast<impl::xml_attribute_index*>(memory);
+			memset(index, 0, sizeof(impl::xml_attribute_index));
+
+			doc->attribute_index = index;
+		}
+
+		for (size_t i = 0; i < index->key_count; ++i)
+			if (impl::strequal(index->keys[i].element, element) && impl::strequal(index->keys[i].attribute, attribute))
+			{
+				// registering a pair again brings the index up to date after changes to the tree
+				impl::update_attribute_index(doc);
+
+				return true;
+			}
+
+		size_t element_size = (impl::strlength(element) + 1) * sizeof(char_t);
+		size_t attribute_size = (impl::strlength(attribute) + 1) * sizeof(char_t);
+
+		impl::xml_attribute_index_key* keys = static_cast<impl::xml_attribute_index_key*>(impl::xml_memory::allocate((index->key_count + 1) * sizeof(impl::xml_attribute_index_key)));
+		char_t* element_copy = static_cast<char_t*>(impl::xml_memory::allocate(element_size));
+		char_t* attribute_copy = static_cast<char_t*>(impl::xml_memory::allocate(attribute_size));
+
+		if (!keys || !element_copy || !attribute_copy)
+		{
+			if (keys) impl::xml_memory::deallocate(keys);
+			if (element_copy) impl::xml_memory::deallocate(element_copy);
+			if (attribute_copy) impl::xml_memory::deallocate(attribute_copy);
+
+			return false;
+		}
+
+		memcpy(element_copy, element, element_size);
+		memcpy(attribute_copy, attribute, attribute_size);
+
+		if (index->keys)
+		{
+			memcpy(keys, index->keys, index->key_count * sizeof(impl::xml_attribute_index_key));
+			impl::xml_memory::deallocate(index->keys);
+		}
+
+		keys[index->key_count].element = element_copy;
+		keys[index->key_count].attribute = attribute_copy;
+
+		index->keys = keys;
+		index->key_count++;
+		index->current = false;
+
+		impl::update_attribute_index(doc);
+
+		return true;
+	}
+
+	PUGI__FN void xml_document::clear_attribute_indexes()
+	{
+		impl::xml_document_struct* doc = static_cast<impl::xml_document_struct*>(_root);
+
+		if (doc->attribute_index)
+		{
+			impl::destroy_attribute_index(doc->attribute_index);
+			doc->attribute_index = 0;
+		}
 	}
+#endif
 
 	PUGI__FN void xml_document::reset(const xml_document& proto)
 	{
@@ -5948,6 +8894,8 @@ namespace pugi
 
 		for (xml_node cur = proto.first_child(); cur; cur = cur.next_sibling())
 			append_copy(cur);
+
+		impl::update_attribute_index(static_cast<impl::xml_document_struct*>(_root));
 	}
 
 	PUGI__FN void xml_document::create()
@@ -5977,10 +8925,12 @@ namespace pugi
 		assert(reinterpret_cast<char*>(_root) + sizeof(impl::xml_document_struct) <= _memory + sizeof(_memory));
 	}
 
-	PUGI__FN void xml_document::destroy()
+	PUGI__FN void xml_document::destroy(bool keep_pages)
 	{
 		assert(_root);
 
+		impl::xml_document_struct* doc = static_cast<impl::xml_document_struct*>(_root);
+
 		// destroy static storage
 		if (_buffer)
 		{
@@ -5989,13 +8939,21 @@ namespace pugi
 		}
 
 		// destroy extra buffers (note: no need to destroy linked list nodes, they're allocated using document allocator)
-		for (impl::xml_extra_buffer* extra = static_cast<impl::xml_document_struct*>(_root)->extra_buffers; extra; extra = extra->next)
+		for (impl::xml_extra_buffer* extra = doc->extra_buffers; extra; extra = extra->next)
 		{
+		#ifdef PUGIXML_HAS_POSIX_IO
+			if (extra->mapping_size)
+			{
+				munmap(extra->buffer, extra->mapping_size);
+				continue;
+			}
+		#endif
+
 			if (extra->buffer) impl::xml_memory::deallocate(extra->buffer);
 		}
 
 		// destroy dynamic storage, leave sentinel page (it's in static memory)
-		impl::xml_memory_page* root_page = reinterpret_cast<impl::xml_memory_page*>(_root->header & impl::xml_memory_page_pointer_mask);
+		impl::xml_memory_page* root_page = PUGI__GETPAGE(_root);
 		assert(root_page && !root_page->prev);
 		assert(reinterpret_cast<char*>(root_page) >= _memory && reinterpret_cast<char*>(root_page) < _memory + sizeof(_memory));
 
@@ -6003,11 +8961,31 @@ namespace pugi
 		{
 			impl::xml_memory_page* next = page->next;
 
-			impl::xml_allocator::deallocate_page(page);
+			if (keep_pages) doc->release_page(page);
+			else if (!doc->_pool.arena) impl::xml_allocator::deallocate_page(page);
 
 			page = next;
 		}
 
+		// arena pages are all handed out again from the start of the arena
+		if (!keep_pages || doc->_pool.arena) doc->release_pool();
+
+	#ifdef PUGIXML_COMPACT
+		if (keep_pages) doc->_hash.clear();
+		else doc->_hash.release();
+	#endif
+
+	#ifndef PUGIXML_NO_XPATH
+		if (!keep_pages && doc->attribute_index) impl::destroy_attribute_index(doc->attribute_index);
+	#endif
+
+		if (doc->push)
+		{
+			doc->push->~xml_push_parser();
+			impl::xml_memory::deallocate(doc->push);
+			doc->push = 0;
+		}
+
 		_root = 0;
 	}
 
@@ -6016,14 +8994,20 @@ namespace pugi
 	{
 		reset();
 
-		return impl::load_stream_impl(*this, stream, options, encoding);
+		xml_parse_result result = impl::load_stream_impl(*this, stream, options, encoding);
+		impl::update_attribute_index(static_cast<impl::xml_document_struct*>(_root));
+
+		return result;
 	}
 
 	PUGI__FN xml_parse_result xml_document::load(std::basic_istream<wchar_t, std::char_traits<wchar_t> >& stream, unsigned int options)
 	{
 		reset();
 
-		return impl::load_stream_impl(*this, stream, options, encoding_wchar);
+		xml_parse_result result = impl::load_stream_impl(*this, stream, options, encoding_wchar);
+		impl::update_attribute_index(static_cast<impl::xml_document_struct*>(_root));
+
+		return result;
 	}
 #endif
 
@@ -6050,7 +9034,10 @@ namespace pugi
 
 		FILE* file = fopen(path_, "rb");
 
-		return impl::load_file_impl(*this, file, options, encoding);
+		xml_parse_result result = impl::load_file_impl(*this, file, options, encoding);
+		impl::update_attribute_index(static_cast<impl::xml_document_struct*>(_root));
+
+		return result;
 	}
 
 	PUGI__FN xml_parse_result xml_document::load_file(const wchar_t* path_, unsigned int options, xml_encoding encoding)
@@ -6059,28 +9046,166 @@ namespace pugi
 
 		FILE* file = impl::open_file_wide(path_, L"rb");
 
-		return impl::load_file_impl(*this, file, options, encoding);
+		xml_parse_result result = impl::load_file_impl(*this, file, options, encoding);
+		impl::update_attribute_index(static_cast<impl::xml_document_struct*>(_root));
+
+		return result;
+	}
+
+#ifdef PUGIXML_HAS_POSIX_IO
+	PUGI__FN xml_parse_result xml_document::load_file_mmap(const char* path_, unsigned int options, xml_encoding encoding)
+	{
+		reset();
+
+		int fd = open(path_, O_RDONLY);
+		if (fd < 0) return impl::make_parse_result(status_file_not_found);
+
+		struct stat info;
+
+		if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode))
+		{
+			close(fd);
+			return impl::make_parse_result(status_io_error);
+		}
+
+		// check for overflow
+		size_t size = static_cast<size_t>(info.st_size);
+
+		if (static_cast<off_t>(size) != info.st_size || size > ~static_cast<size_t>(0) / 2)
+		{
+			close(fd);
+			return impl::make_parse_result(status_out_of_memory);
+		}
+
+		// the file is mapped over zero pages that extend at least one character past its end, which leaves room for the terminator
+		size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+		size_t mapping_size = (size + sizeof(char_t) + page_size - 1) / page_size * page_size;
+
+		void* mapping = mmap(0, mapping_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+		if (mapping == MAP_FAILED)
+		{
+			close(fd);
+			return impl::make_parse_result(status_out_of_memory);
+		}
+
+		// parsing writes terminators into nearly every page; populating a private writable mapping copies them all in one pass,
+		// which is cheaper than taking a copy-on-write fault per page
+		int flags = MAP_PRIVATE | MAP_FIXED;
+	#ifdef MAP_POPULATE
+		flags |= MAP_POPULATE;
+	#endif
+
+		if (size > 0 && mmap(mapping, size, PROT_READ | PROT_WRITE, flags, fd, 0) == MAP_FAILED)
+		{
+			munmap(mapping, mapping_size);
+			close(fd);
+			return impl::make_parse_result(status_io_error);
+		}
+
+		close(fd);
+
+		impl::xml_document_struct* doc = static_cast<impl::xml_document_struct*>(_root);
+
+		// the mapping is kept in the extra buffer list so that destroy() unmaps it
+		impl::xml_memory_page* page = 0;
+		impl::xml_extra_buffer* extra = static_cast<impl::xml_extra_buffer*>(doc->allocate_memory(sizeof(impl::xml_extra_buffer), page));
+		(void)page;
+
+		if (!extra)
+		{
+			munmap(mapping, mapping_size);
+			return impl::make_parse_result(status_out_of_memory);
+		}
+
+		extra->buffer = static_cast<char_t*>(mapping);
+		extra->next = doc->extra_buffers;
+		extra->mapping_size = mapping_size;
+		doc->extra_buffers = extra;
+
+		xml_encoding real_encoding = impl::get_buffer_encoding(encoding, mapping, size);
+
+		xml_parse_result result = impl::load_buffer_impl(doc, _root, mapping, impl::zero_terminate_buffer(mapping, size, real_encoding), options, real_encoding, true, false, &_buffer);
+
+		// the document got a converted copy, so the mapping is not needed anymore
+		if (_buffer)
+		{
+			munmap(mapping, mapping_size);
+
+			extra->buffer = 0;
+			extra->mapping_size = 0;
+		}
+
+		impl::update_attribute_index(doc);
+
+		return result;
 	}
+#endif
 
 	PUGI__FN xml_parse_result xml_document::load_buffer(const void* contents, size_t size, unsigned int options, xml_encoding encoding)
 	{
 		reset();
 
-		return impl::load_buffer_impl(static_cast<impl::xml_document_struct*>(_root), _root, const_cast<void*>(contents), size, options, encoding, false, false, &_buffer);
+		xml_parse_result result = impl::load_buffer_impl(static_cast<impl::xml_document_struct*>(_root), _root, const_cast<void*>(contents), size, options, encoding, false, false, &_buffer);
+		impl::update_attribute_index(static_cast<impl::xml_document_struct*>(_root));
+
+		return result;
 	}
 
 	PUGI__FN xml_parse_result xml_document::load_buffer_inplace(void* contents, size_t size, unsigned int options, xml_encoding encoding)
 	{
 		reset();
 
-		return impl::load_buffer_impl(static_cast<impl::xml_document_struct*>(_root), _root, contents, size, options, encoding, true, false, &_buffer);
+		xml_parse_result result = impl::load_buffer_impl(static_cast<impl::xml_document_struct*>(_root), _root, contents, size, options, encoding, true, false, &_buffer);
+		impl::update_attribute_index(static_cast<impl::xml_document_struct*>(_root));
+
+		return result;
 	}
 
 	PUGI__FN xml_parse_result xml_document::load_buffer_inplace_own(void* contents, size_t size, unsigned int options, xml_encoding encoding)
 	{
 		reset();
 
-		return impl::load_buffer_impl(static_cast<impl::xml_document_struct*>(_root), _root, contents, size, options, encoding, true, true, &_buffer);
+		xml_parse_result result = impl::load_buffer_impl(static_cast<impl::xml_document_struct*>(_root), _root, contents, size, options, encoding, true, true, &_buffer);
+		impl::update_attribute_index(static_cast<impl::xml_document_struct*>(_root));
+
+		return result;
+	}
+
+	PUGI__FN bool xml_document::load_begin(unsigned int options, xml_encoding encoding)
+	{
+		reset();
+
+		void* memory = impl::xml_memory::allocate(sizeof(impl::xml_push_parser));
+		if (!memory) return false;
+
+		static_cast<impl::xml_document_struct*>(_root)->push = new (memory) impl::xml_push_parser(*this, options, encoding);
+
+		return true;
+	}
+
+	PUGI__FN xml_parse_result xml_document::load_chunk(const void* contents, size_t size)
+	{
+		impl::xml_push_parser* push = static_cast<impl::xml_document_struct*>(_root)->push;
+		if (!push) return impl::make_parse_result(status_internal_error);
+
+		return push->feed(contents, size);
+	}
+
+	PUGI__FN xml_parse_result xml_document::load_end()
+	{
+		impl::xml_document_struct* doc = static_cast<impl::xml_document_struct*>(_root);
+		if (!doc->push) return impl::make_parse_result(status_internal_error);
+
+		xml_parse_result result = doc->push->finish();
+
+		doc->push->~xml_push_parser();
+		impl::xml_memory::deallocate(doc->push);
+		doc->push = 0;
+
+		impl::update_attribute_index(doc);
+
+		return result;
 	}
 
 	PUGI__FN void xml_document::save(xml_writer& writer, const char_t* indent, unsigned int flags, xml_encoding encoding) const
@@ -6148,6 +9273,141 @@ namespace pugi
 		return xml_node();
 	}
 
+	PUGI__FN xml_reader_source_file::xml_reader_source_file(void* file_): file(file_)
+	{
+	}
+
+	PUGI__FN size_t xml_reader_source_file::read(void* data, size_t size)
+	{
+		return fread(data, 1, size, static_cast<FILE*>(file));
+	}
+
+	PUGI__FN xml_reader::xml_reader(size_t window_size): _impl(0)
+	{
+		void* memory = impl::xml_memory::allocate(sizeof(xml_reader_struct));
+
+		if (memory) _impl = new (memory) xml_reader_struct(window_size);
+	}
+
+	PUGI__FN xml_reader::~xml_reader()
+	{
+		if (_impl)
+		{
+			_impl->~xml_reader_struct();
+			impl::xml_memory::deallocate(_impl);
+		}
+	}
+
+	PUGI__FN bool xml_reader::open(xml_reader_source& source, unsigned int options, xml_encoding encoding)
+	{
+		if (!_impl) return false;
+
+		_impl->close();
+
+		return _impl->open(&source, options, encoding);
+	}
+
+	PUGI__FN bool xml_reader::open_file(const char* path_, unsigned int options, xml_encoding encoding)
+	{
+		if (!_impl) return false;
+
+		_impl->close();
+
+		return _impl->open_file(fopen(path_, "rb"), options, encoding);
+	}
+
+	PUGI__FN bool xml_reader::open_file(const wchar_t* path_, unsigned int options, xml_encoding encoding)
+	{
+		if (!_impl) return false;
+
+		_impl->close();
+
+		return _impl->open_file(impl::open_file_wide(path_, L"rb"), options, encoding);
+	}
+
+	PUGI__FN bool xml_reader::open_buffer(const void* contents, size_t size, unsigned int options, xml_encoding encoding)
+	{
+		if (!_impl) return false;
+
+		_impl->close();
+
+		_impl->buffer_source.data = static_cast<const uint8_t*>(contents);
+		_impl->buffer_source.size = size;
+
+		return _impl->open(&_impl->buffer_source, options, encoding);
+	}
+
+	PUGI__FN void xml_reader::close()
+	{
+		if (_impl) _impl->close();
+	}
+
+	PUGI__FN xml_reader_event xml_reader::next()
+	{
+		return _impl ? _impl->next() : event_error;
+	}
+
+	PUGI__FN xml_reader_event xml_reader::event() const
+	{
+		return _impl ? _impl->event : event_error;
+	}
+
+	PUGI__FN const char_t* xml_reader::name() const
+	{
+		return (_impl && _impl->name) ? _impl->name : PUGIXML_TEXT("");
+	}
+
+	PUGI__FN const char_t* xml_reader::value() const
+	{
+		return (_impl && _impl->value) ? _impl->value : PUGIXML_TEXT("");
+	}
+
+	PUGI__FN size_t xml_reader::attribute_count() const
+	{
+		return _impl ? _impl->attribute_count : 0;
+	}
+
+	PUGI__FN const char_t* xml_reader::attribute_name(size_t index) const
+	{
+		return (_impl && index < _impl->attribute_count) ? _impl->attributes[index * 2] : PUGIXML_TEXT("");
+	}
+
+	PUGI__FN const char_t* xml_reader::attribute_value(size_t index) const
+	{
+		return (_impl && index < _impl->attribute_count) ? _impl->attributes[index * 2 + 1] : PUGIXML_TEXT("");
+	}
+
+	PUGI__FN const char_t* xml_reader::attribute_value(const char_t* name_) const
+	{
+		if (!_impl) return 0;
+
+		for (size_t i = 0; i < _impl->attribute_count; ++i)
+			if (impl::strequal(_impl->attributes[i * 2], name_))
+				return _impl->attributes[i * 2 + 1];
+
+		return 0;
+	}
+
+	PUGI__FN size_t xml_reader::depth() const
+	{
+		return _impl ? _impl->depth : 0;
+	}
+
+	PUGI__FN xml_parse_result xml_reader::result() const
+	{
+		xml_parse_result result;
+
+		if (_impl)
+		{
+			result.status = _impl->status;
+			result.offset = static_cast<ptrdiff_t>(_impl->error_offset);
+			result.encoding = _impl->encoding;
+		}
+		else result.status = status_out_of_memory;
+
+		return result;
+	}
+
 #ifndef PUGIXML_NO_STL
 	PUGI__FN std::string PUGIXML_FUNCTION as_utf8(const wchar_t* str)
 	{
@@ -6643,6 +9903,9 @@ PUGI__NS_BEGIN
 	{
 		xpath_allocator* result;
 		xpath_allocator* temp;
+
+		// worker threads a step may split its nodes over; stacks used for predicates and function arguments keep this at 0
+		unsigned int threads;
 	};
 
 	struct xpath_stack_data
@@ -6663,6 +9926,7 @@ PUGI__NS_BEGIN
 
 			stack.result = &result;
 			stack.temp = &temp;
+			stack.threads = 0;
 
 		#ifdef PUGIXML_NO_EXCEPTIONS
 			result.error_handler = temp.error_handler = &error_handler;
@@ -7283,11 +10547,7 @@ PUGI__NS_BEGIN
 		if (!check_string_to_number_format(string)) return gen_nan();
 
 		// parse string
-	#ifdef PUGIXML_WCHAR_MODE
-		return wcstod(string, 0);
-	#else
-		return atof(string);
-	#endif
+		return string_to_double(string);
 	}
 
 	PUGI__FN bool convert_string_to_number_scratch(char_t (&buffer)[32], const char_t* begin, const char_t* end, double* out_result)
@@ -7581,6 +10841,121 @@ PUGI__NS_BEGIN
 		return result;
 	}
 
+	PUGI__FN bool attribute_index_find_key(const xml_attribute_index* index, const char_t* element, const char_t* attribute, unsigned int& key)
+	{
+		for (size_t i = 0; i < index->key_count; ++i)
+			if (strequal(index->keys[i].element, element) && strequal(index->keys[i].attribute, attribute))
+			{
+				key = static_cast<unsigned int>(i);
+				return true;
+			}
+
+		return false;
+	}
+
+	PUGI__FN xml_attribute_struct* attribute_index_match(const xml_attribute_index* index, xml_node_struct* node, unsigned int& key)
+	{
+		if (PUGI__NODETYPE(node) != node_element || !node->name) return 0;
+
+		for (size_t i = 0; i < index->key_count; ++i)
+		{
+			if (!strequal(node->name, index->keys[i].element)) continue;
+
+			// same attribute as the one ast_opt_compare_attribute looks at: the first one with this name
+			for (xml_attribute_struct* a = node->first_attribute; a; a = a->next_attribute)
+				if (a->name && strequal(a->name, index->keys[i].attribute))
+				{
+					key = static_cast<unsigned int>(i);
+					return a;
+				}
+		}
+
+		return 0;
+	}
+
+	PUGI__FN bool attribute_index_build(xml_attribute_index* index, xml_node_struct* root)
+	{
+		size_t count = 0;
+		unsigned int key;
+
+		for (xml_node_struct* cur = root->first_child; cur; )
+		{
+			if (attribute_index_match(index, cur, key)) count++;
+
+			if (cur->first_child) cur = cur->first_child;
+			else
+			{
+				while (!cur->next_sibling && cur->parent != root) cur = cur->parent;
+				cur = cur->next_sibling;
+			}
+		}
+
+		size_t bucket_count = 16;
+		while (bucket_count < count) bucket_count *= 2;
+
+		if (count > index->entry_capacity)
+		{
+			xml_attribute_index_entry* entries = static_cast<xml_attribute_index_entry*>(xml_memory::allocate(count * sizeof(xml_attribute_index_entry)));
+			if (!entries) return false;
+
+			if (index->entries) xml_memory::deallocate(index->entries);
+
+			index->entries = entries;
+			index->entry_capacity = count;
+		}
+
+		if (bucket_count > index->bucket_count)
+		{
+			xml_attribute_index_entry** buckets = static_cast<xml_attribute_index_entry**>(xml_memory::allocate(bucket_count * sizeof(xml_attribute_index_entry*)));
+			if (!buckets) return false;
+
+			if (index->buckets) xml_memory::deallocate(index->buckets);
+
+			index->buckets = buckets;
+			index->bucket_count = bucket_count;
+		}
+
+		memset(index->buckets, 0, index->bucket_count * sizeof(xml_attribute_index_entry*));
+
+		// fill the entries in document order...
+		xml_attribute_index_entry* entry = index->entries;
+
+		for (xml_node_struct* cur = root->first_child; cur; )
+		{
+			if (xml_attribute_struct* a = attribute_index_match(index, cur, key))
+			{
+				entry->node = cur;
+				entry->value = a->value ? a->value + 0 : PUGIXML_TEXT("");
+				entry->hash = hash_string(entry->value);
+				entry->key = key;
+				entry++;
+			}
+
+			if (cur->first_child) cur = cur->first_child;
+			else
+			{
+				while (!cur->next_sibling && cur->parent != root) cur = cur->parent;
+				cur = cur->next_sibling;
+			}
+		}
+
+		assert(entry == index->entries + count);
+
+		// ... and link them back to front so that every bucket lists its nodes in document order
+		for (size_t i = count; i > 0; --i)
+		{
+			xml_attribute_index_entry* e = index->entries + (i - 1);
+			size_t bucket = (e->hash ^ e->key) & (index->bucket_count - 1);
+
+			e->next = index->buckets[bucket];
+			index->buckets[bucket] = e;
+		}
+
+		index->current = true;
+
+		return true;
+	}
+
 	template <typename T> PUGI__FN T* new_xpath_variable(const char_t* name)
 	{
 		size_t length = strlength(name);
@@ -7798,15 +11173,34 @@ PUGI__NS_BEGIN
 				xpath_node* data = static_cast<xpath_node*>(alloc->reallocate(_begin, capacity * sizeof(xpath_node), (size_ + count) * sizeof(xpath_node)));
 				assert(data);
 
-				// finalize
+				// finalize
+				_begin = data;
+				_end = data + size_;
+				_eos = data + size_ + count;
+			}
+
+			memcpy(_end, begin_, count * sizeof(xpath_node));
+			_end += count;
+		}
+
+	#ifdef PUGIXML_HAS_THREADS
+		// makes room for count more nodes so that a series of appends does not copy the set every time
+		void reserve(size_t count, xpath_allocator* alloc)
+		{
+			size_t size_ = static_cast<size_t>(_end - _begin);
+			size_t capacity = static_cast<size_t>(_eos - _begin);
+
+			if (size_ + count > capacity)
+			{
+				xpath_node* data = static_cast<xpath_node*>(alloc->reallocate(_begin, capacity * sizeof(xpath_node), (size_ + count) * sizeof(xpath_node)));
+				assert(data);
+
 				_begin = data;
 				_end = data + size_;
 				_eos = data + size_ + count;
 			}
-
-			memcpy(_end, begin_, count * sizeof(xpath_node));
-			_end += count;
 		}
+	#endif
 
 		void sort_do()
 		{
@@ -8341,6 +11735,193 @@ PUGI__NS_BEGIN
 	};
 
 	template <axis_t N> const axis_t axis_to_type<N>::axis = N;
+
+#ifdef PUGIXML_HAS_THREADS
+	struct xpath_parallel_run
+	{
+		size_t number; // order in which the run was handed out, which is its order in the document
+		size_t offset; // where its nodes start in the worker's set
+	};
+
+	// The runs of siblings one thread took, with its own allocators so that threads never share memory
+	struct xpath_parallel_worker
+	{
+		xpath_stack_data sd;
+		xpath_node_set_raw ns;
+
+		xpath_parallel_run* runs;
+		size_t run_count;
+		size_t run_capacity;
+
+		bool error;
+
+		xpath_parallel_worker(): runs(0), run_count(0), run_capacity(0), error(false)
+		{
+		}
+
+		~xpath_parallel_worker()
+		{
+			if (runs) xml_memory::deallocate(runs);
+		}
+	};
+
+	class xpath_ast_node;
+
+	// Sibling lists can only be walked one node at a time, so threads take runs of siblings off a shared cursor instead of
+	// splitting the list up front, which would take a full extra pass over it
+	struct xpath_parallel_job
+	{
+		xpath_ast_node* step;
+		bool subtrees;
+
+		std::mutex lock;
+		xml_node_struct* next;
+		size_t run_count;
+	};
+
+	static const unsigned int xpath_parallel_max_threads = 64;
+	static const size_t xpath_parallel_run_size = 64;
+
+	// Steps over fewer nodes than this stay serial. A serial scan of this many nodes takes tens of microseconds, so below it
+	// the few microseconds it takes to wake the pool and merge the runs eat most of what a second core saves.
+	static const size_t xpath_parallel_min_nodes = 4096;
+
+	typedef void (*xpath_parallel_function)(xpath_parallel_job* job, xpath_parallel_worker* worker);
+
+	// Threads for parallel steps. They are started the first time a step needs them and then wait for the next step, since
+	// starting threads costs more than most steps take. The pool grows to the largest thread count a step has asked for.
+	// One step uses it at a time; a step on another thread that finds it busy runs on that thread alone.
+	class xpath_parallel_pool
+	{
+		std::mutex _busy;
+
+		std::mutex _lock;
+		std::condition_variable _wake;
+		std::condition_variable _done;
+
+		std::thread _threads[xpath_parallel_max_threads];
+		size_t _thread_count;
+
+		// the current step; pool thread i runs worker i + 1 if there is one
+		xpath_parallel_function _function;
+		xpath_parallel_job* _job;
+		xpath_parallel_worker* _workers;
+		size_t _worker_count;
+
+		size_t _generation;
+		size_t _active;
+		bool _shutdown;
+
+		void thread_main(size_t index, size_t generation)
+		{
+			std::unique_lock<std::mutex> guard(_lock);
+
+			for (;;)
+			{
+				while (!_shutdown && _generation == generation) _wake.wait(guard);
+
+				if (_shutdown) return;
+
+				generation = _generation;
+
+				if (index + 1 < _worker_count)
+				{
+					xpath_parallel_function function = _function;
+					xpath_parallel_job* job = _job;
+					xpath_parallel_worker* worker = _workers + index + 1;
+
+					guard.unlock();
+					function(job, worker);
+					guard.lock();
+
+					if (--_active == 0) _done.notify_one();
+				}
+			}
+		}
+
+		static void thread_entry(xpath_parallel_pool* pool, size_t index, size_t generation)
+		{
+			pool->thread_main(index, generation);
+		}
+
+		// new threads wait for the step after the current one, which may be posted before they first take the lock
+		void grow(size_t count)
+		{
+		#ifndef PUGIXML_NO_EXCEPTIONS
+			try
+			{
+		#endif
+				for (; _thread_count < count; ++_thread_count)
+					_threads[_thread_count] = std::thread(thread_entry, this, _thread_count, _generation);
+		#ifndef PUGIXML_NO_EXCEPTIONS
+			}
+			catch (...)
+			{
+				// the threads that did start take over the runs of the rest
+			}
+		#endif
+		}
+
+	public:
+		xpath_parallel_pool(): _thread_count(0), _function(0), _job(0), _workers(0), _worker_count(0), _generation(0), _active(0), _shutdown(false)
+		{
+		}
+
+		~xpath_parallel_pool()
+		{
+			{
+				std::lock_guard<std::mutex> guard(_lock);
+				_shutdown = true;
+			}
+
+			_wake.notify_all();
+
+			for (size_t i = 0; i < _thread_count; ++i) _threads[i].join();
+		}
+
+		static xpath_parallel_pool& instance()
+		{
+			static xpath_parallel_pool pool;
+
+			return pool;
+		}
+
+		// Runs function for every worker, the first one on the calling thread, and returns when all of them are done
+		void run(xpath_parallel_function function, xpath_parallel_job* job, xpath_parallel_worker* workers, size_t worker_count)
+		{
+			std::unique_lock<std::mutex> busy(_busy, std::try_to_lock);
+
+			size_t helpers = 0;
+
+			if (busy.owns_lock())
+			{
+				grow(worker_count - 1);
+
+				std::lock_guard<std::mutex> guard(_lock);
+
+				helpers = worker_count - 1 < _thread_count ? worker_count - 1 : _thread_count;
+
+				_function = function;
+				_job = job;
+				_workers = workers;
+				_worker_count = helpers + 1;
+				_active = helpers;
+				_generation++;
+			}
+
+			if (helpers) _wake.notify_all();
+
+			function(job, workers);
+
+			if (helpers)
+			{
+				std::unique_lock<std::mutex> guard(_lock);
+
+				while (_active) _done.wait(guard);
+			}
+		}
+	};
+#endif
 		
 	class xpath_ast_node
 	{
@@ -8635,13 +12216,13 @@ PUGI__NS_BEGIN
 				apply_predicate_boolean(ns, first, _right, stack, once);
 		}
 
-		void apply_predicates(xpath_node_set_raw& ns, size_t first, const xpath_stack& stack, nodeset_eval_t eval)
+		void apply_predicates(xpath_node_set_raw& ns, size_t first, const xpath_stack& stack, nodeset_eval_t eval, xpath_ast_node* preds)
 		{
 			if (ns.size() == first) return;
 
 			bool last_once = eval_once(ns.type(), eval);
 
-			for (xpath_ast_node* pred = _right; pred; pred = pred->_next)
+			for (xpath_ast_node* pred = preds; pred; pred = pred->_next)
 				pred->apply_predicate(ns, first, stack, !pred->_next && last_once);
 		}
 
@@ -8933,117 +12514,416 @@ PUGI__NS_BEGIN
 				break;
 			}
 
-			case axis_self:
-			{
-				step_push(ns, n, alloc);
+			case axis_self:
+			{
+				step_push(ns, n, alloc);
+
+				break;
+			}
+
+			case axis_parent:
+			{
+				if (n->parent)
+					step_push(ns, n->parent, alloc);
+
+				break;
+			}
+				
+			default:
+				assert(!"Unimplemented axis");
+			}
+		}
+		
+		template <class T> void step_fill(xpath_node_set_raw& ns, xml_attribute_struct* a, xml_node_struct* p, xpath_allocator* alloc, bool once, T v)
+		{
+			const axis_t axis = T::axis;
+
+			switch (axis)
+			{
+			case axis_ancestor:
+			case axis_ancestor_or_self:
+			{
+				if (axis == axis_ancestor_or_self && _test == nodetest_type_node) // reject attributes based on principal node type test
+					if (step_push(ns, a, p, alloc) & once)
+						return;
+
+				xml_node_struct* cur = p;
+				
+				while (cur)
+				{
+					if (step_push(ns, cur, alloc) & once)
+						return;
+					
+					cur = cur->parent;
+				}
+				
+				break;
+			}
+
+			case axis_descendant_or_self:
+			case axis_self:
+			{
+				if (_test == nodetest_type_node) // reject attributes based on principal node type test
+					step_push(ns, a, p, alloc);
+
+				break;
+			}
+
+			case axis_following:
+			{
+				xml_node_struct* cur = p;
+				
+				while (cur)
+				{
+					if (cur->first_child)
+						cur = cur->first_child;
+					else
+					{
+						while (!cur->next_sibling)
+						{
+							cur = cur->parent;
+
+							if (!cur) return;
+						}
+
+						cur = cur->next_sibling;
+					}
+
+					if (step_push(ns, cur, alloc) & once)
+						return;
+				}
+
+				break;
+			}
+
+			case axis_parent:
+			{
+				step_push(ns, p, alloc);
+
+				break;
+			}
+
+			case axis_preceding:
+			{
+				// preceding:: axis does not include attribute nodes and attribute ancestors (they are the same as parent's ancestors), so we can reuse node preceding
+				step_fill(ns, p, alloc, once, v);
+				break;
+			}
+			
+			default:
+				assert(!"Unimplemented axis");
+			}
+		}
+
+		template <class T> void step_fill(xpath_node_set_raw& ns, const xpath_node& xn, xpath_allocator* alloc, bool once, T v)
+		{
+			const axis_t axis = T::axis;
+			const bool axis_has_attributes = (axis == axis_ancestor || axis == axis_ancestor_or_self || axis == axis_descendant_or_self || axis == axis_following || axis == axis_parent || axis == axis_preceding || axis == axis_self);
+
+			if (xn.node())
+				step_fill(ns, xn.node().internal_object(), alloc, once, v);
+			else if (axis_has_attributes && xn.attribute() && xn.parent())
+				step_fill(ns, xn.attribute().internal_object(), xn.parent().internal_object(), alloc, once, v);
+		}
+
+		// Fills descendant::name[@attr = value] from the document's attribute index; returns false if the document has no index for name/@attr
+		bool step_fill_indexed(xpath_node_set_raw& ns, const xpath_node& xn, xpath_allocator* alloc, bool self)
+		{
+			xml_node_struct* context = xn.node().internal_object();
+			if (!context) return false;
+
+			xml_document_struct& doc = get_document(context);
+
+			xml_attribute_index* index = doc.attribute_index;
+			if (!index) return false;
+
+			xpath_ast_node* compare = _right->_right;
+
+			// namespace declarations never compare equal, the scan handles that
+			if (!is_xpath_attribute(compare->_left->_data.nodetest)) return false;
+
+			unsigned int key;
+			if (!attribute_index_find_key(index, _data.nodetest, compare->_left->_data.nodetest, key)) return false;
+
+			// queries never rebuild the index, since other threads may be reading it; until the next load, scan instead
+			if (!index->current) return false;
+
+			const char_t* value = (compare->_right->_type == ast_string_constant) ? compare->_right->_data.string : compare->_right->_data.variable->get_string();
+			unsigned int hash = hash_string(value);
+
+			for (xml_attribute_index_entry* e = index->buckets[(hash ^ key) & (index->bucket_count - 1)]; e; e = e->next)
+			{
+				if (e->hash != hash || e->key != key || !strequal(e->value, value)) continue;
+
+				// the document contains every node, otherwise keep the ones below the context node
+				if (context != &doc)
+				{
+					xml_node_struct* cur = self ? e->node : e->node->parent;
+
+					while (cur && cur != context) cur = cur->parent;
+
+					if (!cur) continue;
+				}
+
+				ns.push_back(xml_node(e->node), alloc);
+			}
+
+			return true;
+		}
+
+	#ifdef PUGIXML_HAS_THREADS
+		bool is_parallel_step(const xpath_stack& stack, bool once) const
+		{
+			if (stack.threads < 2 || once) return false;
+
+			// every predicate has to give the same answer for a node no matter which run it ends up in
+			for (xpath_ast_node* pred = _right; pred; pred = pred->_next)
+				if (pred->_test != predicate_posinv) return false;
+
+			return true;
+		}
+
+		void step_fill_runs(xpath_parallel_job* job, xpath_parallel_worker* worker)
+		{
+		#ifdef PUGIXML_NO_EXCEPTIONS
+			if (setjmp(worker->sd.error_handler))
+			{
+				worker->error = true;
+				return;
+			}
+		#else
+			try
+			{
+		#endif
+				xpath_allocator* alloc = worker->sd.stack.result;
+
+				worker->ns.set_type(xpath_node_set::type_sorted);
+
+				for (;;)
+				{
+					xml_node_struct* begin;
+					xml_node_struct* end;
+					size_t number;
+
+					{
+						std::lock_guard<std::mutex> guard(job->lock);
+
+						begin = end = job->next;
+						if (!begin) break;
+
+						for (size_t i = 0; i < xpath_parallel_run_size && end; ++i) end = end->next_sibling;
+
+						job->next = end;
+						number = job->run_count++;
+					}
+
+					if (worker->run_count == worker->run_capacity)
+					{
+						size_t capacity = worker->run_capacity ? worker->run_capacity * 2 : 16;
+
+						xpath_parallel_run* runs = static_cast<xpath_parallel_run*>(xml_memory::allocate(capacity * sizeof(xpath_parallel_run)));
+						if (!runs) parallel_out_of_memory(worker->sd.stack);
+
+						if (worker->runs)
+						{
+							memcpy(runs, worker->runs, worker->run_count * sizeof(xpath_parallel_run));
+							xml_memory::deallocate(worker->runs);
+						}
+
+						worker->runs = runs;
+						worker->run_capacity = capacity;
+					}
 
-				break;
-			}
+					size_t offset = worker->ns.size();
 
-			case axis_parent:
-			{
-				if (n->parent)
-					step_push(ns, n->parent, alloc);
+					worker->runs[worker->run_count].number = number;
+					worker->runs[worker->run_count].offset = offset;
+					worker->run_count++;
 
-				break;
+					for (xml_node_struct* c = begin; c != end; c = c->next_sibling)
+					{
+						if (job->subtrees)
+							step_fill(worker->ns, c, alloc, false, axis_to_type<axis_descendant_or_self>());
+						else
+							step_push(worker->ns, c, alloc);
+					}
+
+					if (_right) apply_predicates(worker->ns, offset, worker->sd.stack, nodeset_eval_all, _right);
+				}
+		#ifndef PUGIXML_NO_EXCEPTIONS
 			}
-				
-			default:
-				assert(!"Unimplemented axis");
+			catch (...)
+			{
+				worker->error = true;
 			}
+		#endif
 		}
-		
-		template <class T> void step_fill(xpath_node_set_raw& ns, xml_attribute_struct* a, xml_node_struct* p, xpath_allocator* alloc, bool once, T v)
+
+		// Worker failures can only be out of memory errors, which are reported the way xpath_allocator reports them
+		static void parallel_out_of_memory(const xpath_stack& stack)
 		{
-			const axis_t axis = T::axis;
+		#ifdef PUGIXML_NO_EXCEPTIONS
+			assert(stack.result->error_handler);
+			longjmp(*stack.result->error_handler, 1);
+		#else
+			(void)stack;
+			throw std::bad_alloc();
+		#endif
+		}
 
-			switch (axis)
-			{
-			case axis_ancestor:
-			case axis_ancestor_or_self:
+		static void step_fill_worker(xpath_parallel_job* job, xpath_parallel_worker* worker)
+		{
+			job->step->step_fill_runs(job, worker);
+		}
+
+		// Counts the nodes the workers would take from below fork, stopping as soon as there are enough to split
+		static bool is_parallel_fork(xml_node_struct* fork, bool subtrees)
+		{
+			size_t children = 0;
+			size_t nodes = 0;
+
+			for (xml_node_struct* c = fork->first_child; c && (children <= xpath_parallel_run_size || nodes < xpath_parallel_min_nodes); c = c->next_sibling)
 			{
-				if (axis == axis_ancestor_or_self && _test == nodetest_type_node) // reject attributes based on principal node type test
-					if (step_push(ns, a, p, alloc) & once)
-						return;
+				++children;
+				++nodes;
 
-				xml_node_struct* cur = p;
-				
-				while (cur)
+				if (!subtrees) continue;
+
+				// descendants of c, in document order, until the count is reached
+				xml_node_struct* d = c->first_child;
+
+				while (d && nodes < xpath_parallel_min_nodes)
 				{
-					if (step_push(ns, cur, alloc) & once)
-						return;
-					
-					cur = cur->parent;
+					++nodes;
+
+					if (d->first_child)
+						d = d->first_child;
+					else
+					{
+						while (d != c && !d->next_sibling) d = d->parent;
+
+						if (d == c) break;
+
+						d = d->next_sibling;
+					}
 				}
-				
-				break;
 			}
 
-			case axis_descendant_or_self:
-			case axis_self:
-			{
-				if (_test == nodetest_type_node) // reject attributes based on principal node type test
-					step_push(ns, a, p, alloc);
+			// a single run would leave every thread but one idle
+			return children > xpath_parallel_run_size && nodes >= xpath_parallel_min_nodes;
+		}
 
-				break;
-			}
+		void step_merge_runs(xpath_node_set_raw& ns, xpath_parallel_worker* workers, size_t worker_count, size_t run_count, xpath_allocator* alloc)
+		{
+			size_t next[xpath_parallel_max_threads] = {};
+			size_t count = 0;
 
-			case axis_following:
+			for (size_t i = 0; i < worker_count; ++i) count += workers[i].ns.size();
+
+			ns.reserve(count, alloc);
+
+			for (size_t number = 0; number < run_count; ++number)
 			{
-				xml_node_struct* cur = p;
-				
-				while (cur)
+				for (size_t i = 0; i < worker_count; ++i)
 				{
-					if (cur->first_child)
-						cur = cur->first_child;
-					else
+					xpath_parallel_worker& w = workers[i];
+
+					if (next[i] < w.run_count && w.runs[next[i]].number == number)
 					{
-						while (!cur->next_sibling)
-						{
-							cur = cur->parent;
+						size_t end = (next[i] + 1 < w.run_count) ? w.runs[next[i] + 1].offset : w.ns.size();
 
-							if (!cur) return;
-						}
+						ns.append(w.ns.begin() + w.runs[next[i]].offset, w.ns.begin() + end, alloc);
+						next[i]++;
 
-						cur = cur->next_sibling;
+						break;
 					}
-
-					if (step_push(ns, cur, alloc) & once)
-						return;
 				}
-
-				break;
 			}
+		}
 
-			case axis_parent:
-			{
-				step_push(ns, p, alloc);
+		// Fills child (subtrees = false) or descendant nodes of xn with predicates applied, splitting the children of the context
+		// node (or of the first node below it with more than one child) between threads; returns false for attribute contexts and
+		// for steps that are too small to be worth splitting
+		bool step_fill_parallel(xpath_node_set_raw& ns, const xpath_node& xn, const xpath_stack& stack, bool subtrees, bool self)
+		{
+			xml_node_struct* context = xn.node().internal_object();
+			if (!context) return false;
 
-				break;
-			}
+			xml_node_struct* fork = context;
 
-			case axis_preceding:
+			if (subtrees)
+				while (fork->first_child && !fork->first_child->next_sibling) fork = fork->first_child;
+
+			if (!is_parallel_fork(fork, subtrees)) return false;
+
+			// nodes above the fork precede everything below it in document order
+			size_t first = ns.size();
+
+			if (self) step_push(ns, context, stack.result);
+
+			for (xml_node_struct* n = context; n != fork; )
 			{
-				// preceding:: axis does not include attribute nodes and attribute ancestors (they are the same as parent's ancestors), so we can reuse node preceding
-				step_fill(ns, p, alloc, once, v);
-				break;
+				n = n->first_child;
+				step_push(ns, n, stack.result);
 			}
-			
-			default:
-				assert(!"Unimplemented axis");
+
+			if (_right) apply_predicates(ns, first, stack, nodeset_eval_all, _right);
+
+			size_t worker_count = stack.threads;
+
+			xpath_parallel_worker* workers = static_cast<xpath_parallel_worker*>(xml_memory::allocate(worker_count * sizeof(xpath_parallel_worker)));
+			if (!workers) parallel_out_of_memory(stack);
+
+			for (size_t i = 0; i < worker_count; ++i) new (workers + i) xpath_parallel_worker();
+
+			xpath_parallel_job job;
+			job.step = this;
+			job.subtrees = subtrees;
+			job.next = fork->first_child;
+			job.run_count = 0;
+
+			xpath_parallel_pool::instance().run(step_fill_worker, &job, workers, worker_count);
+
+			bool error = false;
+
+			for (size_t i = 0; i < worker_count; ++i) error |= workers[i].error;
+
+			if (!error)
+			{
+			#ifdef PUGIXML_NO_EXCEPTIONS
+				jmp_buf* error_handler = stack.result->error_handler;
+				jmp_buf merge_error_handler;
+
+				stack.result->error_handler = &merge_error_handler;
+
+				if (setjmp(merge_error_handler))
+					error = true;
+				else
+			#else
+				try
+			#endif
+				{
+					step_merge_runs(ns, workers, worker_count, job.run_count, stack.result);
+				}
+			#ifdef PUGIXML_NO_EXCEPTIONS
+				stack.result->error_handler = error_handler;
+			#else
+				catch (...)
+				{
+					error = true;
+				}
+			#endif
 			}
-		}
 
-		template <class T> void step_fill(xpath_node_set_raw& ns, const xpath_node& xn, xpath_allocator* alloc, bool once, T v)
-		{
-			const axis_t axis = T::axis;
-			const bool axis_has_attributes = (axis == axis_ancestor || axis == axis_ancestor_or_self || axis == axis_descendant_or_self || axis == axis_following || axis == axis_parent || axis == axis_preceding || axis == axis_self);
+			for (size_t i = 0; i < worker_count; ++i) workers[i].~xpath_parallel_worker();
 
-			if (xn.node())
-				step_fill(ns, xn.node().internal_object(), alloc, once, v);
-			else if (axis_has_attributes && xn.attribute() && xn.parent())
-				step_fill(ns, xn.attribute().internal_object(), xn.parent().internal_object(), alloc, once, v);
+			xml_memory::deallocate(workers);
+
+			if (error) parallel_out_of_memory(stack);
+
+			return true;
 		}
+	#endif
 
 		template <class T> xpath_node_set_raw step_do(const xpath_context& c, const xpath_stack& stack, nodeset_eval_t eval, T v)
 		{
@@ -9056,6 +12936,16 @@ PUGI__NS_BEGIN
 				(!_right && eval_once(axis_type, eval)) ||
 				(_right && !_right->_next && _right->_test == predicate_constant_one);
 
+			// name[@attr = value] below the context node can come from an attribute index instead of a scan
+			bool indexed =
+				(axis == axis_descendant || axis == axis_descendant_or_self) && _test == nodetest_name &&
+				_right && _right->_right->_type == ast_opt_compare_attribute;
+
+		#ifdef PUGIXML_HAS_THREADS
+			// a step from a single context node can split the subtrees below it over worker threads
+			bool parallel = (axis == axis_child || axis == axis_descendant || axis == axis_descendant_or_self) && is_parallel_step(stack, once);
+		#endif
+
 			xpath_node_set_raw ns;
 			ns.set_type(axis_type);
 
@@ -9073,14 +12963,32 @@ PUGI__NS_BEGIN
 					// in general, all axes generate elements in a particular order, but there is no order guarantee if axis is applied to two nodes
 					if (axis != axis_self && size != 0) ns.set_type(xpath_node_set::type_unsorted);
 					
-					step_fill(ns, *it, stack.result, once, v);
-					if (_right) apply_predicates(ns, size, stack, eval);
+					if (indexed && step_fill_indexed(ns, *it, stack.result, axis == axis_descendant_or_self))
+						apply_predicates(ns, size, stack, eval, _right->_next);
+				#ifdef PUGIXML_HAS_THREADS
+					else if (parallel && s.size() == 1 && step_fill_parallel(ns, *it, stack, axis != axis_child, axis == axis_descendant_or_self))
+						; // predicates are applied by the workers
+				#endif
+					else
+					{
+						step_fill(ns, *it, stack.result, once, v);
+						if (_right) apply_predicates(ns, size, stack, eval, _right);
+					}
 				}
 			}
 			else
 			{
-				step_fill(ns, c.n, stack.result, once, v);
-				if (_right) apply_predicates(ns, 0, stack, eval);
+				if (indexed && step_fill_indexed(ns, c.n, stack.result, axis == axis_descendant_or_self))
+					apply_predicates(ns, 0, stack, eval, _right->_next);
+			#ifdef PUGIXML_HAS_THREADS
+				else if (parallel && step_fill_parallel(ns, c.n, stack, axis != axis_child, axis == axis_descendant_or_self))
+					; // predicates are applied by the workers
+			#endif
+				else
+				{
+					step_fill(ns, c.n, stack.result, once, v);
+					if (_right) apply_predicates(ns, 0, stack, eval, _right);
+				}
 			}
 
 			// child, attribute and self axes always generate unique set of nodes
@@ -9438,7 +13346,7 @@ PUGI__NS_BEGIN
 			}
 
 			// evaluate all strings to temporary stack
-			xpath_stack swapped_stack = {stack.temp, stack.result};
+			xpath_stack swapped_stack = {stack.temp, stack.result, 0};
 
 			buffer[0] = _left->eval_string(c, swapped_stack);
 
@@ -9536,7 +13444,7 @@ PUGI__NS_BEGIN
 			{
 				xpath_allocator_capture cr(stack.temp);
 
-				xpath_stack swapped_stack = {stack.temp, stack.result};
+				xpath_stack swapped_stack = {stack.temp, stack.result, 0};
 
 				xpath_string s = _left->eval_string(c, swapped_stack);
 				xpath_string p = _right->eval_string(c, swapped_stack);
@@ -9550,7 +13458,7 @@ PUGI__NS_BEGIN
 			{
 				xpath_allocator_capture cr(stack.temp);
 
-				xpath_stack swapped_stack = {stack.temp, stack.result};
+				xpath_stack swapped_stack = {stack.temp, stack.result, 0};
 
 				xpath_string s = _left->eval_string(c, swapped_stack);
 				xpath_string p = _right->eval_string(c, swapped_stack);
@@ -9568,7 +13476,7 @@ PUGI__NS_BEGIN
 			{
 				xpath_allocator_capture cr(stack.temp);
 
-				xpath_stack swapped_stack = {stack.temp, stack.result};
+				xpath_stack swapped_stack = {stack.temp, stack.result, 0};
 
 				xpath_string s = _left->eval_string(c, swapped_stack);
 				size_t s_length = s.length();
@@ -9591,7 +13499,7 @@ PUGI__NS_BEGIN
 			{
 				xpath_allocator_capture cr(stack.temp);
 
-				xpath_stack swapped_stack = {stack.temp, stack.result};
+				xpath_stack swapped_stack = {stack.temp, stack.result, 0};
 
 				xpath_string s = _left->eval_string(c, swapped_stack);
 				size_t s_length = s.length();
@@ -9636,7 +13544,7 @@ PUGI__NS_BEGIN
 			{
 				xpath_allocator_capture cr(stack.temp);
 
-				xpath_stack swapped_stack = {stack.temp, stack.result};
+				xpath_stack swapped_stack = {stack.temp, stack.result, 0};
 
 				xpath_string s = _left->eval_string(c, stack);
 				xpath_string from = _right->eval_string(c, swapped_stack);
@@ -9680,7 +13588,7 @@ PUGI__NS_BEGIN
 				{
 					xpath_allocator_capture cr(stack.temp);
 
-					xpath_stack swapped_stack = {stack.temp, stack.result};
+					xpath_stack swapped_stack = {stack.temp, stack.result, 0};
 
 					xpath_node_set_raw ns = eval_node_set(c, swapped_stack, nodeset_eval_first);
 					return ns.empty() ? xpath_string() : string_value(ns.first(), stack.result);
@@ -9702,7 +13610,7 @@ PUGI__NS_BEGIN
 			{
 				xpath_allocator_capture cr(stack.temp);
 
-				xpath_stack swapped_stack = {stack.temp, stack.result};
+				xpath_stack swapped_stack = {stack.temp, stack.result, 0};
 
 				xpath_node_set_raw ls = _left->eval_node_set(c, swapped_stack, eval);
 				xpath_node_set_raw rs = _right->eval_node_set(c, stack, eval);
@@ -10832,6 +14740,19 @@ PUGI__NS_BEGIN
 
 		return impl->root;
 	}
+
+#ifdef PUGIXML_HAS_THREADS
+	PUGI__FN unsigned int evaluate_parallel_threads(const xpath_node& n, unsigned int threads)
+	{
+		if (threads == 0) threads = std::thread::hardware_concurrency();
+		if (threads > xpath_parallel_max_threads) threads = xpath_parallel_max_threads;
+
+		xml_node_struct* node = n.node() ? n.node().internal_object() : n.parent().internal_object();
+		if (!node) return 0;
+
+		return threads;
+	}
+#endif
 PUGI__NS_END
 
 namespace pugi
@@ -11348,6 +15269,27 @@ namespace pugi
 		return xpath_node_set(r.begin(), r.end(), r.type());
 	}
 
+#ifdef PUGIXML_HAS_THREADS
+	PUGI__FN xpath_node_set xpath_query::evaluate_node_set_parallel(const xpath_node& n, unsigned int threads) const
+	{
+		impl::xpath_ast_node* root = impl::evaluate_node_set_prepare(static_cast<impl::xpath_query_impl*>(_impl));
+		if (!root) return xpath_node_set();
+
+		impl::xpath_context c(n, 1, 1);
+		impl::xpath_stack_data sd;
+
+		sd.stack.threads = impl::evaluate_parallel_threads(n, threads);
+
+	#ifdef PUGIXML_NO_EXCEPTIONS
+		if (setjmp(sd.error_handler)) return xpath_node_set();
+	#endif
+
+		impl::xpath_node_set_raw r = root->eval_node_set(c, sd.stack, impl::nodeset_eval_all);
+
+		return xpath_node_set(r.begin(), r.end(), r.type());
+	}
+#endif
+
 	PUGI__FN xpath_node xpath_query::evaluate_node(const xpath_node& n) const
 	{
 		impl::xpath_ast_node* root = impl::evaluate_node_set_prepare(static_cast<impl::xpath_query_impl*>(_impl));
@@ -11384,6 +15326,161 @@ namespace pugi
 		return !_impl;
 	}
 
+	struct xpath_query_cache_entry
+	{
+		xpath_query_cache_entry(const char_t* expression_, xpath_variable_set* variables_): query(expression_, variables_), expression(0), variables(variables_), next(0), lru_prev(0), lru_next(0)
+		{
+		}
+
+		xpath_query query;
+
+		// expression text is stored right after the entry
+		const char_t* expression;
+		xpath_variable_set* variables;
+
+		xpath_query_cache_entry* next;
+
+		xpath_query_cache_entry* lru_prev;
+		xpath_query_cache_entry* lru_next;
+	};
+
+	PUGI__FN xpath_query_cache::xpath_query_cache(size_t capacity): _lru_head(0), _lru_tail(0), _size(0), _capacity(capacity ? capacity : 1), _hits(0), _misses(0)
+	{
+		for (size_t i = 0; i < sizeof(_data) / sizeof(_data[0]); ++i) _data[i] = 0;
+	}
+
+	PUGI__FN xpath_query_cache::~xpath_query_cache()
+	{
+		clear();
+	}
+
+	PUGI__FN void xpath_query_cache::destroy(xpath_query_cache_entry* entry)
+	{
+		const size_t hash_size = sizeof(_data) / sizeof(_data[0]);
+		size_t hash = (impl::hash_string(entry->expression) ^ reinterpret_cast<uintptr_t>(entry->variables)) % hash_size;
+
+		// unlink from the hash chain
+		xpath_query_cache_entry** link = &_data[hash];
+		while (*link != entry) link = &(*link)->next;
+		*link = entry->next;
+
+		// unlink from the lru list
+		if (entry->lru_prev) entry->lru_prev->lru_next = entry->lru_next;
+		else _lru_head = entry->lru_next;
+
+		if (entry->lru_next) entry->lru_next->lru_prev = entry->lru_prev;
+		else _lru_tail = entry->lru_prev;
+
+		--_size;
+
+		entry->~xpath_query_cache_entry();
+		impl::xml_memory::deallocate(entry);
+	}
+
+	PUGI__FN const xpath_query* xpath_query_cache::get(const char_t* query, xpath_variable_set* variables)
+	{
+		const size_t hash_size = sizeof(_data) / sizeof(_data[0]);
+		size_t hash = (impl::hash_string(query) ^ reinterpret_cast<uintptr_t>(variables)) % hash_size;
+
+		for (xpath_query_cache_entry* entry = _data[hash]; entry; entry = entry->next)
+			if (entry->variables == variables && impl::strequal(entry->expression, query))
+			{
+				++_hits;
+
+				// move to the front of the lru list
+				if (entry != _lru_head)
+				{
+					entry->lru_prev->lru_next = entry->lru_next;
+
+					if (entry->lru_next) entry->lru_next->lru_prev = entry->lru_prev;
+					else _lru_tail = entry->lru_prev;
+
+					entry->lru_prev = 0;
+					entry->lru_next = _lru_head;
+					_lru_head->lru_prev = entry;
+					_lru_head = entry;
+				}
+
+				return &entry->query;
+			}
+
+		++_misses;
+
+		size_t length = impl::strlength(query);
+		void* memory = impl::xml_memory::allocate(sizeof(xpath_query_cache_entry) + (length + 1) * sizeof(char_t));
+
+		if (!memory)
+		{
+		#ifdef PUGIXML_NO_EXCEPTIONS
+			return 0;
+		#else
+			throw std::bad_alloc();
+		#endif
+		}
+
+		// compilation errors throw, so only hold on to the memory once the query is compiled
+		impl::buffer_holder holder(memory, impl::xml_memory::deallocate);
+
+		xpath_query_cache_entry* entry = new (memory) xpath_query_cache_entry(query, variables);
+
+		holder.release();
+
+		char_t* expression = reinterpret_cast<char_t*>(entry + 1);
+		memcpy(expression, query, (length + 1) * sizeof(char_t));
+		entry->expression = expression;
+
+		entry->next = _data[hash];
+		_data[hash] = entry;
+
+		entry->lru_next = _lru_head;
+		if (_lru_head) _lru_head->lru_prev = entry;
+		else _lru_tail = entry;
+		_lru_head = entry;
+
+		if (++_size > _capacity) destroy(_lru_tail);
+
+		return &entry->query;
+	}
+
+	PUGI__FN void xpath_query_cache::remove(const xpath_variable_set* variables)
+	{
+		for (xpath_query_cache_entry* entry = _lru_head; entry; )
+		{
+			xpath_query_cache_entry* next = entry->lru_next;
+
+			if (entry->variables == variables) destroy(entry);
+
+			entry = next;
+		}
+	}
+
+	PUGI__FN void xpath_query_cache::clear()
+	{
+		while (_lru_head) destroy(_lru_head);
+	}
+
+	PUGI__FN size_t xpath_query_cache::size() const
+	{
+		return _size;
+	}
+
+	PUGI__FN size_t xpath_query_cache::hits() const
+	{
+		return _hits;
+	}
+
+	PUGI__FN size_t xpath_query_cache::misses() const
+	{
+		return _misses;
+	}
+
+	PUGI__FN xpath_query_cache& xpath_query_cache::global()
+	{
+		static xpath_query_cache cache;
+
+		return cache;
+	}
+
 	PUGI__FN xpath_node xml_node::select_node(const char_t* query, xpath_variable_set* variables) const
 	{
 		xpath_query q(query, variables);
@@ -11435,12 +15532,15 @@ namespace pugi
 #undef PUGI__UNLIKELY
 #undef PUGI__STATIC_ASSERT
 #undef PUGI__DMC_VOLATILE
+#undef PUGI__EXACT_DOUBLE
 #undef PUGI__MSVC_CRT_VERSION
 #undef PUGI__NS_BEGIN
 #undef PUGI__NS_END
 #undef PUGI__FN
 #undef PUGI__FN_NO_INLINE
 #undef PUGI__NODETYPE
+#undef PUGI__GETPAGE_IMPL
+#undef PUGI__GETPAGE
 #undef PUGI__IS_CHARTYPE_IMPL
 #undef PUGI__IS_CHARTYPE
 #undef PUGI__IS_CHARTYPEX
@@ -11452,6 +15552,12 @@ namespace pugi
 #undef PUGI__SCANFOR
 #undef PUGI__SCANWHILE
 #undef PUGI__SCANWHILE_UNROLL
+#undef PUGI__SCANFOR_CHARTYPE
+#undef PUGI__SIMD
+#undef PUGI__SIMD_AVX2
+#undef PUGI__SIMD_SSE2
+#undef PUGI__SIMD_NEON
+#undef PUGI__SIMD_NO_SANITIZE
 #undef PUGI__ENDSEG
 #undef PUGI__THROW_ERROR
 #undef PUGI__CHECK_ERROR
@@ -72,6 +72,13 @@
 #	endif
 #endif
 
+// If the platform is known to have POSIX file descriptors, enable writers that output to them
+#if !defined(PUGIXML_HAS_POSIX_IO) && !defined(PUGIXML_NO_POSIX_IO)
+#	if defined(__unix__) || defined(__unix) || defined(__APPLE__)
+#		define PUGIXML_HAS_POSIX_IO
+#	endif
+#endif
+
 // Character interface macros
 #ifdef PUGIXML_WCHAR_MODE
 #	define PUGIXML_TEXT(t) L ## t
@@ -210,6 +217,7 @@ namespace pugi
 	// Forward declarations
 	struct xml_attribute_struct;
 	struct xml_node_struct;
+	struct xml_reader_struct;
 
 	class xml_node_iterator;
 	class xml_attribute_iterator;
@@ -288,6 +296,38 @@ namespace pugi
 	};
 	#endif
 
+	#ifdef PUGIXML_HAS_POSIX_IO
+	// xml_writer implementation for POSIX file descriptors; small writes are collected into large blocks, and big chunks are sent
+	// together with the collected data in a single writev call
+	class PUGIXML_CLASS xml_writer_fd: public xml_writer
+	{
+	public:
+		// Construct writer from a file descriptor open for writing; the descriptor is not closed by the writer
+		explicit xml_writer_fd(int fd);
+
+		// Writes out the collected data
+		virtual ~xml_writer_fd();
+
+		virtual void write(const void* data, size_t size);
+
+		// Writes out the collected data
+		void flush();
+
+		// Get errno of the first failed write, or 0 if all data has been written so far
+		int error() const;
+
+	private:
+		xml_writer_fd(const xml_writer_fd&);
+		xml_writer_fd& operator=(const xml_writer_fd&);
+
+		int _fd;
+		int _error;
+		size_t _size;
+
+		char _buffer[32768];
+	};
+	#endif
+
 	// A light-weight handle for manipulating attributes in DOM tree
 	class PUGIXML_CLASS xml_attribute
 	{
@@ -352,6 +392,7 @@ namespace pugi
 		bool set_value(int rhs);
 		bool set_value(unsigned int rhs);
 		bool set_value(double rhs);
+		bool set_value(float rhs);
 		bool set_value(bool rhs);
 
 	#ifdef PUGIXML_HAS_LONG_LONG
@@ -364,6 +405,7 @@ namespace pugi
 		xml_attribute& operator=(int rhs);
 		xml_attribute& operator=(unsigned int rhs);
 		xml_attribute& operator=(double rhs);
+		xml_attribute& operator=(float rhs);
 		xml_attribute& operator=(bool rhs);
 
 	#ifdef PUGIXML_HAS_LONG_LONG
@@ -694,6 +736,7 @@ namespace pugi
 		bool set(int rhs);
 		bool set(unsigned int rhs);
 		bool set(double rhs);
+		bool set(float rhs);
 		bool set(bool rhs);
 
 	#ifdef PUGIXML_HAS_LONG_LONG
@@ -706,6 +749,7 @@ namespace pugi
 		xml_text& operator=(int rhs);
 		xml_text& operator=(unsigned int rhs);
 		xml_text& operator=(double rhs);
+		xml_text& operator=(float rhs);
 		xml_text& operator=(bool rhs);
 
 	#ifdef PUGIXML_HAS_LONG_LONG
@@ -931,14 +975,14 @@ namespace pugi
 	private:
 		char_t* _buffer;
 
-		char _memory[192];
+		char _memory[256];
 		
 		// Non-copyable semantics
 		xml_document(const xml_document&);
 		const xml_document& operator=(const xml_document&);
 
 		void create();
-		void destroy();
+		void destroy(bool keep_pages);
 
 	public:
 		// Default constructor, makes empty document
@@ -953,6 +997,28 @@ namespace pugi
 		// Removes all nodes, then copies the entire contents of the specified document
 		void reset(const xml_document& proto);
 
+		// Keep the memory pages of the old document on reset() and load, so that loading a document of similar size again
+		// does not touch the heap. Kept pages are freed by the destructor or by turning reuse off.
+		// Use load_buffer_inplace to avoid the copy of the input buffer as well.
+		void set_memory_reuse(bool reuse);
+
+		// Allocate nodes and strings from a caller-owned block instead of the heap; removes all nodes. The block has to
+		// outlive the document, loading fails with status_out_of_memory if the document does not fit and reset() rewinds
+		// the whole block. Pass 0 to go back to the heap.
+		void set_arena(void* memory, size_t size);
+
+	#ifndef PUGIXML_NO_XPATH
+		// Index elements with the given name by the value of the given attribute, so that XPath steps like
+		// //element[@attribute = 'value'] look their matches up instead of scanning the tree. Registrations survive
+		// reset() and loads. The index is built here and by every load and append_buffer, never by queries, so any
+		// number of threads can query a document that is not being modified; after other edits queries scan the tree
+		// until the next load, or until add_attribute_index is called again.
+		bool add_attribute_index(const char_t* element, const char_t* attribute);
+
+		// Drop all indexes added with add_attribute_index
+		void clear_attribute_indexes();
+	#endif
+
 	#ifndef PUGIXML_NO_STL
 		// Load document from stream.
 		xml_parse_result load(std::basic_istream<char, std::char_traits<char> >& stream, unsigned int options = parse_default, xml_encoding encoding = encoding_auto);
@@ -969,6 +1035,12 @@ namespace pugi
 		xml_parse_result load_file(const char* path, unsigned int options = parse_default, xml_encoding encoding = encoding_auto);
 		xml_parse_result load_file(const wchar_t* path, unsigned int options = parse_default, xml_encoding encoding = encoding_auto);
 
+	#ifdef PUGIXML_HAS_POSIX_IO
+		// Load document from file by mapping it privately instead of reading it into a heap buffer; names and values point into the
+		// mapping and in-place parsing never changes the file. The file must not be modified or truncated while the document uses it.
+		xml_parse_result load_file_mmap(const char* path, unsigned int options = parse_minimal, xml_encoding encoding = encoding_auto);
+	#endif
+
 		// Load document from buffer. Copies/converts the buffer, so it may be deleted or changed after the function returns.
 		xml_parse_result load_buffer(const void* contents, size_t size, unsigned int options = parse_default, xml_encoding encoding = encoding_auto);
 
@@ -980,6 +1052,13 @@ namespace pugi
 		// You should allocate the buffer with pugixml allocation function; document will free the buffer when it is no longer needed (you can't use it anymore).
 		xml_parse_result load_buffer_inplace_own(void* contents, size_t size, unsigned int options = parse_default, xml_encoding encoding = encoding_auto);
 
+		// Load document incrementally from chunks of data, e.g. as they arrive over a socket. load_begin resets the document (returns false if out of memory).
+		// After each load_chunk call, children of the document element that are complete are already in the tree. load_end parses the rest and returns the result for the whole stream.
+		// Only UTF-8 and Latin-1 input is processed as it arrives, and none in wchar mode; the rest is accumulated and parsed by load_end.
+		bool load_begin(unsigned int options = parse_default, xml_encoding encoding = encoding_auto);
+		xml_parse_result load_chunk(const void* contents, size_t size);
+		xml_parse_result load_end();
+
 		// Save XML document to writer (semantics is slightly different from xml_node::print, see documentation for details).
 		void save(xml_writer& writer, const char_t* indent = PUGIXML_TEXT("\t"), unsigned int flags = format_default, xml_encoding encoding = encoding_auto) const;
 
@@ -997,6 +1076,96 @@ namespace pugi
 		xml_node document_element() const;
 	};
 
+	// Source of raw document bytes for xml_reader
+	class PUGIXML_CLASS xml_reader_source
+	{
+	public:
+		virtual ~xml_reader_source() {}
+
+		// Read up to size bytes into data; returns the number of bytes read, 0 at end of input
+		virtual size_t read(void* data, size_t size) = 0;
+	};
+
+	// xml_reader_source implementation for FILE*
+	class PUGIXML_CLASS xml_reader_source_file: public xml_reader_source
+	{
+	public:
+		// Construct source from a FILE* object; void* is used to avoid header dependencies on stdio
+		xml_reader_source_file(void* file);
+
+		virtual size_t read(void* data, size_t size);
+
+	private:
+		void* file;
+	};
+
+	// Events returned by xml_reader::next
+	enum xml_reader_event
+	{
+		event_none,				// No event yet (open was not called or failed)
+		event_start_element,	// Start tag; name() and attributes are available. An empty element tag also produces a matching event_end_element
+		event_end_element,		// End tag; name() is available
+		event_text,				// PCDATA or CDATA inside an element; value() is available. Long runs of text may arrive as several events
+		event_end_document,		// The whole document was read
+		event_error				// Parsing failed; see result()
+	};
+
+	// Pull parser that reads a document through a fixed-size window, so memory use does not depend on document size.
+	// Uses the same character conversions as xml_document (parse_escapes, parse_eol, parse_wconv_attribute, parse_wnorm_attribute,
+	// parse_trim_pcdata, parse_ws_pcdata, parse_cdata) and the same encoding detection. Comments, declarations, processing
+	// instructions and doctype are skipped. A single tag or CDATA section has to fit in the window, otherwise parsing
+	// fails with status_out_of_memory. Names and values returned by the reader stay valid until the next call to next().
+	class PUGIXML_CLASS xml_reader
+	{
+	private:
+		xml_reader_struct* _impl;
+
+		// Non-copyable semantics
+		xml_reader(const xml_reader&);
+		const xml_reader& operator=(const xml_reader&);
+
+	public:
+		// Construct reader with a window of the specified size (in char_t units)
+		explicit xml_reader(size_t window_size = 65536);
+
+		~xml_reader();
+
+		// Start reading from a source; the source has to outlive the reader or the next call to open
+		bool open(xml_reader_source& source, unsigned int options = parse_default, xml_encoding encoding = encoding_auto);
+
+		// Start reading from a file
+		bool open_file(const char* path, unsigned int options = parse_default, xml_encoding encoding = encoding_auto);
+		bool open_file(const wchar_t* path, unsigned int options = parse_default, xml_encoding encoding = encoding_auto);
+
+		// Start reading from a memory buffer. The buffer is not copied as a whole, so it has to outlive the reader
+		bool open_buffer(const void* contents, size_t size, unsigned int options = parse_default, xml_encoding encoding = encoding_auto);
+
+		// Stop reading and release the source (closes files opened with open_file)
+		void close();
+
+		// Advance to the next event
+		xml_reader_event next();
+
+		// Current event and its data
+		xml_reader_event event() const;
+		const char_t* name() const;
+		const char_t* value() const;
+
+		// Attributes of the current event_start_element
+		size_t attribute_count() const;
+		const char_t* attribute_name(size_t index) const;
+		const char_t* attribute_value(size_t index) const;
+
+		// Get value of the attribute with the specified name, or 0 if there is no such attribute
+		const char_t* attribute_value(const char_t* name) const;
+
+		// Number of open elements (includes the current element after event_start_element)
+		size_t depth() const;
+
+		// Parsing status; offset is in char_t units from the start of the stream
+		xml_parse_result result() const;
+	};
+
 #ifndef PUGIXML_NO_XPATH
 	// XPath query return type
 	enum xpath_value_type
@@ -1142,6 +1311,14 @@ namespace pugi
 		// If PUGIXML_NO_EXCEPTIONS is defined, returns empty node set instead.
 		xpath_node_set evaluate_node_set(const xpath_node& n) const;
 
+	#ifdef PUGIXML_HAS_THREADS
+		// Evaluate expression as node set like evaluate_node_set, splitting child and descendant steps over the subtrees below the context
+		// node between worker threads (0 uses one per hardware thread). Steps with position-dependent predicates, and steps over a few thousand
+		// nodes or less, run on the calling thread. The worker threads are started on first use and kept until the program exits.
+		// The document and the variables must not be modified until the evaluation returns.
+		xpath_node_set evaluate_node_set_parallel(const xpath_node& n, unsigned int threads = 0) const;
+	#endif
+
 		// Evaluate expression as node set in the specified context.
 		// Return first node in document order, or empty node if node set is empty.
 		// If PUGIXML_NO_EXCEPTIONS is not defined, throws xpath_exception on type mismatch and std::bad_alloc on out of memory errors.
@@ -1157,6 +1334,58 @@ namespace pugi
 		// Borland C++ workaround
 		bool operator!() const;
 	};
+
+	struct xpath_query_cache_entry;
+
+	// A cache of compiled XPath queries keyed by expression text and variable set, for code that runs the same queries over and over.
+	// Cached queries refer to the variables of their set, so values assigned to the set later are used by the next evaluation;
+	// call remove() before destroying a variable set that was used with the cache. The cache is not thread-safe.
+	class PUGIXML_CLASS xpath_query_cache
+	{
+	private:
+		xpath_query_cache_entry* _data[64];
+
+		// least recently used entries are evicted first
+		xpath_query_cache_entry* _lru_head;
+		xpath_query_cache_entry* _lru_tail;
+
+		size_t _size;
+		size_t _capacity;
+
+		size_t _hits;
+		size_t _misses;
+
+		// Non-copyable semantics
+		xpath_query_cache(const xpath_query_cache&);
+		xpath_query_cache& operator=(const xpath_query_cache&);
+
+		void destroy(xpath_query_cache_entry* entry);
+
+	public:
+		// Construct a cache that holds at most capacity queries
+		explicit xpath_query_cache(size_t capacity = 256);
+		~xpath_query_cache();
+
+		// Get the compiled query for the expression, compiling it on a miss. The query stays valid until it is evicted by a later miss,
+		// removed or cleared.
+		// If PUGIXML_NO_EXCEPTIONS is not defined, throws xpath_exception on compilation errors (such queries are not cached) and std::bad_alloc on out of memory errors.
+		// If PUGIXML_NO_EXCEPTIONS is defined, compilation errors are cached like any other query (check result()) and 0 is returned on out of memory errors.
+		const xpath_query* get(const char_t* query, xpath_variable_set* variables = 0);
+
+		// Remove all queries compiled against the variable set
+		void remove(const xpath_variable_set* variables);
+
+		// Remove all queries; hit and miss counters are kept
+		void clear();
+
+		// Number of cached queries, and number of lookups that found a compiled query or had to compile one
+		size_t size() const;
+		size_t hits() const;
+		size_t misses() const;
+
+		// Cache shared by the whole process
+		static xpath_query_cache& global();
+	};
 	
 	#ifndef PUGIXML_NO_EXCEPTIONS
 	// XPath exception class
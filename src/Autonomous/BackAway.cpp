@@ -6,39 +6,36 @@ namespace dreadbot
 	{
 		sysLog->log("State: BackAway");
 		drivebase->Drive_v(0, 0, 0);
-		timerActive = false; //Cheat way of figuring out if the lift is down. Used elsewhere
+		restart();
 	}
 	int BackAway::update()
 	{
-		//While the lift isn't down
-		if (!timerActive)
-		{
-			lift->Set(-1);
+		ROUTINE_BEGIN();
 
-			//On first lift down
-			if (isLiftDown())
-			{
-				timerActive = true;
-				liftArms->Set(-1);
-				Wait(0.13); //Uber cheap way of getting the totes to disengage
-				grabTimer.Reset();
-				grabTimer.Start();
-			}
-			return RoboState::no_update;
-		}
+		//Lower the lift, then open the arms so the totes disengage
+		lift->Set(-1);
+		ROUTINE_AWAIT_UNTIL(isLiftDown());
+		liftArms->Set(-1);
+		ROUTINE_AWAIT_TIME(0.13); //Uber cheap way of getting the totes to disengage
 
-		if (grabTimer.Get() >= BACK_AWAY_TIME)
+		startRoutineTimer();
+		startDistance();
+		if (!profiles->backAway.isEmpty())
 		{
-			drivebase->Drive_v(0, 0, 0);
-			return RoboState::timerExpired;
+			ROUTINE_AWAIT_UNTIL(followProfile(profiles->backAway, routineTimer, axisForward, -1));
 		}
-
-		if (drivebase != nullptr) 
+		else
 		{
-			drivebase->GoFast();
-			drivebase->Drive_v(0, -1, 0);
+			ROUTINE_WHILE(!driveFinished(routineTimer, BACK_AWAY_TIME, axisForward, -1, BACK_AWAY_DISTANCE),
+			{
+				drivebase->GoFast();
+				drivebase->Drive_v(0, -1, 0);
+			});
 		}
-		//liftArms->Set(-1);
-		return RoboState::no_update;
+		logDistance("BackAway");
+		drivebase->Drive_v(0, 0, 0);
+		ROUTINE_RETURN(RoboState::timerExpired);
+
+		ROUTINE_END();
 	}
 }
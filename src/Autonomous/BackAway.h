@@ -1,10 +1,10 @@
 #pragma once
 
-#include "ForkGrab.h"
+#include "Routine.h"
 
 namespace dreadbot
 {
-	class BackAway : public ForkGrab
+	class BackAway : public Routine
 	{
 	public:
 		virtual void enter();
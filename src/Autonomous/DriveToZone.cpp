@@ -4,6 +4,13 @@ namespace dreadbot
 {
 	DriveToZone::DriveToZone() 
 	{
+		reset();
+	}
+	void DriveToZone::reset()
+	{
+		RoboState::reset();
+		driveTimer.Stop();
+		driveTimer.Reset();
 		timerActive = false;
 		strafe = false;
 		dir = 1; //Multiplier that changes the direction the robot moves.
@@ -12,6 +19,7 @@ namespace dreadbot
 	{
 		driveTimer.Reset();
 		driveTimer.Start();
+		startDistance();
 		timerActive = true;
 		if (RoboState::toteCount < 3)
 			lift->Set(1); //Raise the lift for tote transit - it's more stable that way.
@@ -20,12 +28,25 @@ namespace dreadbot
 	int DriveToZone::update()
 	{
 		float drvZoneTime = DRIVE_TO_ZONE_TIME;
+		float drvZoneDistance = DRIVE_TO_ZONE_DISTANCE;
 		if (RoboState::toteCount == 0)
-			drvZoneTime += 0.4f; //The robot starts farther back when no tote is collected. This adds on additional time to make sure the robot still drives far enough.
+		{
+			//The robot starts farther back when no tote is collected. This makes sure the robot still drives far enough.
+			drvZoneTime += 0.4f;
+			drvZoneDistance += NO_TOTE_EXTRA_DISTANCE;
+		}
 
-		//Break once the robot has moved far enough - timing based.
-		if ((driveTimer.Get() >= drvZoneTime && !strafe) || (driveTimer.Get() >= STRAFE_TO_ZONE_TIME && strafe))
+		//Break once the robot has moved far enough - along a motion profile, or timing based if not calibrated.
+		const MotionProfile& profile = strafe ? profiles->strafeToZone : (RoboState::toteCount == 0 ? profiles->driveToZoneNoTote : profiles->driveToZone);
+		bool finished;
+		if (!profile.isEmpty())
+			finished = strafe ? followProfile(profile, driveTimer, axisStrafe, 1) : followProfile(profile, driveTimer, axisForward, dir);
+		else
+			finished = (!strafe && driveFinished(driveTimer, drvZoneTime, axisForward, dir, drvZoneDistance)) ||
+				(strafe && driveFinished(driveTimer, STRAFE_TO_ZONE_TIME, axisStrafe, 1, STRAFE_TO_ZONE_DISTANCE));
+		if (finished)
 		{
+			logDistance("DriveToZone");
 			driveTimer.Stop();
 			driveTimer.Reset();
 			timerActive = false;
@@ -34,7 +55,7 @@ namespace dreadbot
 		}
 
 		//Apply actual velocity changes
-		if (drivebase != nullptr)
+		if (drivebase != nullptr && profile.isEmpty())
 		{
 			if (strafe)
 				drivebase->Drive_v(1, 0, 0); //Right
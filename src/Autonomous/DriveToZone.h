@@ -8,6 +8,7 @@ namespace dreadbot
 	{
 	public:
 		DriveToZone();
+		virtual void reset();
 		virtual void enter();
 		virtual int update();
 		Timer driveTimer;
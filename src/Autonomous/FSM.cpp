@@ -2,28 +2,84 @@
 
 namespace dreadbot
 {
-	void FiniteStateMachine::init(FSMTransition* newStateTable, FSMState* initState)
+	FiniteStateMachine::FiniteStateMachine()
+	{
+		stateTable = nullptr;
+		currentState = nullptr;
+		stateCount = 0;
+		currentStateID = -1;
+	}
+	int FiniteStateMachine::getStateID(FSMState* state)
+	{
+		for (int id = 0; id < stateCount; id++)
+			if (states[id] == state)
+				return id;
+
+		if (stateCount == FSM_MAX_STATES)
+			return -1;
+
+		states[stateCount] = state;
+		for (int input = 0; input < FSM_MAX_INPUTS; input++)
+		{
+			dispatch[stateCount][input] = nullptr;
+			nextStateIDs[stateCount][input] = -1;
+		}
+		return stateCount++;
+	}
+	bool FiniteStateMachine::init(FSMTransition* newStateTable, int tableSize, FSMState* initState)
 	{
 		this->stateTable = newStateTable;
+		this->currentState = nullptr;
+		this->currentStateID = -1;
+		this->stateCount = 0;
+
+		if (initState == nullptr || getStateID(initState) < 0)
+			return false;
+
+		for (int row = 0; row < tableSize && newStateTable[row].currentState != nullptr; row++)
+		{
+			FSMTransition* transition = &newStateTable[row];
+			int from = getStateID(transition->currentState);
+			int to = transition->nextState != nullptr ? getStateID(transition->nextState) : -1;
+			if (from < 0 || to < 0 || transition->input < 0 || transition->input >= FSM_MAX_INPUTS)
+			{
+				stateCount = 0;
+				return false;
+			}
+
+			//The first matching row wins, as it did when the table was scanned linearly
+			if (dispatch[from][transition->input] == nullptr)
+			{
+				dispatch[from][transition->input] = transition;
+				nextStateIDs[from][transition->input] = to;
+			}
+		}
+
+		this->currentStateID = 0; //initState was registered first
 		this->currentState = initState;
 		this->currentState->enter();
+		return true;
 	}
 	void FiniteStateMachine::update()
 	{
+		if (currentStateID < 0)
+			return;
+
 		int input = currentState->update();
-		for (auto state = &this->stateTable[0]; state->currentState != nullptr; state++)
-		{
-			if (state->input == input && state->currentState == this->currentState)
-			{
-				if (state->action != nullptr) {
-					state->action(input, state->currentState, state->nextState);
-				}
-				if (state->nextState != this->currentState) {
-					state->nextState->enter();
-				}
-				this->currentState = state->nextState;
-				break;
-			}
+		if (input < 0 || input >= FSM_MAX_INPUTS)
+			return;
+
+		FSMTransition* transition = dispatch[currentStateID][input];
+		if (transition == nullptr)
+			return;
+
+		if (transition->action != nullptr) {
+			transition->action(input, transition->currentState, transition->nextState);
+		}
+		if (transition->nextState != this->currentState) {
+			transition->nextState->enter();
 		}
+		this->currentState = transition->nextState;
+		this->currentStateID = nextStateIDs[currentStateID][input];
 	}
 }
@@ -2,6 +2,9 @@
 
 #define END_STATE_TABLE {nullptr, 0, nullptr, nullptr}
 
+#define FSM_MAX_STATES 16 //Distinct states a single transition table may reference
+#define FSM_MAX_INPUTS 8 //State update() return values must be in [0, FSM_MAX_INPUTS)
+
 namespace dreadbot
 {
 	class FSMState
@@ -24,11 +27,23 @@ namespace dreadbot
 	class FiniteStateMachine
 	{
 	public:
-		virtual void init(FSMTransition* newStateTable, FSMState* initState);
+		FiniteStateMachine();
+		//Compiles the table (up to tableSize rows or END_STATE_TABLE) into the dispatch matrix. Returns false and leaves the
+		//machine stopped if the table is malformed: too many states or inputs, or a row without a next state.
+		virtual bool init(FSMTransition* newStateTable, int tableSize, FSMState* initState);
 		virtual void update();
 		virtual ~FiniteStateMachine() {}
 	protected:
+		int getStateID(FSMState* state); //Assigns IDs in order of first appearance; -1 if the table has too many states
+
 		FSMTransition* stateTable;
 		FSMState* currentState;
+
+		//Compiled form of stateTable. dispatch[state][input] is the transition taken, or nullptr to stay put.
+		FSMState* states[FSM_MAX_STATES];
+		int nextStateIDs[FSM_MAX_STATES][FSM_MAX_INPUTS];
+		FSMTransition* dispatch[FSM_MAX_STATES][FSM_MAX_INPUTS];
+		int stateCount;
+		int currentStateID;
 	};
 }
@@ -0,0 +1,125 @@
+#include <cstdio>
+#include "WPILib.h"
+#include "Timer.h"
+#include "FSMProfiler.h"
+
+namespace dreadbot
+{
+	static string formatTime(double seconds)
+	{
+		char buffer[32];
+		snprintf(buffer, sizeof(buffer), "%.4f", seconds);
+		return buffer;
+	}
+
+	FSMProfiler::FSMProfiler()
+	{
+		eventCount = 0;
+		stateCount = 0;
+		current = -1;
+		startTime = 0;
+		enteredAt = 0;
+	}
+	double FSMProfiler::now()
+	{
+		return Timer::GetFPGATimestamp();
+	}
+	void FSMProfiler::begin(const char* const* stateNames, int newStateCount, int initialState)
+	{
+		stateCount = newStateCount < FSM_PROFILE_STATES ? newStateCount : FSM_PROFILE_STATES;
+		for (int state = 0; state < stateCount; state++)
+		{
+			names[state] = stateNames[state];
+			entries[state] = 0;
+			updates[state] = 0;
+			dwell[state] = 0;
+			updateTime[state] = 0;
+			worstUpdate[state] = 0;
+		}
+		eventCount = 0;
+		startTime = now();
+		enteredAt = startTime;
+		current = initialState < stateCount ? initialState : -1;
+		if (current >= 0)
+			entries[current]++;
+	}
+	void FSMProfiler::recordUpdate(int state, double seconds)
+	{
+		if (state < 0 || state >= stateCount)
+			return;
+		updates[state]++;
+		updateTime[state] += seconds;
+		if (seconds > worstUpdate[state])
+			worstUpdate[state] = seconds;
+	}
+	void FSMProfiler::recordTransition(int from, int input, int to)
+	{
+		if (from < 0 || from >= stateCount || to < 0 || to >= stateCount)
+			return;
+
+		double time = now();
+		Event& event = events[eventCount % FSM_PROFILE_EVENTS];
+		event.time = time;
+		event.from = from;
+		event.input = input;
+		event.to = to;
+		eventCount++;
+
+		if (current >= 0)
+			dwell[current] += time - enteredAt;
+		enteredAt = time;
+		current = to;
+		entries[current]++;
+	}
+	bool FSMProfiler::isActive() const
+	{
+		return stateCount > 0;
+	}
+	void FSMProfiler::report(Log* log)
+	{
+		if (log == nullptr || !isActive())
+			return;
+
+		//The state that is still running has been in it since its last transition
+		double end = now();
+		if (current >= 0)
+		{
+			dwell[current] += end - enteredAt;
+			enteredAt = end;
+		}
+
+		stringstream header;
+		header << "FSM profile: " << formatTime(end - startTime) << " s, " << eventCount << " transitions";
+		log->log(header.str(), info);
+
+		int first = eventCount > FSM_PROFILE_EVENTS ? eventCount - FSM_PROFILE_EVENTS : 0;
+		if (first > 0)
+		{
+			stringstream dropped;
+			dropped << "FSM timeline: first " << first << " transitions overwritten";
+			log->log(dropped.str(), info);
+		}
+		for (int i = first; i < eventCount; i++)
+		{
+			const Event& event = events[i % FSM_PROFILE_EVENTS];
+			stringstream line;
+			line << "FSM timeline: +" << formatTime(event.time - startTime) << " s  " << names[event.from]
+				<< " --" << event.input << "--> " << names[event.to];
+			log->log(line.str(), info);
+		}
+
+		log->log("FSM summary: id, state, entries, dwell s, updates, mean update us, worst update us", info);
+		for (int state = 0; state < stateCount; state++)
+		{
+			stringstream line;
+			line << "FSM summary: " << state << ", " << names[state] << ", " << entries[state] << ", " << formatTime(dwell[state])
+				<< ", " << updates[state] << ", " << (int)(1e6 * (updates[state] ? updateTime[state] / updates[state] : 0))
+				<< ", " << (int)(1e6 * worstUpdate[state]);
+			log->log(line.str(), info);
+		}
+
+		//A run is reported once
+		stateCount = 0;
+		current = -1;
+	}
+}
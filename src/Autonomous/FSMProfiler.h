@@ -0,0 +1,48 @@
+#pragma once
+
+#include "../../lib/Logger.h"
+using namespace Hydra;
+
+#define FSM_PROFILE_EVENTS 256 //Transitions kept for the timeline; older ones are overwritten
+#define FSM_PROFILE_STATES 32
+
+namespace dreadbot
+{
+	//Records what a state machine did during one run: a ring buffer of transitions (timestamp, from, input, to), and per
+	//state the number of entries, total dwell time and worst-case update() time. Recording never allocates or logs;
+	//report() writes the timeline and a summary table to a log afterwards (HALBot does so at DisabledInit).
+	class FSMProfiler
+	{
+	public:
+		FSMProfiler();
+		void begin(const char* const* stateNames, int newStateCount, int initialState); //Starts a new run; the names must outlive it
+		void recordUpdate(int state, double seconds);
+		void recordTransition(int from, int input, int to);
+		void report(Log* log); //Ends the run; does nothing if no run was started since the last report
+		bool isActive() const;
+		static double now(); //Monotonic time in seconds
+	private:
+		struct Event
+		{
+			double time;
+			int from;
+			int input;
+			int to;
+		};
+
+		Event events[FSM_PROFILE_EVENTS];
+		int eventCount; //Total recorded; only the last FSM_PROFILE_EVENTS are kept
+
+		const char* names[FSM_PROFILE_STATES];
+		int entries[FSM_PROFILE_STATES];
+		int updates[FSM_PROFILE_STATES];
+		double dwell[FSM_PROFILE_STATES];
+		double updateTime[FSM_PROFILE_STATES];
+		double worstUpdate[FSM_PROFILE_STATES];
+		int stateCount;
+
+		int current;
+		double startTime;
+		double enteredAt;
+	};
+}
@@ -4,17 +4,54 @@ namespace dreadbot
 {
 	ForkGrab::ForkGrab()
 	{
+		reset();
+	}
+	void ForkGrab::reset()
+	{
+		RoboState::reset();
 		timerActive = false;
+		grabTimer.Stop();
+		grabTimer.Reset();
+		thing = true;
 	}
 	void ForkGrab::enter()
 	{
 		sysLog->log("State: ForkGrab");
+		step = noStep;
 		grabTimer.Reset();
 		grabTimer.Start();
 	}
-	bool thing = true; //PARKER, NO!
 	int ForkGrab::update()
 	{
+		//Continue a sequence started on an earlier tick
+		if (step != noStep)
+		{
+			if (stepPending())
+				return RoboState::no_update;
+
+			int finished = step;
+			step = noStep;
+			if (finished == engageStep)
+			{
+				lift->Set(0);
+				return RoboState::finish;
+			}
+			if (finished == correctionStep)
+			{
+				drivebase->Drive_v(0, 0, 0);
+				drivebase->GoSlow();
+				lift->Set(1);
+
+				//Heading for another tote: the lift region of the next state waits for the totes to engage while driving
+				if (RoboState::toteCount < RoboState::neededTCount)
+					return RoboState::nextTote;
+
+				startStep(settleStep, 0.3);
+				return RoboState::no_update;
+			}
+			return RoboState::finish;
+		}
+
 		if (RoboState::toteCount >= 2 && grabTimer.Get() >= LIFT_ENGAGEMENT_DELAY)
 		{
 			intakeArms->Set(1);
@@ -24,9 +61,8 @@ namespace dreadbot
 			{
 				//XMLInput::getInstance()->getPGroup("liftArms")->Set(0);
 				lift->Set(1); //Raise lift
-				Wait(0.3); //Totes must engage first
-				lift->Set(0);
-				return RoboState::finish;
+				startStep(engageStep, 0.3); //Totes must engage first
+				return RoboState::no_update;
 			} else {
 				return RoboState::no_update;
 			}
@@ -44,22 +80,14 @@ namespace dreadbot
 			if (RoboState::toteCount >= 3 && RoboState::toteCount >= RoboState::neededTCount)
 			{
 				lift->Set(1); //Raise lift
-				Wait(0.25); //Totes must engage first
-				lift->Set(0);
-				return RoboState::finish;
+				startStep(engageStep, 0.25); //Totes must engage first
+				return RoboState::no_update;
 			}
 			//Raise the lift and cheat to alight the tote
 			drivebase->GoFast();
 			drivebase->Drive_v(0, STACK_CORRECTION_SPEED, 0); // @todo Calibrate
-			Wait(STACK_CORRECTION_TIME);
-			drivebase->Drive_v(0, 0, 0);
-			drivebase->GoSlow();
-			lift->Set(1);
-			Wait(0.3);
-			if (RoboState::toteCount >= RoboState::neededTCount)
-				return RoboState::finish;
-			else
-				return RoboState::nextTote;
+			startStep(correctionStep, STACK_CORRECTION_TIME); //Then stop, raise the lift and let it settle
+			return RoboState::no_update;
 		}
 		drivebase->Drive_v(0, 0, 0);
 		if (lift != nullptr)
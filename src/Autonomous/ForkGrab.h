@@ -8,10 +8,13 @@ namespace dreadbot
 	{
 	public:
 		ForkGrab();
+		virtual void reset();
 		virtual void enter();
 		virtual int update();
 		Timer grabTimer;
 	protected:
+		enum steps {noStep, engageStep, correctionStep, settleStep};
 		bool timerActive;
+		bool thing; //PARKER, NO! Was a global, so it never came back on between runs
 	};
 }
@@ -4,7 +4,16 @@ namespace dreadbot
 {
 	GettingTote::GettingTote()
 	{
+		reset();
+	}
+	void GettingTote::reset()
+	{
+		RoboState::reset();
 		timerActive = false;
+		getTimer.Stop();
+		getTimer.Reset();
+		eStopTimer.Stop();
+		eStopTimer.Reset();
 	}
 	void GettingTote::enter()
 	{
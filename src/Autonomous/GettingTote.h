@@ -8,6 +8,7 @@ namespace dreadbot
 	{
 	public:
 		GettingTote();
+		virtual void reset();
 		virtual void enter();
 		virtual int update();
  	private:
@@ -2,41 +2,49 @@
 
 namespace dreadbot
 {
+	void AutonStates::reset()
+	{
+		gettingTote.reset();
+		driveToZone.reset();
+		forkGrab.reset();
+		rotate.reset();
+		rotate2.reset();
+		stopped.reset();
+		pushContainer.reset();
+		backAway.reset();
+		rotateDrive.reset();
+		strafeLeft.reset();
+		raiseLift.reset();
+		pushAndRaise.reset();
+	}
+
 	HALBot::HALBot()
 	{
 		sysLog = nullptr;
-		stopped = new Stopped;
-		gettingTote = new GettingTote;
-		driveToZone = new DriveToZone;
-		rotate = new Rotate;
-		rotate2 = new Rotate;
-		forkGrab = new ForkGrab;
-		pushContainer = new PushContainer;
-		backAway = new BackAway;
-		fsm = new FiniteStateMachine;
-		rotateDrive = new RotateDrive;
-		strafeLeft = new StrafeLeft;
+		mode = AUTON_MODE_STOP;
+		stopMode.setProfiler(&profiler);
+		driveMode.setProfiler(&profiler);
+		toteMode.setProfiler(&profiler);
+		containerMode.setProfiler(&profiler);
+		stack2Mode.setProfiler(&profiler);
+		stack3Mode.setProfiler(&profiler);
+		states.pushAndRaise.init(&states.pushContainer, &states.raiseLift);
 	}
 	HALBot::~HALBot()
 	{
-		delete stopped;
-		delete gettingTote;
-		delete driveToZone;
-		delete rotate;
-		delete rotateDrive;
-		delete forkGrab;
-		delete pushContainer;
-		delete backAway;
-		delete fsm;
-		delete strafeLeft;
 		RoboState::toteCount = 0;
 		RoboState::neededTCount = 0;
 	}
-	void HALBot::init(MecanumDrive* drivebase, MotorGrouping* intake, PneumaticGrouping* lift)
+	void HALBot::init(MecanumDrive* drivebase, MecanumOdometry* odometry, MotorGrouping* intake, PneumaticGrouping* lift)
 	{
-		int i;
+		//Reset every state so that nothing (timers, flags, counters) carries over from the last run
+		states.reset();
+		RoboState::toteCount = 0;
+		RoboState::neededTCount = 0;
+
 		sysLog = Logger::getInstance()->getLog("sysLog");
 		RoboState::drivebase = drivebase;
+		RoboState::odometry = odometry;
 		RoboState::intake = intake;
 		RoboState::lift = lift;
 		RoboState::liftArms = XMLInput::getInstance()->getPGroup("liftArms");
@@ -44,107 +52,110 @@ namespace dreadbot
 		RoboState::pusher1 = XMLInput::getInstance()->getPWMMotor(0);
 		RoboState::pusher2 = XMLInput::getInstance()->getPWMMotor(1);
 		RoboState::sysLog = sysLog;
-		pushContainer->pushConstant = 1;
+		generateProfiles();
+		RoboState::profiles = &profiles;
+		states.pushContainer.pushConstant = 1;
 
-		//Apply state tables and set the starting state. Note that RoboState::neededTCount is 0 before this.
-		FSMState* defState = nullptr;
-		AutonMode mode = GetAutonMode();
+		//Configure the states and start the machine of the selected mode. Note that RoboState::neededTCount is 0 before this.
+		mode = GetAutonMode();
 		if (mode == AUTON_MODE_STOP)
 		{
-			i = 0;
-			transitionTable[i++] = {stopped, RoboState::no_update, nullptr, stopped};
-			transitionTable[i++] = END_STATE_TABLE;
-			defState = stopped;
+			static const char* const names[] = {"stopped"};
+			stopMode.init(names, &states.stopped);
 		}
 		if (mode == AUTON_MODE_DRIVE)
 		{
-			i = 0;
-			driveToZone->strafe = false;
-			driveToZone->dir = -1;
-			transitionTable[i++] = {driveToZone, RoboState::timerExpired, nullptr, rotate};
-			transitionTable[i++] = {rotate, RoboState::timerExpired, nullptr, stopped};
-			transitionTable[i++] = {stopped, RoboState::no_update, nullptr, stopped};
-			transitionTable[i++] = END_STATE_TABLE;
-			defState = driveToZone;
+			states.driveToZone.strafe = false;
+			states.driveToZone.dir = -1;
+			static const char* const names[] = {"driveToZone", "rotate", "stopped"};
+			driveMode.init(names, &states.driveToZone, &states.rotate, &states.stopped);
 		}
 		if (mode == AUTON_MODE_TOTE)
 		{
-			i = 0;
 			RoboState::neededTCount = 1;
-			rotate->rotateConstant = 1;
-			driveToZone->strafe = false;
-			transitionTable[i++] = {gettingTote, RoboState::timerExpired, nullptr, forkGrab};
-			transitionTable[i++] = {forkGrab, RoboState::finish, nullptr, rotate};
-			transitionTable[i++] = {rotate, RoboState::timerExpired, nullptr, driveToZone};
-			transitionTable[i++] = {driveToZone, RoboState::timerExpired, nullptr, rotate2};
-			transitionTable[i++] = {rotate2, RoboState::timerExpired, nullptr, stopped};
-			transitionTable[i++] = {gettingTote, RoboState::eStop, nullptr, stopped};
-			transitionTable[i++] = {stopped, RoboState::no_update, nullptr, stopped};
-			transitionTable[i++] = END_STATE_TABLE;
-			defState = gettingTote;
+			states.rotate.rotateConstant = 1;
+			states.driveToZone.strafe = false;
+			static const char* const names[] = {"gettingTote", "forkGrab", "rotate", "driveToZone", "rotate2", "stopped"};
+			toteMode.init(names, &states.gettingTote, &states.forkGrab, &states.rotate, &states.driveToZone, &states.rotate2, &states.stopped);
 		}
 		if (mode == AUTON_MODE_CONTAINER)
 		{
-			driveToZone->strafe = true;
-			i = 0;
-			rotate->rotateConstant = -1;
-			transitionTable[i++] = {rotate, RoboState::timerExpired, nullptr, driveToZone};
-			transitionTable[i++] = {driveToZone, RoboState::timerExpired, nullptr, stopped};
-			transitionTable[i++] = END_STATE_TABLE;
+			states.driveToZone.strafe = true;
+			states.rotate.rotateConstant = -1;
+			static const char* const names[] = {"rotate", "driveToZone", "stopped"};
+			containerMode.init(names, &states.rotate, &states.driveToZone, &states.stopped);
 		}
 		if (mode == AUTON_MODE_BOTH)
 		{
 			//Not really used.
-			i = 0;
 			RoboState::neededTCount = 1;
-			transitionTable[i++] = {stopped, RoboState::no_update, nullptr, stopped};
-			transitionTable[i++] = END_STATE_TABLE;
-			defState = stopped;
+			static const char* const names[] = {"stopped"};
+			stopMode.init(names, &states.stopped);
 		}
 		if (mode == AUTON_MODE_STACK2)
 		{
-			i = 0;
-			rotateDrive->rotateConstant = -1;
-			pushContainer->pushConstant = -1;
-			pushContainer->enableScaling = true;
-			driveToZone->strafe = false;
+			states.rotateDrive.rotateConstant = -1;
+			states.pushContainer.pushConstant = -1;
+			states.pushContainer.enableScaling = true;
+			states.driveToZone.strafe = false;
 			RoboState::toteCount++; //We already have a tote
 			RoboState::neededTCount = 2;
-
-			transitionTable[i++] = {pushContainer, RoboState::timerExpired, nullptr, gettingTote};
-			transitionTable[i++] = {gettingTote, RoboState::timerExpired, nullptr, forkGrab};
-			transitionTable[i++] = {gettingTote, RoboState::eStop, nullptr, stopped};
-			transitionTable[i++] = {forkGrab, RoboState::finish, nullptr, strafeLeft};
-			transitionTable[i++] = {forkGrab, RoboState::nextTote, nullptr, pushContainer};
-			transitionTable[i++] = {strafeLeft, RoboState::timerExpired, nullptr, rotateDrive};
-			transitionTable[i++] = {rotateDrive, RoboState::timerExpired, nullptr, stopped};
-			transitionTable[i++] = {stopped, RoboState::no_update, nullptr, stopped};
-			defState = pushContainer;
+			static const char* const names[] = {"pushContainer", "gettingTote", "forkGrab", "pushAndRaise", "strafeLeft", "rotateDrive", "stopped"};
+			stack2Mode.init(names, &states.pushContainer, &states.gettingTote, &states.forkGrab, &states.pushAndRaise, &states.strafeLeft, &states.rotateDrive, &states.stopped);
 		}
 		if (mode == AUTON_MODE_STACK3)
 		{
-			i = 0;
-			rotateDrive->rotateConstant = -1;
-			pushContainer->pushConstant = -1;
-			pushContainer->enableScaling = true;
-			driveToZone->strafe = false;
+			states.rotateDrive.rotateConstant = -1;
+			states.pushContainer.pushConstant = -1;
+			states.pushContainer.enableScaling = true;
+			states.driveToZone.strafe = false;
 			RoboState::toteCount++; //We already have a tote
 			RoboState::neededTCount = 3;
-
-			transitionTable[i++] = {pushContainer, RoboState::timerExpired, nullptr, gettingTote};
-			transitionTable[i++] = {gettingTote, RoboState::timerExpired, nullptr, forkGrab};
-			transitionTable[i++] = {forkGrab, RoboState::nextTote, nullptr, pushContainer};
-			transitionTable[i++] = {forkGrab, RoboState::finish, nullptr, rotateDrive};
-			transitionTable[i++] = {rotateDrive, RoboState::timerExpired, nullptr, backAway};
-			transitionTable[i++] = {backAway, RoboState::timerExpired, nullptr, stopped};
-			transitionTable[i++] = {gettingTote, RoboState::eStop, nullptr, stopped};
-			defState = pushContainer;
+			static const char* const names[] = {"pushContainer", "gettingTote", "forkGrab", "pushAndRaise", "rotateDrive", "backAway", "stopped"};
+			stack3Mode.init(names, &states.pushContainer, &states.gettingTote, &states.forkGrab, &states.pushAndRaise, &states.rotateDrive, &states.backAway, &states.stopped);
 		}
-
-		fsm->init(transitionTable, defState);
 	}
 	void HALBot::update()
 	{
-		fsm->update();
+		switch (mode)
+		{
+		case AUTON_MODE_STOP:
+		case AUTON_MODE_BOTH:
+			stopMode.update();
+			break;
+		case AUTON_MODE_DRIVE:
+			driveMode.update();
+			break;
+		case AUTON_MODE_TOTE:
+			toteMode.update();
+			break;
+		case AUTON_MODE_CONTAINER:
+			containerMode.update();
+			break;
+		case AUTON_MODE_STACK2:
+			stack2Mode.update();
+			break;
+		case AUTON_MODE_STACK3:
+			stack3Mode.update();
+			break;
+		}
+	}
+	void HALBot::generateProfiles()
+	{
+		bool fits = profiles.driveToZone.generate(DRIVE_TO_ZONE_DISTANCE, PROFILE_MAX_VELOCITY, PROFILE_MAX_ACCELERATION);
+		fits &= profiles.driveToZoneNoTote.generate(DRIVE_TO_ZONE_DISTANCE + NO_TOTE_EXTRA_DISTANCE, PROFILE_MAX_VELOCITY, PROFILE_MAX_ACCELERATION);
+		fits &= profiles.strafeToZone.generate(STRAFE_TO_ZONE_DISTANCE, PROFILE_MAX_VELOCITY, PROFILE_MAX_ACCELERATION);
+		fits &= profiles.rotate.generate(ROTATE_DISTANCE, PROFILE_MAX_VELOCITY, PROFILE_MAX_ACCELERATION);
+		fits &= profiles.strafeLeft.generate(STRAFE_LEFT_DISTANCE, PROFILE_MAX_VELOCITY, PROFILE_MAX_ACCELERATION);
+		fits &= profiles.push.generate(PUSH_DISTANCE, PROFILE_MAX_VELOCITY, PROFILE_MAX_ACCELERATION);
+		for (int i = 0; i < 4; i++) //Scaled the same way as PushContainer scales its time
+			fits &= profiles.pushScaled[i].generate(PUSH_DISTANCE * (PUSH_TIME + (i - 1.f) / 3.f) / PUSH_TIME, PROFILE_MAX_VELOCITY, PROFILE_MAX_ACCELERATION);
+		fits &= profiles.backAway.generate(BACK_AWAY_DISTANCE, PROFILE_MAX_VELOCITY, PROFILE_MAX_ACCELERATION);
+		if (!fits)
+			sysLog->log("A drive distance is too long for a motion profile; that state drives on its timer instead", Hydra::error);
+	}
+	void HALBot::reportProfile()
+	{
+		profiler.report(sysLog);
 	}
 }
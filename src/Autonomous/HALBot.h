@@ -14,35 +14,106 @@
 #include "Stopped.h"
 #include "StrafeLeft.h"
 #include "RoboState.h"
+#include "StaticFSM.h"
+#include "Parallel.h"
+#include "RaiseLift.h"
 
 using namespace Hydra;
 
 namespace dreadbot 
 {
+	//Autonomous modes as compile-time state machines. The first state of each is the starting state; see StaticFSM.h.
+	namespace auton
+	{
+		typedef fsm::State<Rotate, 1> Rotate2; //Second rotation in the tote mode
+		typedef fsm::Parallel<PushContainer, RaiseLift> PushAndRaise; //Drive to the next tote while the lift engages the stack
+
+		typedef fsm::Machine<fsm::States<Stopped>, fsm::Transitions<
+			fsm::Transition<Stopped, RoboState::no_update, Stopped>>> StopMode;
+
+		typedef fsm::Machine<fsm::States<DriveToZone, Rotate, Stopped>, fsm::Transitions<
+			fsm::Transition<DriveToZone, RoboState::timerExpired, Rotate>,
+			fsm::Transition<Rotate, RoboState::timerExpired, Stopped>,
+			fsm::Transition<Stopped, RoboState::no_update, Stopped>>> DriveMode;
+
+		typedef fsm::Machine<fsm::States<GettingTote, ForkGrab, Rotate, DriveToZone, Rotate2, Stopped>, fsm::Transitions<
+			fsm::Transition<GettingTote, RoboState::timerExpired, ForkGrab>,
+			fsm::Transition<ForkGrab, RoboState::finish, Rotate>,
+			fsm::Transition<Rotate, RoboState::timerExpired, DriveToZone>,
+			fsm::Transition<DriveToZone, RoboState::timerExpired, Rotate2>,
+			fsm::Transition<Rotate2, RoboState::timerExpired, Stopped>,
+			fsm::Transition<GettingTote, RoboState::eStop, Stopped>,
+			fsm::Transition<Stopped, RoboState::no_update, Stopped>>> ToteMode;
+
+		typedef fsm::Machine<fsm::States<Rotate, DriveToZone, Stopped>, fsm::Transitions<
+			fsm::Transition<Rotate, RoboState::timerExpired, DriveToZone>,
+			fsm::Transition<DriveToZone, RoboState::timerExpired, Stopped>,
+			fsm::Transition<Stopped, RoboState::no_update, Stopped>>> ContainerMode;
+
+		typedef fsm::Machine<fsm::States<PushContainer, GettingTote, ForkGrab, PushAndRaise, StrafeLeft, RotateDrive, Stopped>, fsm::Transitions<
+			fsm::Transition<PushContainer, RoboState::timerExpired, GettingTote>,
+			fsm::Transition<GettingTote, RoboState::timerExpired, ForkGrab>,
+			fsm::Transition<GettingTote, RoboState::eStop, Stopped>,
+			fsm::Transition<ForkGrab, RoboState::finish, StrafeLeft>,
+			fsm::Transition<ForkGrab, RoboState::nextTote, PushAndRaise>,
+			fsm::Transition<PushAndRaise, RoboState::timerExpired, GettingTote>,
+			fsm::Transition<StrafeLeft, RoboState::timerExpired, RotateDrive>,
+			fsm::Transition<RotateDrive, RoboState::timerExpired, Stopped>,
+			fsm::Transition<Stopped, RoboState::no_update, Stopped>>> Stack2Mode;
+
+		typedef fsm::Machine<fsm::States<PushContainer, GettingTote, ForkGrab, PushAndRaise, RotateDrive, BackAway, Stopped>, fsm::Transitions<
+			fsm::Transition<PushContainer, RoboState::timerExpired, GettingTote>,
+			fsm::Transition<GettingTote, RoboState::timerExpired, ForkGrab>,
+			fsm::Transition<ForkGrab, RoboState::nextTote, PushAndRaise>,
+			fsm::Transition<PushAndRaise, RoboState::timerExpired, GettingTote>,
+			fsm::Transition<ForkGrab, RoboState::finish, RotateDrive>,
+			fsm::Transition<RotateDrive, RoboState::timerExpired, BackAway>,
+			fsm::Transition<BackAway, RoboState::timerExpired, Stopped>,
+			fsm::Transition<GettingTote, RoboState::eStop, Stopped>,
+			fsm::Transition<Stopped, RoboState::no_update, Stopped>>> Stack3Mode;
+	}
+
+	//Every autonomous state, held by value so that HALBot is the only allocation. HALBot::init resets them in place.
+	struct AutonStates
+	{
+		void reset();
+
+		GettingTote gettingTote;
+		DriveToZone driveToZone;
+		ForkGrab forkGrab;
+		Rotate rotate;
+		Rotate rotate2;
+		Stopped stopped;
+		PushContainer pushContainer;
+		BackAway backAway;
+		RotateDrive rotateDrive;
+		StrafeLeft strafeLeft;
+		RaiseLift raiseLift;
+		auton::PushAndRaise pushAndRaise;
+	};
+
 	//Needs to appear in https://en.wikipedia.org/wiki/Kludge#Computer_science
 	class HALBot
 	{
 	public:
-		HALBot();
+		HALBot(); //Constructed once in RobotInit; init() resets it for every autonomous run
 		~HALBot();
 		void setMode(AutonMode newMode); //Called during AutonomousInit. Determines what autonomous mode to run
-		void init(MecanumDrive* drivebase, MotorGrouping* intake, PneumaticGrouping* lift); //Sets hardware, intializes stuff, and prepares the transition tables. Assumes that the setMode thing has been used already.
-		void update(); //Basically just a cheap call to FiniteStateMachine::update. 
+		void init(MecanumDrive* drivebase, MecanumOdometry* odometry, MotorGrouping* intake, PneumaticGrouping* lift); //Resets every state, sets hardware, and starts the machine of the current mode. Does not allocate.
+		void update(); //Updates the machine of the current mode.
+		void reportProfile(); //Logs the timeline and per-state timing of the last autonomous run, once
 	private:
-		FiniteStateMachine* fsm;
-		FSMTransition transitionTable[15]; //The transition table used for transitioning. Changes based on the setMode thingy.
+		void generateProfiles(); //Samples the motion profile of every calibrated drive state
+		AutonMode mode;
+		auton::StopMode stopMode; //Also used for AUTON_MODE_BOTH
+		auton::DriveMode driveMode;
+		auton::ToteMode toteMode;
+		auton::ContainerMode containerMode;
+		auton::Stack2Mode stack2Mode;
+		auton::Stack3Mode stack3Mode;
 		Log* sysLog;
-
-		//State objects. These should be self-explanatory.
-		GettingTote* gettingTote;
-		DriveToZone* driveToZone;
-		ForkGrab* forkGrab;
-		Rotate* rotate;
-		Rotate* rotate2;
-		Stopped* stopped;
-		PushContainer* pushContainer;
-		BackAway* backAway;
-		RotateDrive* rotateDrive;
-		StrafeLeft* strafeLeft;
+		AutonStates states;
+		DriveProfiles profiles;
+		FSMProfiler profiler;
 	};
 }
@@ -0,0 +1,77 @@
+#include <cmath>
+#include "MotionProfile.h"
+
+namespace dreadbot
+{
+	MotionProfile::MotionProfile()
+	{
+		clear();
+	}
+	bool MotionProfile::generate(float distance, float maxVelocity, float maxAcceleration)
+	{
+		clear();
+		if (distance <= 0 || maxVelocity <= 0 || maxAcceleration <= 0)
+			return true; //Nothing to drive
+
+		//Accelerate at the limit, cruise at maxVelocity, and decelerate at the limit. Short moves never reach
+		//maxVelocity and become a triangle.
+		float accelTime = maxVelocity / maxAcceleration;
+		float accelDistance = 0.5f * maxAcceleration * accelTime * accelTime;
+		float peakVelocity = maxVelocity;
+		if (2 * accelDistance > distance)
+		{
+			accelTime = sqrt(distance / maxAcceleration);
+			accelDistance = distance / 2;
+			peakVelocity = maxAcceleration * accelTime;
+		}
+		float cruiseTime = (distance - 2 * accelDistance) / peakVelocity;
+		float time = 2 * accelTime + cruiseTime;
+
+		int count = (int)ceil(time / PROFILE_PERIOD) + 1;
+		if (count > PROFILE_MAX_SAMPLES)
+			return false;
+
+		for (int i = 0; i < count; i++)
+		{
+			float t = fmin(i * PROFILE_PERIOD, time);
+			if (t < accelTime)
+				positions[i] = 0.5f * maxAcceleration * t * t;
+			else if (t < accelTime + cruiseTime)
+				positions[i] = accelDistance + peakVelocity * (t - accelTime);
+			else
+				positions[i] = distance - 0.5f * maxAcceleration * (time - t) * (time - t);
+		}
+		positions[count - 1] = distance;
+		sampleCount = count;
+		totalTime = time;
+		return true;
+	}
+	void MotionProfile::clear()
+	{
+		sampleCount = 0;
+		totalTime = 0;
+	}
+	float MotionProfile::position(float time) const
+	{
+		if (sampleCount == 0)
+			return 0;
+		if (time <= 0)
+			return positions[0];
+
+		//Interpolate between the samples on either side
+		float index = time / PROFILE_PERIOD;
+		int before = (int)index;
+		if (before >= sampleCount - 1)
+			return positions[sampleCount - 1];
+		float fraction = index - before;
+		return positions[before] + (positions[before + 1] - positions[before]) * fraction;
+	}
+	float MotionProfile::duration() const
+	{
+		return totalTime;
+	}
+	bool MotionProfile::isEmpty() const
+	{
+		return sampleCount == 0;
+	}
+}
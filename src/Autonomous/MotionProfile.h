@@ -0,0 +1,38 @@
+#pragma once
+
+#define PROFILE_PERIOD 0.02f //Seconds between samples; one per periodic update
+#define PROFILE_MAX_SAMPLES 256 //Longest profile is about 5 seconds
+
+namespace dreadbot
+{
+	//A time-optimal trapezoidal velocity profile for driving a fixed distance, sampled into a flat array of positions.
+	//generate() does all the math up front (HALBot::init, when autonomous starts); position() is an array lookup.
+	class MotionProfile
+	{
+	public:
+		MotionProfile();
+		bool generate(float distance, float maxVelocity, float maxAcceleration); //False if it would not fit in PROFILE_MAX_SAMPLES; the profile is then empty
+		void clear();
+		float position(float time) const; //Distance along the profile after time seconds, holding at the end
+		float duration() const;
+		bool isEmpty() const;
+	private:
+		float positions[PROFILE_MAX_SAMPLES];
+		int sampleCount;
+		float totalTime;
+	};
+
+	//The profile of every calibrated drive state (see the distances in RoboState.h). Profiles whose distance is 0 are
+	//empty, and those states drive on their timers instead.
+	struct DriveProfiles
+	{
+		MotionProfile driveToZone;
+		MotionProfile driveToZoneNoTote;
+		MotionProfile strafeToZone;
+		MotionProfile rotate;
+		MotionProfile strafeLeft;
+		MotionProfile push;
+		MotionProfile pushScaled[4]; //By tote count, for PushContainer::enableScaling
+		MotionProfile backAway;
+	};
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <tuple>
+#include <type_traits>
+#include "RoboState.h"
+
+namespace dreadbot
+{
+	namespace fsm
+	{
+		//Orthogonal regions: one state that runs several states at once, such as the drivetrain pushing a container while
+		//the lift finishes raising. All regions are entered together and each is updated every tick until it returns
+		//something other than no_update. The Parallel state is a join barrier: it returns no_update until every region
+		//has finished, then returns the result of the first region. Regions must not share hardware.
+		template <typename... Regions> class Parallel : public RoboState
+		{
+		public:
+			Parallel() : finished(0), result(RoboState::no_update) {}
+			void init(Regions*... instances)
+			{
+				regions = std::make_tuple(instances...);
+			}
+			virtual void reset() //The regions are reset on their own
+			{
+				RoboState::reset();
+				finished = 0;
+				result = RoboState::no_update;
+			}
+			virtual void enter()
+			{
+				finished = 0;
+				result = RoboState::no_update;
+				enterRegion<0>(std::true_type());
+			}
+			virtual int update()
+			{
+				updateRegion<0>(std::true_type());
+				return finished == allFinished ? result : RoboState::no_update;
+			}
+		private:
+			static const unsigned allFinished = (1u << sizeof...(Regions)) - 1;
+
+			template <int I> void enterRegion(std::true_type)
+			{
+				typedef typename std::tuple_element<I, std::tuple<Regions...>>::type Region;
+				std::get<I>(regions)->Region::enter();
+				enterRegion<I + 1>(std::integral_constant<bool, (I + 1 < sizeof...(Regions))>());
+			}
+			template <int I> void enterRegion(std::false_type) {}
+
+			template <int I> void updateRegion(std::true_type)
+			{
+				typedef typename std::tuple_element<I, std::tuple<Regions...>>::type Region;
+				if (!(finished & (1u << I)))
+				{
+					int regionResult = std::get<I>(regions)->Region::update();
+					if (regionResult != RoboState::no_update)
+					{
+						finished |= 1u << I;
+						if (I == 0)
+							result = regionResult;
+					}
+				}
+				updateRegion<I + 1>(std::integral_constant<bool, (I + 1 < sizeof...(Regions))>());
+			}
+			template <int I> void updateRegion(std::false_type) {}
+
+			std::tuple<Regions*...> regions;
+			unsigned finished; //Bit per region
+			int result; //Result of the first region
+		};
+	}
+}
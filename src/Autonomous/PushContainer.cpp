@@ -4,6 +4,11 @@ namespace dreadbot
 {
 	PushContainer::PushContainer()
 	{
+		reset();
+	}
+	void PushContainer::reset()
+	{
+		DriveToZone::reset();
 		enableScaling = false;
 		pushConstant = 1; //OK, since
 	}
@@ -17,24 +22,31 @@ namespace dreadbot
 		float pushTime = PUSH_TIME;
 		if (enableScaling) //I refuse comment on this bit. Let's just say that it makes the robot push less.
 			pushTime += ((float)RoboState::toteCount - 1.f) / 3.f; //Scaling for three-tote autonomous, since the second container is farther away than the first
+		float pushDistance = PUSH_DISTANCE * pushTime / PUSH_TIME;
+		const MotionProfile& profile = enableScaling ? profiles->pushScaled[std::min(std::max(RoboState::toteCount, 0), 3)] : profiles->push;
+		bool profiled = !profile.isEmpty();
 		intakeArms->Set(1); //Intake arms in
 		if (!timerActive)
 		{
 			driveTimer.Reset();
 			driveTimer.Start();
+			startDistance();
 			timerActive = true;
 		}
 
-		if (driveTimer.Get() >= pushTime)
+		if (profiled ? followProfile(profile, driveTimer, axisForward, -1) : driveFinished(driveTimer, pushTime, axisForward, -1, pushDistance))
 		{
+			logDistance("PushContainer");
 			timerActive = false;
 			drivebase->Drive_v(0, 0, 0);
 			return RoboState::timerExpired;
 		}
-		if (RoboState::toteCount >= 2) {
-			drivebase->Drive_v(DRIVE_STRAFE_CORRECTION, -PUSH_SPEED, DRIVE_ROTATE_CORRECTION); //Straight forward
-		} else {
-			drivebase->Drive_v(0.0f, -PUSH_SPEED, 0.0f);
+		if (!profiled) {
+			if (RoboState::toteCount >= 2) {
+				drivebase->Drive_v(DRIVE_STRAFE_CORRECTION, -PUSH_SPEED, DRIVE_ROTATE_CORRECTION); //Straight forward
+			} else {
+				drivebase->Drive_v(0.0f, -PUSH_SPEED, 0.0f);
+			}
 		}
 		if (pusher1 != nullptr)
 			pusher1->Set(INTAKE_PUSH_SPEED); //Push the container?
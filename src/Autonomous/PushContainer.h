@@ -8,6 +8,7 @@ namespace dreadbot
 	{
 	public:
 		PushContainer();
+		virtual void reset();
 		virtual void enter();
 		virtual int update();
 		int pushConstant;
@@ -0,0 +1,27 @@
+#include "RaiseLift.h"
+
+namespace dreadbot
+{
+	RaiseLift::RaiseLift()
+	{
+		reset();
+	}
+	void RaiseLift::reset()
+	{
+		Routine::reset();
+		engageTime = 0.3f;
+	}
+	void RaiseLift::enter()
+	{
+		sysLog->log("State: RaiseLift");
+		restart();
+	}
+	int RaiseLift::update()
+	{
+		ROUTINE_BEGIN();
+		lift->Set(1);
+		ROUTINE_AWAIT_TIME(engageTime);
+		ROUTINE_RETURN(RoboState::finish);
+		ROUTINE_END();
+	}
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "Routine.h"
+
+namespace dreadbot
+{
+	//Raises the lift and finishes once the totes have had time to engage. Meant to run as a lift region next to a drive state.
+	class RaiseLift : public Routine
+	{
+	public:
+		RaiseLift();
+		virtual void reset();
+		virtual void enter();
+		virtual int update();
+		float engageTime;
+	};
+}
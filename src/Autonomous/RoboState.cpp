@@ -4,6 +4,8 @@ namespace dreadbot
 {
 	//These are needed for static members... ugh. 1.5 hours.
 	MecanumDrive* RoboState::drivebase = nullptr;
+	MecanumOdometry* RoboState::odometry = nullptr;
+	const DriveProfiles* RoboState::profiles = nullptr;
 	MotorGrouping* RoboState::intake = nullptr;
 	PneumaticGrouping* RoboState::lift = nullptr;
 	PneumaticGrouping* RoboState::liftArms = nullptr;
@@ -14,4 +16,70 @@ namespace dreadbot
 
 	int RoboState::toteCount = 0;
 	int RoboState::neededTCount = 0;
+
+	RoboState::RoboState()
+	{
+		reset();
+	}
+	void RoboState::reset()
+	{
+		step = 0;
+		stepDuration = 0;
+		stepTimer.Stop();
+		stepTimer.Reset();
+	}
+	void RoboState::startStep(int newStep, float duration)
+	{
+		step = newStep;
+		stepDuration = duration;
+		stepTimer.Reset();
+		stepTimer.Start();
+	}
+	bool RoboState::stepPending()
+	{
+		return step != 0 && stepTimer.Get() < stepDuration;
+	}
+	void RoboState::startDistance()
+	{
+		if (drivebase != nullptr)
+			drivebase->ResetEncoders();
+	}
+	bool RoboState::driveFinished(Timer& timer, float time, driveAxis axis, float direction, float distance)
+	{
+		if (distance <= 0 || drivebase == nullptr)
+			return timer.Get() >= time; //Not calibrated
+
+		double moved[3];
+		drivebase->GetDisplacement(moved[axisStrafe], moved[axisForward], moved[axisRotation]);
+		return moved[axis] * direction >= distance || timer.Get() >= time * DRIVE_TIMEOUT_FACTOR;
+	}
+	bool RoboState::followProfile(const MotionProfile& profile, Timer& timer, driveAxis axis, float direction)
+	{
+		float time = timer.Get();
+		double target[3] = {0, 0, 0}; //The other axes are held at 0, which also corrects drift
+		target[axis] = profile.position(time) * direction;
+		drivebase->Drive_p(target[axisStrafe], target[axisForward], target[axisRotation]);
+		if (time < profile.duration())
+			return false;
+
+		double moved[3];
+		drivebase->GetDisplacement(moved[axisStrafe], moved[axisForward], moved[axisRotation]);
+		return fabs(moved[axis] - target[axis]) <= PROFILE_TOLERANCE || time >= profile.duration() + PROFILE_SETTLE_TIME;
+	}
+	void RoboState::logDistance(const char* state)
+	{
+		if (drivebase == nullptr)
+			return;
+
+		double x, y, rotation;
+		drivebase->GetDisplacement(x, y, rotation);
+		stringstream message;
+		message << state << " moved x " << x << ", y " << y << ", rotation " << rotation << " ticks";
+		if (odometry != nullptr)
+		{
+			Pose pose = odometry->GetPose();
+			message << "; pose x " << pose.x << ", y " << pose.y << ", heading " << pose.heading;
+		}
+		sysLog->log(message.str());
+	}
 }
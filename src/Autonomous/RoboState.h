@@ -3,8 +3,10 @@
 #include "WPILib.h"
 #include "Timer.h"
 #include "../MecanumDrive.h"
+#include "../MecanumOdometry.h"
 #include "../XMLInput.h"
 #include "FSM.h"
+#include "MotionProfile.h"
 #include "../DreadbotDIO.h"
 #include "../../lib/Logger.h"
 using namespace Hydra;
@@ -37,6 +39,25 @@ using namespace Hydra;
 #define STACK_CORRECTION_SPEED 	0.85f 	// How quickly the robot jerks backward
 #define LIFT_ENGAGEMENT_DELAY 	0.5f 	// How long the robot waits after starting to lower the lift while collecting the third tote before reversing.
 
+// Encoder distances, in drive encoder ticks (see MecanumDrive::GetDisplacement). When a distance is set, the state ends
+// once the robot has moved that far and its time above becomes a cutoff of DRIVE_TIMEOUT_FACTOR times that time.
+// 0 means not calibrated: the state ends on its time as before. Each drive state logs how far it moved, for calibration.
+#define DRIVE_TO_ZONE_DISTANCE	0.0f	// Forward, matches DRIVE_TO_ZONE_TIME
+#define NO_TOTE_EXTRA_DISTANCE	0.0f	// Added to DRIVE_TO_ZONE_DISTANCE when no tote was collected (the 0.4 s extra)
+#define STRAFE_TO_ZONE_DISTANCE	0.0f	// Strafe, matches STRAFE_TO_ZONE_TIME
+#define ROTATE_DISTANCE			0.0f	// Rotation, matches ROTATE_TIME
+#define STRAFE_LEFT_DISTANCE	0.0f	// Strafe in StrafeLeft
+#define PUSH_DISTANCE			0.0f	// Forward, matches PUSH_TIME (scaled the same way in 3TA)
+#define BACK_AWAY_DISTANCE		0.0f	// Backward, matches BACK_AWAY_TIME
+#define DRIVE_TIMEOUT_FACTOR	1.5f
+
+// Motion profiles, used for every state whose distance above is set. The wheels follow a trapezoidal profile in Talon
+// position mode (MecanumDrive::Drive_p) instead of driving at a constant speed for a time.
+#define PROFILE_MAX_VELOCITY		450.0f	// Encoder ticks/second at the wheels; an unloaded CIM tops out at 600
+#define PROFILE_MAX_ACCELERATION	900.0f	// Encoder ticks/second^2
+#define PROFILE_TOLERANCE			10.0f	// How close to the end of the profile counts as arrived, in ticks
+#define PROFILE_SETTLE_TIME			0.5f	// How long past the end of the profile to wait for the tolerance
+
 
 namespace dreadbot
 {
@@ -45,12 +66,36 @@ namespace dreadbot
 		public:
 			enum rVals {no_update, finish, timerExpired, nextTote, eStop};
 
+			RoboState();
+			virtual void reset(); //Back to the state as constructed: clears every flag and stops every timer. Overrides call the base version.
 			virtual void enter() = 0;
 			virtual int update() = 0;
 			virtual ~RoboState() {}
 		protected:
+			//Timed sub-steps, used instead of Wait() so that update() never blocks the robot loop. startStep() records
+			//which continuation to run once the duration has passed; update() returns no_update while stepPending().
+			void startStep(int newStep, float duration);
+			bool stepPending();
+
+			//Encoder termination for drive states. startDistance() zeroes the odometry; driveFinished() is true once the
+			//robot has moved distance ticks along axis in the commanded direction (+1 or -1), or after time seconds (scaled
+			//by DRIVE_TIMEOUT_FACTOR) on timer. Movement the wrong way does not count.
+			enum driveAxis {axisStrafe, axisForward, axisRotation};
+			void startDistance();
+			bool driveFinished(Timer& timer, float time, driveAxis axis, float direction, float distance);
+			void logDistance(const char* state);
+
+			//Drives the profile along axis (direction gives the sign) from the last startDistance(), one sample per call.
+			//True once the profile has ended and the robot is within PROFILE_TOLERANCE, or PROFILE_SETTLE_TIME after the end.
+			bool followProfile(const MotionProfile& profile, Timer& timer, driveAxis axis, float direction);
+			int step; //0 when no sub-step is running. Cleared by enter().
+			Timer stepTimer;
+			float stepDuration;
+
 			//Hardware for access for all states
 			static MecanumDrive* drivebase;
+			static MecanumOdometry* odometry; //Field pose, safe to read at any time
+			static const DriveProfiles* profiles; //Generated by HALBot::init
 			static MotorGrouping* intake;
 			static PneumaticGrouping* lift;
 			static PneumaticGrouping* liftArms;
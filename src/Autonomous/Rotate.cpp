@@ -4,27 +4,34 @@ namespace dreadbot
 {
 	Rotate::Rotate()
 	{
-		timerActive = false;
+		reset();
+	}
+	void Rotate::reset()
+	{
+		DriveToZone::reset();
 		rotateConstant = 1; //Changes the direction that the robot turns.
 	}
 	void Rotate::enter()
 	{
 		driveTimer.Reset();
 		driveTimer.Start();
+		startDistance();
 		timerActive = true;
 		sysLog->log("State: Rotate");
 	}
 	int Rotate::update()
 	{
-		if (driveTimer.Get() >= ROTATE_TIME)
+		bool profiled = !profiles->rotate.isEmpty();
+		if (profiled ? followProfile(profiles->rotate, driveTimer, axisRotation, rotateConstant) : driveFinished(driveTimer, ROTATE_TIME, axisRotation, rotateConstant, ROTATE_DISTANCE))
 		{ //Rotated far enough; break
+			logDistance("Rotate");
 			timerActive = false;
 			drivebase->Drive_v(0, 0, 0);
 			if (RoboState::toteCount == 3)
 				lift->Set(-1); //Lower lift
 			return RoboState::timerExpired;
 		}
-		if (drivebase != nullptr)
+		if (drivebase != nullptr && !profiled)
 			drivebase->Drive_v(0, 0, 0.5 * rotateConstant);
 		return RoboState::no_update;
 	}
@@ -8,6 +8,7 @@ namespace dreadbot
 	{
 	public:
 		Rotate();
+		virtual void reset();
 		virtual void enter();
 		virtual int update();
 
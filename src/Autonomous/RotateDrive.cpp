@@ -4,18 +4,28 @@ namespace dreadbot
 {
 	RotateDrive::RotateDrive()
 	{
-		timerActive = false;
-		rotateConstant = 1;
+		//Rotate::reset() covers every field
 	}
 	void RotateDrive::enter()
 	{
 		sysLog->log("State: RotateDrive");
 		drivebase->GoFast(); //Gotta go faaaaaaaasssst.
 		driveTimer.Start();
+		step = noStep;
 		//liftArms->Set(0);
 	}
 	int RotateDrive::update()
 	{
+		//Driving straight after the rotation
+		if (step != noStep)
+		{
+			if (stepPending())
+				return RoboState::no_update;
+
+			step = noStep;
+			return RoboState::timerExpired;
+		}
+
 		if (driveTimer.Get() >= (ROTATE_TIME - 0.5f))
 		{ //Rotated far enough; break
 			timerActive = false;
@@ -26,9 +36,8 @@ namespace dreadbot
 			if (RoboState::toteCount == 3)
 				lift->Set(-1); //Lower lift
 
-			Wait(ROTATE_DRIVE_STRAIGHT);
-
-			return RoboState::timerExpired;
+			startStep(straightStep, ROTATE_DRIVE_STRAIGHT);
+			return RoboState::no_update;
 		}
 		if (drivebase != nullptr)
 			drivebase->Drive_v(0, RD_DRIVE_SPEED, RD_ROTATE_SPEED);
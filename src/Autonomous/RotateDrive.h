@@ -10,5 +10,7 @@ namespace dreadbot
 		RotateDrive();
 		int update();
 		void enter();
+	protected:
+		enum steps {noStep, straightStep};
 	};
 }
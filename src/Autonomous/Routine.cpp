@@ -0,0 +1,26 @@
+#include "Routine.h"
+
+namespace dreadbot
+{
+	Routine::Routine()
+	{
+		reset();
+	}
+	void Routine::reset()
+	{
+		RoboState::reset();
+		restart();
+		routineTimer.Stop();
+		routineTimer.Reset();
+	}
+	void Routine::restart()
+	{
+		resumePoint = 0;
+		routineResult = RoboState::no_update;
+	}
+	void Routine::startRoutineTimer()
+	{
+		routineTimer.Reset();
+		routineTimer.Start();
+	}
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "RoboState.h"
+
+//Stackless coroutines for autonomous states. A routine is written as one linear update() between ROUTINE_BEGIN and
+//ROUTINE_END; each await returns no_update and the next update() call resumes right after it. Anything that has to
+//survive an await must be a member, since locals do not persist between ticks. Routines never block and never
+//allocate: their frame is the state object itself. Only one await may appear per source line.
+//The resume labels sit inside if (false) blocks so the first pass reaches them without falling through a case label.
+//
+//	int BackAway::update()
+//	{
+//		ROUTINE_BEGIN();
+//		ROUTINE_AWAIT_UNTIL(isLiftDown());
+//		ROUTINE_AWAIT_TIME(0.13);
+//		ROUTINE_RETURN(RoboState::timerExpired);
+//		ROUTINE_END();
+//	}
+
+#define ROUTINE_BEGIN() switch (resumePoint) { case 0:
+
+//Suspends until the next tick
+#define ROUTINE_YIELD() do { resumePoint = __LINE__; return RoboState::no_update; case __LINE__:; } while (0)
+
+//Suspends until cond is true; cond is checked immediately and then once per tick
+#define ROUTINE_AWAIT_UNTIL(cond) do { resumePoint = __LINE__; if (false) { case __LINE__:; } if (!(cond)) return RoboState::no_update; } while (0)
+
+//Suspends for the given number of seconds
+#define ROUTINE_AWAIT_TIME(seconds) do { startRoutineTimer(); ROUTINE_AWAIT_UNTIL(routineTimer.Get() >= (seconds)); } while (0)
+
+//Runs body once per tick while cond is true, e.g. to keep feeding drive commands
+#define ROUTINE_WHILE(cond, body) do { resumePoint = __LINE__; if (false) { case __LINE__:; } if (cond) { body; return RoboState::no_update; } } while (0)
+
+//Runs body once per tick for the given number of seconds
+#define ROUTINE_DURING(seconds, body) do { startRoutineTimer(); ROUTINE_WHILE(routineTimer.Get() < (seconds), body); } while (0)
+
+//Finishes the routine with the given result; later updates keep returning it
+#define ROUTINE_RETURN(result) do { resumePoint = -1; routineResult = (result); return routineResult; } while (0)
+
+#define ROUTINE_END() default: break; } return routineResult
+
+namespace dreadbot
+{
+	class Routine : public RoboState
+	{
+	public:
+		Routine();
+		virtual void reset();
+	protected:
+		void restart(); //Call from enter() so that every entry runs the routine from the top
+		void startRoutineTimer();
+
+		int resumePoint; //Source line of the await to resume at; 0 before the first update, -1 when finished
+		int routineResult;
+		Timer routineTimer;
+	};
+}
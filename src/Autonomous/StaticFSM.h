@@ -0,0 +1,220 @@
+#pragma once
+
+#include <tuple>
+#include <type_traits>
+#include "FSMProfiler.h"
+
+//Compile-time state machines. A machine is a list of states and a list of transitions, both as types; the table is
+//checked with static_assert when the machine type is instantiated, and update() calls the concrete state's update()
+//directly (no virtual dispatch). The first state in the list is the starting state.
+//
+//	typedef fsm::State<Rotate, 1> Rotate2; //Second Rotate instance
+//	typedef fsm::Machine<fsm::States<GettingTote, Rotate2, Stopped>, fsm::Transitions<
+//		fsm::Transition<GettingTote, RoboState::timerExpired, Rotate2>, ...>> ToteMode;
+
+namespace dreadbot
+{
+	namespace fsm
+	{
+		//Distinguishes several states of the same type. A plain state type T is the same as State<T, 0>.
+		template <typename T, int Instance = 0> struct State
+		{
+			typedef T type;
+		};
+
+		template <typename From, int Input, typename To> struct Transition
+		{
+			typedef From from;
+			typedef To to;
+			static constexpr int input = Input;
+		};
+
+		template <typename... S> struct States {};
+		template <typename... T> struct Transitions {};
+
+		namespace detail
+		{
+			template <typename S> struct StateType { typedef S type; };
+			template <typename T, int Instance> struct StateType<State<T, Instance>> { typedef T type; };
+
+			template <typename S> struct Normalize { typedef State<S, 0> type; };
+			template <typename T, int Instance> struct Normalize<State<T, Instance>> { typedef State<T, Instance> type; };
+
+			//Position of S in the list, -1 if absent
+			template <typename S, typename... List> struct IndexOf;
+			template <typename S> struct IndexOf<S>
+			{
+				static constexpr int value = -1;
+			};
+			template <typename S, typename First, typename... Rest> struct IndexOf<S, First, Rest...>
+			{
+				static constexpr int rest = IndexOf<S, Rest...>::value;
+				static constexpr int value = std::is_same<typename Normalize<S>::type, typename Normalize<First>::type>::value ? 0 : (rest < 0 ? -1 : rest + 1);
+			};
+
+			template <int... I> struct Indices {};
+			template <int N, int... I> struct MakeIndices : MakeIndices<N - 1, N - 1, I...> {};
+			template <int... I> struct MakeIndices<0, I...> { typedef Indices<I...> type; };
+
+			constexpr int maxValue(const int* values, int count, int best = -1)
+			{
+				return count == 0 ? best : maxValue(values + 1, count - 1, *values > best ? *values : best);
+			}
+			constexpr bool allValid(const int* values, int count)
+			{
+				return count == 0 || (*values >= 0 && allValid(values + 1, count - 1));
+			}
+			constexpr int lookup(const int* from, const int* input, const int* to, int count, int state, int in)
+			{
+				return count == 0 ? -1 : (*from == state && *input == in) ? *to : lookup(from + 1, input + 1, to + 1, count - 1, state, in);
+			}
+			constexpr bool hasOutgoing(const int* from, int count, int state)
+			{
+				return count != 0 && (*from == state || hasOutgoing(from + 1, count - 1, state));
+			}
+			constexpr bool allHaveOutgoing(const int* from, int count, int stateCount)
+			{
+				return stateCount == 0 || (hasOutgoing(from, count, stateCount - 1) && allHaveOutgoing(from, count, stateCount - 1));
+			}
+			constexpr bool onlySelfLoops(const int* from, const int* to, int count, int state)
+			{
+				return count == 0 || ((*from != state || *to == state) && onlySelfLoops(from + 1, to + 1, count - 1, state));
+			}
+			constexpr bool anyTerminal(const int* from, const int* to, int count, int stateCount)
+			{
+				return stateCount != 0 && ((hasOutgoing(from, count, stateCount - 1) && onlySelfLoops(from, to, count, stateCount - 1)) || anyTerminal(from, to, count, stateCount - 1));
+			}
+			constexpr bool unique(const int* from, const int* input, int count)
+			{
+				return count == 0 || (lookup(from + 1, input + 1, from + 1, count - 1, *from, *input) < 0 && unique(from + 1, input + 1, count - 1));
+			}
+			//One step of reachability: adds the target of every transition whose source is in mask
+			constexpr unsigned reachStep(const int* from, const int* to, int count, unsigned mask)
+			{
+				return count == 0 ? mask : reachStep(from + 1, to + 1, count - 1, (mask >> *from) & 1u ? mask | (1u << *to) : mask);
+			}
+			constexpr unsigned reachable(const int* from, const int* to, int count, unsigned mask, int steps)
+			{
+				return steps == 0 ? mask : reachable(from, to, count, reachStep(from, to, count, mask), steps - 1);
+			}
+		}
+
+		//The compile-time part of a machine: state IDs, the transition arrays, and the dense next-state table
+		template <typename StateList, typename TransitionList> struct Table;
+		template <typename... S, typename... T> struct Table<States<S...>, Transitions<T...>>
+		{
+			static constexpr int stateCount = sizeof...(S);
+			static constexpr int transitionCount = sizeof...(T);
+
+			static constexpr int from[] = {detail::IndexOf<typename T::from, S...>::value...};
+			static constexpr int input[] = {T::input...};
+			static constexpr int to[] = {detail::IndexOf<typename T::to, S...>::value...};
+			static constexpr int inputCount = detail::maxValue(input, transitionCount) + 1;
+
+			static_assert(stateCount > 0 && stateCount <= 32, "A machine needs between 1 and 32 states");
+			static_assert(detail::allValid(from, transitionCount) && detail::allValid(to, transitionCount), "A transition uses a state that is not in the state list");
+			static_assert(detail::allValid(input, transitionCount), "Transition inputs must not be negative");
+			static_assert(detail::unique(from, input, transitionCount), "Two transitions leave the same state on the same input");
+			static_assert(detail::allHaveOutgoing(from, transitionCount, stateCount), "A state has no transitions; terminal states need a transition to themselves");
+			static_assert(detail::anyTerminal(from, to, transitionCount, stateCount), "The machine has no terminal state");
+			static_assert(detail::reachable(from, to, transitionCount, 1u, stateCount) == (stateCount == 32 ? ~0u : (1u << stateCount) - 1), "A state is unreachable from the starting state");
+
+			static constexpr int next(int state, int in)
+			{
+				return detail::lookup(from, input, to, transitionCount, state, in);
+			}
+		};
+
+		template <typename... S, typename... T> constexpr int Table<States<S...>, Transitions<T...>>::from[];
+		template <typename... S, typename... T> constexpr int Table<States<S...>, Transitions<T...>>::input[];
+		template <typename... S, typename... T> constexpr int Table<States<S...>, Transitions<T...>>::to[];
+
+		template <typename TableType, typename Indices> struct NextTable;
+		template <typename TableType, int... I> struct NextTable<TableType, detail::Indices<I...>>
+		{
+			static constexpr int values[] = {TableType::next(I / TableType::inputCount, I % TableType::inputCount)...};
+		};
+
+		template <typename TableType, int... I> constexpr int NextTable<TableType, detail::Indices<I...>>::values[];
+
+		template <typename StateList, typename TransitionList> class Machine;
+		template <typename... S, typename... T> class Machine<States<S...>, Transitions<T...>>
+		{
+		public:
+			typedef Table<States<S...>, Transitions<T...>> table;
+
+			Machine() : current(-1), profiler(nullptr) {}
+
+			//Takes the state objects in the order of the state list, and the names the profiler reports them by (in the same
+			//order, and outliving the run), and enters the starting state
+			void init(const char* const (&names)[sizeof...(S)], typename detail::StateType<S>::type*... instances)
+			{
+				states = std::make_tuple(instances...);
+				current = 0;
+				if (profiler != nullptr)
+					profiler->begin(names, table::stateCount, 0);
+				enterState<0>(0, std::true_type());
+			}
+			void setProfiler(FSMProfiler* newProfiler) //Set before init(); nullptr disables profiling
+			{
+				profiler = newProfiler;
+			}
+			void update()
+			{
+				updateState<0>(std::integral_constant<bool, (0 < table::stateCount)>());
+			}
+			int getStateID() const
+			{
+				return current;
+			}
+		private:
+			typedef NextTable<table, typename detail::MakeIndices<table::stateCount * table::inputCount>::type> next;
+
+			template <int I> void updateState(std::true_type)
+			{
+				if (current != I)
+				{
+					updateState<I + 1>(std::integral_constant<bool, (I + 1 < table::stateCount)>());
+					return;
+				}
+
+				typedef typename std::tuple_element<I, std::tuple<typename detail::StateType<S>::type...>>::type StateType;
+				double start = profiler != nullptr ? FSMProfiler::now() : 0;
+				int in = std::get<I>(states)->StateType::update();
+				if (profiler != nullptr)
+					profiler->recordUpdate(I, FSMProfiler::now() - start);
+				if (in < 0 || in >= table::inputCount)
+					return;
+
+				int target = next::values[I * table::inputCount + in];
+				if (target < 0)
+					return;
+				if (target != I)
+				{
+					if (profiler != nullptr)
+						profiler->recordTransition(I, in, target);
+					enterState<0>(target, std::true_type());
+				}
+				current = target;
+			}
+			template <int I> void updateState(std::false_type) {}
+
+			template <int I> void enterState(int id, std::true_type)
+			{
+				if (id != I)
+				{
+					enterState<I + 1>(id, std::integral_constant<bool, (I + 1 < table::stateCount)>());
+					return;
+				}
+
+				typedef typename std::tuple_element<I, std::tuple<typename detail::StateType<S>::type...>>::type StateType;
+				std::get<I>(states)->StateType::enter();
+			}
+			template <int I> void enterState(int, std::false_type) {}
+
+			std::tuple<typename detail::StateType<S>::type*...> states;
+			int current;
+			FSMProfiler* profiler;
+		};
+	}
+}
@@ -4,20 +4,23 @@ namespace dreadbot
 {
 	StrafeLeft::StrafeLeft()
 	{
-		timerActive = false;
+		//DriveToZone::reset() covers every field
 	}
 	void StrafeLeft::enter()
 	{
 		sysLog->log("State: StrafeLeft");
 		driveTimer.Start();
+		startDistance();
 		timerActive = true;
 		drivebase->GoFast(); //Gotta go faaaaaaaasssst.
 		drivebase->Drive_v(-1, 0, 0); //Left
 	}
 	int StrafeLeft::update()
 	{
-		if (driveTimer.Get() >= 0.5f) 
+		bool profiled = !profiles->strafeLeft.isEmpty();
+		if (profiled ? followProfile(profiles->strafeLeft, driveTimer, axisStrafe, -1) : driveFinished(driveTimer, 0.5f, axisStrafe, -1, STRAFE_LEFT_DISTANCE))
 		{
+			logDistance("StrafeLeft");
 			driveTimer.Stop();
 			driveTimer.Reset();
 			timerActive = false;
@@ -1,18 +1,27 @@
 #pragma once
-#include <string>
-using std::string;
 
 /*
-* Contents of the original Bot_Config.xml file. Uses a neat multiline trick 
-* to hold the contents of a human/computer readable XML file that PugiXML 
-* can parse.
+* Contents of the original Bot_Config.xml file, as a raw string literal so
+* that it keeps its line breaks and the validator can report real line
+* numbers (CONFIG_FIRST_LINE is the line of this file where the XML starts).
+*
+* Everything outside of a <profile> element is the base config. Each profile
+* inherits the base config and only lists what is different: an element with a
+* name, position or dir attribute replaces the matching base element, an
+* element holding a value (<ID>2</ID>) replaces that value, and other elements
+* are merged into the base element with the same tag: their attributes are
+* set, and their children are merged the same way. The active
+* profile is picked by the practice bot jumper (see DreadbotDIO::isPracticeBot).
+*
+* Check changes off-robot with "make -C tools check" before deploying.
+*
+* This is a plain mutable char array rather than a std::string so that nothing
+* runs at static init and PugiXML can parse it in place without copying it.
+* That also means it can only be parsed once.
 */
 
-#define MULTILINE(...) #__VA_ARGS__
-
-string config = MULTILINE(
-
-<?xml version="1.0" encoding="UTF-8"?>
+const int CONFIG_FIRST_LINE = __LINE__ + 1;
+char config[] = R"xml(<?xml version="1.0" encoding="UTF-8"?>
 <!--SET CONTROLLER TO XMODE!-->
 <Dreadbot version="5.0">
 	<Drivebase type="Mecanum">
@@ -59,6 +68,10 @@ string config = MULTILINE(
 			<dsolenoid actionCount="2" forwardID="3" reverseID="4" invert="false"></dsolenoid>
 		</group>
 	</pneumaticgroups>
+	<profile name="competition">
+	</profile>
+	<profile name="practice">
+		<!--Practice robot overrides go here, e.g. a group with a different outputID.-->
+	</profile>
 </Dreadbot>
-
-);
+)xml";
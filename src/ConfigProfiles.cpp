@@ -0,0 +1,71 @@
+#include "ConfigProfiles.h"
+#include <string>
+using std::string;
+
+namespace dreadbot
+{
+	//Elements carrying one of these attributes are replaced wholesale by a profile instead of merged
+	static pugi::xml_attribute profileKey(pugi::xml_node node)
+	{
+		const char* keys[] = {"name", "position", "dir"};
+		for (int i = 0; i < 3; i++)
+		{
+			if (node.attribute(keys[i]))
+				return node.attribute(keys[i]);
+		}
+		return pugi::xml_attribute();
+	}
+	static bool hasElementChildren(pugi::xml_node node)
+	{
+		for (auto child = node.first_child(); child; child = child.next_sibling())
+		{
+			if (child.type() == pugi::node_element)
+				return true;
+		}
+		return false;
+	}
+
+	void resolveProfile(pugi::xml_node resolved, pugi::xml_node base, pugi::xml_node profile)
+	{
+		pugi::xml_node copy = resolved.append_copy(base);
+		while (copy.child("profile"))
+			copy.remove_child("profile");
+		mergeProfile(copy, profile);
+	}
+	void mergeProfile(pugi::xml_node base, pugi::xml_node overrides)
+	{
+		for (auto node = overrides.first_child(); node; node = node.next_sibling())
+		{
+			if (node.type() != pugi::node_element)
+				continue;
+
+			//Find the base element this override refers to
+			pugi::xml_attribute key = profileKey(node);
+			pugi::xml_node target = base.child(node.name());
+			while (target && key && string(profileKey(target).value()) != key.value())
+				target = target.next_sibling(node.name());
+
+			if (!target)
+				base.append_copy(node); //Nothing to override, so this is new
+			else if (!key && (hasElementChildren(node) || !node.first_child()))
+			{
+				//Plain container (motors, controller, motorgroups, ...) - merge attributes and children. An override with
+				//no children at all, like <controller controllerID="1"/>, only changes attributes.
+				for (auto attr = node.first_attribute(); attr; attr = attr.next_attribute())
+				{
+					if (target.attribute(attr.name()))
+						target.attribute(attr.name()).set_value(attr.value());
+					else
+						target.append_attribute(attr.name()) = attr.value();
+				}
+				mergeProfile(target, node);
+			}
+			else
+			{
+				//Keyed element, or a value such as <deadzone>0.1</deadzone> - replace it
+				base.insert_copy_after(node, target);
+				base.remove_child(target);
+			}
+		}
+	}
+}
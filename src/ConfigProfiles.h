@@ -0,0 +1,15 @@
+#pragma once
+#include "../lib/pugixml.hpp"
+
+/*
+ * Resolves the <profile> elements of the XML config against the base config
+ * (the rules are described in Config.h). Like ConfigValidator this only
+ * depends on PugiXML, so XMLInput and the off-robot checker in tools/ resolve
+ * profiles with the same code.
+ */
+
+namespace dreadbot
+{
+	void resolveProfile(pugi::xml_node resolved, pugi::xml_node base, pugi::xml_node profile); //!< Appends a copy of base, without its profiles, to resolved and applies profile to it
+	void mergeProfile(pugi::xml_node base, pugi::xml_node overrides); //!< Applies a profile's overrides onto a copy of the base config
+}
@@ -0,0 +1,241 @@
+#include "ConfigValidator.h"
+#include <cstdlib>
+
+namespace dreadbot
+{
+	static bool isInt(const char* text)
+	{
+		char* end;
+		strtol(text, &end, 10);
+		return *text != '\0' && *end == '\0';
+	}
+	static bool isFloat(const char* text)
+	{
+		char* end;
+		strtod(text, &end);
+		return *text != '\0' && *end == '\0';
+	}
+	static bool isBool(const char* text)
+	{
+		string value = text;
+		return value == "true" || value == "false" || value == "1" || value == "0";
+	}
+
+	string ConfigError::toString() const
+	{
+		string location = path;
+		if (line > 0)
+			location = std::to_string(line) + ":" + std::to_string(column) + " " + path;
+		return location + ": " + message;
+	}
+
+	ConfigValidator::ConfigValidator(const char* newSource, int newFirstLine)
+	{
+		source = newSource;
+		firstLine = newFirstLine;
+	}
+	const vector<ConfigError>& ConfigValidator::getErrors() const
+	{
+		return errors;
+	}
+	void ConfigValidator::error(pugi::xml_node node, string message)
+	{
+		ConfigError newError;
+		newError.line = 0;
+		newError.column = 0;
+		newError.path = node.path();
+		newError.message = message;
+
+		ptrdiff_t offset = node.offset_debug();
+		if (source != nullptr && offset >= 0)
+		{
+			//offset_debug points just past the '<', so counting up to it gives the column of the '<'
+			newError.line = firstLine;
+			newError.column = 0;
+			for (ptrdiff_t i = 0; i < offset; i++)
+			{
+				newError.column++;
+				if (source[i] == '\n')
+				{
+					newError.line++;
+					newError.column = 0;
+				}
+			}
+		}
+		errors.push_back(newError);
+	}
+	pugi::xml_node ConfigValidator::require(pugi::xml_node parent, const char* name)
+	{
+		pugi::xml_node child = parent.child(name);
+		if (!child)
+			error(parent, string("missing <") + name + ">");
+		return child;
+	}
+	bool ConfigValidator::requireAttribute(pugi::xml_node node, const char* name)
+	{
+		if (node.attribute(name))
+			return true;
+		error(node, string("missing attribute ") + name);
+		return false;
+	}
+	void ConfigValidator::checkID(pugi::xml_node node, const char* attrName, int max, unordered_set<int>& used)
+	{
+		if (!requireAttribute(node, attrName))
+			return;
+		pugi::xml_attribute attr = node.attribute(attrName);
+		if (!isInt(attr.value()))
+		{
+			error(node, string(attrName) + " is not an integer");
+			return;
+		}
+		int ID = attr.as_int();
+		if (ID < 0 || ID >= max)
+			error(node, string(attrName) + " " + attr.value() + " is out of range [0, " + std::to_string(max) + ")");
+		else if (!used.insert(ID).second)
+			error(node, string(attrName) + " " + attr.value() + " is already in use");
+	}
+
+	bool ConfigValidator::validate(pugi::xml_node doc)
+	{
+		errors.clear();
+		pugi::xml_node root = doc.child("Dreadbot");
+		if (!root)
+		{
+			error(doc, "missing <Dreadbot>");
+			return false;
+		}
+		checkDrivebase(require(root, "Drivebase"));
+		checkMotorGroups(root.child("motorgroups"));
+		checkPneumaticGroups(root.child("pneumaticgroups"));
+		return errors.empty();
+	}
+	void ConfigValidator::checkDrivebase(pugi::xml_node drivebase)
+	{
+		if (!drivebase)
+			return;
+
+		//All four drive motors, each exactly once
+		const char* positions[] = {"frontLeft", "frontRight", "backLeft", "backRight"};
+		bool found[4] = {false, false, false, false};
+		unordered_set<int> driveIDs;
+		pugi::xml_node motors = require(drivebase, "motors");
+		for (auto motor = motors.child("motor"); motor; motor = motor.next_sibling("motor"))
+		{
+			if (!requireAttribute(motor, "position"))
+				continue;
+			string position = motor.attribute("position").value();
+			int i = 0;
+			while (i < 4 && position != positions[i])
+				i++;
+			if (i == 4)
+				error(motor, "unknown motor position " + position);
+			else if (found[i])
+				error(motor, "duplicate motor position " + position);
+			else
+				found[i] = true;
+
+			if (!isInt(motor.child_value()))
+				error(motor, "motor ID is not an integer");
+			else if (!driveIDs.insert(motor.text().as_int()).second)
+				error(motor, string("motor ID ") + motor.child_value() + " is already in use");
+		}
+		for (int i = 0; i < 4 && motors; i++)
+		{
+			if (!found[i])
+				error(motors, string("missing motor position ") + positions[i]);
+		}
+
+		//Controller and its three axes
+		pugi::xml_node controller = require(drivebase, "controller");
+		if (!controller)
+			return;
+		unordered_set<int> controllerIDs;
+		checkID(controller, "controllerID", MAX_CONTROLLERS, controllerIDs);
+
+		const char* dirs[] = {"transX", "transY", "rot"};
+		bool foundDir[3] = {false, false, false};
+		for (auto axis = controller.child("axis"); axis; axis = axis.next_sibling("axis"))
+		{
+			if (!requireAttribute(axis, "dir"))
+				continue;
+			string dir = axis.attribute("dir").value();
+			int i = 0;
+			while (i < 3 && dir != dirs[i])
+				i++;
+			if (i == 3)
+				error(axis, "unknown axis dir " + dir);
+			else if (foundDir[i])
+				error(axis, "duplicate axis dir " + dir);
+			else
+				foundDir[i] = true;
+
+			pugi::xml_node ID = require(axis, "ID");
+			if (ID && !isInt(ID.child_value()))
+				error(ID, "axis ID is not an integer");
+			pugi::xml_node deadzone = require(axis, "deadzone");
+			if (deadzone && !isFloat(deadzone.child_value()))
+				error(deadzone, "deadzone is not a number");
+			pugi::xml_node invert = require(axis, "invert");
+			if (invert && !isBool(invert.child_value()))
+				error(invert, "invert is not true or false");
+		}
+		for (int i = 0; i < 3; i++)
+		{
+			if (!foundDir[i])
+				error(controller, string("missing axis dir ") + dirs[i]);
+		}
+	}
+	void ConfigValidator::checkMotorGroups(pugi::xml_node motorgroups)
+	{
+		unordered_set<string> names;
+		unordered_set<int> canIDs;
+		unordered_set<int> pwmIDs;
+		for (auto group = motorgroups.child("group"); group; group = group.next_sibling("group"))
+		{
+			if (requireAttribute(group, "name") && !names.insert(group.attribute("name").value()).second)
+				error(group, string("duplicate motor group ") + group.attribute("name").value());
+			if (group.attribute("deadzone") && !isFloat(group.attribute("deadzone").value()))
+				error(group, "deadzone is not a number");
+
+			for (auto motor = group.child("motor"); motor; motor = motor.next_sibling("motor"))
+			{
+				if (motor.attribute("CAN") && !isBool(motor.attribute("CAN").value()))
+					error(motor, "CAN is not true or false");
+				if (motor.attribute("invert") && !isBool(motor.attribute("invert").value()))
+					error(motor, "invert is not true or false");
+				checkID(motor, "outputID", MAX_MOTORS, motor.attribute("CAN").as_bool() ? canIDs : pwmIDs);
+			}
+		}
+	}
+	void ConfigValidator::checkPneumaticGroups(pugi::xml_node pneumgroups)
+	{
+		unordered_set<string> names;
+		unordered_set<int> channels; //Shared by single and double solenoids - they use the same PCM outputs
+		for (auto group = pneumgroups.child("group"); group; group = group.next_sibling("group"))
+		{
+			if (requireAttribute(group, "name") && !names.insert(group.attribute("name").value()).second)
+				error(group, string("duplicate pneumatic group ") + group.attribute("name").value());
+			if (group.attribute("deadzone") && !isFloat(group.attribute("deadzone").value()))
+				error(group, "deadzone is not a number");
+
+			for (auto pneumatic = group.child("dsolenoid"); pneumatic; pneumatic = pneumatic.next_sibling("dsolenoid"))
+			{
+				if (pneumatic.attribute("invert") && !isBool(pneumatic.attribute("invert").value()))
+					error(pneumatic, "invert is not true or false");
+				if (!requireAttribute(pneumatic, "actionCount"))
+					continue;
+
+				int actionCount = pneumatic.attribute("actionCount").as_int();
+				if (actionCount == 2)
+				{
+					checkID(pneumatic, "forwardID", MAX_PNEUMS, channels);
+					checkID(pneumatic, "reverseID", MAX_PNEUMS, channels);
+				}
+				else if (actionCount == 1)
+					checkID(pneumatic, "ID", MAX_PNEUMS, channels);
+				else
+					error(pneumatic, "actionCount must be 1 or 2");
+			}
+		}
+	}
+}
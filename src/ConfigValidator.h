@@ -0,0 +1,53 @@
+#pragma once
+#include "../lib/pugixml.hpp"
+#include <string>
+#include <vector>
+#include <unordered_set>
+using std::string;
+using std::vector;
+using std::unordered_set;
+
+/*
+ * Single pass schema check for the XML config in Config.h. This only depends on
+ * PugiXML (no WPILib), so the same check runs off-robot on a config before it
+ * is deployed (tools/config_check). Errors carry the line and column of the offending
+ * element when the document still has its parse buffer, plus the element path.
+ */
+
+namespace dreadbot
+{
+	//Hardware limits shared by the validator and XMLInput
+	const int MAX_CONTROLLERS = 5;
+	const int MAX_MOTORS = 10;
+	const int MAX_PNEUMS = 10;
+
+	struct ConfigError
+	{
+		int line; //!< 1-based, or 0 if the element has no known position (e.g. in a resolved profile)
+		int column;
+		string path; //!< Element path, such as /Dreadbot/motorgroups/group
+		string message;
+		string toString() const;
+	};
+
+	class ConfigValidator
+	{
+	public:
+		ConfigValidator(const char* newSource = nullptr, int newFirstLine = 1); //!< source is the buffer the document was parsed from, used for line/column numbers; firstLine is the file line it starts on
+		bool validate(pugi::xml_node doc); //!< Checks a whole document. Returns true if there were no errors.
+		const vector<ConfigError>& getErrors() const;
+	private:
+		void checkDrivebase(pugi::xml_node drivebase);
+		void checkMotorGroups(pugi::xml_node motorgroups);
+		void checkPneumaticGroups(pugi::xml_node pneumgroups);
+
+		pugi::xml_node require(pugi::xml_node parent, const char* name); //!< Returns the child, or reports it missing
+		bool requireAttribute(pugi::xml_node node, const char* name);
+		void checkID(pugi::xml_node node, const char* attrName, int max, unordered_set<int>& used); //!< Range and duplicate check for an ID attribute
+		void error(pugi::xml_node node, string message);
+
+		const char* source;
+		int firstLine;
+		vector<ConfigError> errors;
+	};
+}
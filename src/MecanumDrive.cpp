@@ -25,7 +25,9 @@ void MecanumDrive::Set(int motorId_lf, int motorId_rf, int motorId_lr, int motor
 	for (uint8_t i = 0; i < MOTOR_COUNT; ++i) {
 		motors[i]->SetControlMode(CANSpeedController::ControlMode::kSpeed);
 		motors[i]->SetPosition(0.0);
-		motors[i]->SelectProfileSlot(0);
+		motors[i]->SelectProfileSlot(1); //Position gains
+		motors[i]->SetPID(POSITION_P, POSITION_I, POSITION_D, 0);
+		motors[i]->SelectProfileSlot(0); //Velocity gains
 		//motors[i]->SetFeedbackDevice(CANTalon::QuadEncoder);
 		motors[i]->SetPID(0.5, 0, 0, 0);
 		motors[i]->SetVoltageRampRate(0.5); //Ramp up for drive motors
@@ -47,33 +49,54 @@ MecanumDrive::~MecanumDrive() {
 
 void MecanumDrive::GoFast() {
 	for (uint8_t i = 0; i < MOTOR_COUNT; ++i) {
-		motors[i]->SetPID(1, 0, 0); //Magically makes the robot drive faster.
+		SetVelocityPID(i, 1, 0, 0); //Magically makes the robot drive faster.
 	}
 }
 
 void MecanumDrive::GoSlow() {
 	for (uint8_t i = 0; i < MOTOR_COUNT; ++i) {
-		motors[i]->SetPID(0.5, 0, 0); //Magically makes the robot drive slower.
+		SetVelocityPID(i, 0.5, 0, 0); //Magically makes the robot drive slower.
 	}
 }
 
 void MecanumDrive::GoSpeed(double speed) {
 	for (uint8_t i = 0; i < MOTOR_COUNT; ++i) {
-		motors[i]->SetPID(speed, 0, 0); //Magically makes the robot drive slower.
+		SetVelocityPID(i, speed, 0, 0); //Magically makes the robot drive slower.
+	}
+}
+
+// Velocity gains live in profile slot 0. In position mode slot 1 is selected, and SetPID would overwrite the position gains.
+void MecanumDrive::SetVelocityPID(uint8_t motor, double p, double i, double d) {
+	if (mode == drivemode::absolute) {
+		motors[motor]->SelectProfileSlot(0);
+		motors[motor]->SetPID(p, i, d);
+		motors[motor]->SelectProfileSlot(1);
+	} else {
+		motors[motor]->SetPID(p, i, d);
+	}
+}
+
+// Drive to a wheel position
+void MecanumDrive::Drive_p(double x, double y, double rotation) {
+	if (mode != drivemode::absolute) {
+		SetDriveMode(drivemode::absolute);
+	}
+
+	double wheels[MOTOR_COUNT];
+	InverseKinematics(x, y, rotation, wheels);
+	for (uint8_t i = 0; i < MOTOR_COUNT; ++i) {
+		motors[i]->Set(encoderOrigin[i] + wheels[i]*motorReversals[i], syncGroup);
 	}
 }
 
 // Drive with wheel velocity
 void MecanumDrive::Drive_v(double x, double y, double rotation) {
-	double x_out = y;
-	double y_out = x;
-	double rot_out = -rotation - (sqrt(x*x + y*y) * 0.01f);
+	if (mode != drivemode::relative) {
+		SetDriveMode(drivemode::relative);
+	}
 
 	double wspeeds[4];
-	wspeeds[m_leftFront] = x_out + y_out + rot_out;
-	wspeeds[m_rightFront] = -x_out + y_out - rot_out;
-	wspeeds[m_leftRear] = -x_out + y_out + rot_out;
-	wspeeds[m_rightRear] = x_out + y_out - rot_out;
+	InverseKinematics(x, y, rotation + (sqrt(x*x + y*y) * 0.01f), wspeeds);
 
 	float absSpeeds[4];
 	for (int i = 0; i < 4; ++i)
@@ -101,8 +124,59 @@ void MecanumDrive::Drive_v(double x, double y, double rotation) {
 
 void MecanumDrive::SetDriveMode(drivemode newMode) {
 	for (uint8_t i = 0; i < MOTOR_COUNT; ++i) {
-		motors[i]->SetControlMode(CANSpeedController::ControlMode::kSpeed);
+		if (newMode == drivemode::absolute) {
+			motors[i]->SetControlMode(CANSpeedController::ControlMode::kPosition);
+			motors[i]->SelectProfileSlot(1);
+		} else {
+			motors[i]->SetControlMode(CANSpeedController::ControlMode::kSpeed);
+			motors[i]->SelectProfileSlot(0);
+		}
 	}
+	mode = newMode;
+}
+
+void MecanumDrive::ResetEncoders() {
+	for (uint8_t i = 0; i < MOTOR_COUNT; ++i) {
+		encoderOrigin[i] = motors[i]->GetPosition();
+	}
+}
+
+void MecanumDrive::GetDisplacement(double& x, double& y, double& rotation) {
+	double wheels[MOTOR_COUNT];
+	for (uint8_t i = 0; i < MOTOR_COUNT; ++i) {
+		wheels[i] = (motors[i]->GetPosition() - encoderOrigin[i]) * motorReversals[i];
+	}
+	ForwardKinematics(wheels, x, y, rotation);
+}
+
+void MecanumDrive::GetWheelPositions(double positions[MOTOR_COUNT]) {
+	for (uint8_t i = 0; i < MOTOR_COUNT; ++i) {
+		positions[i] = motors[i]->GetPosition() * motorReversals[i];
+	}
+}
+
+void MecanumDrive::GetWheelVelocities(double velocities[MOTOR_COUNT]) {
+	for (uint8_t i = 0; i < MOTOR_COUNT; ++i) {
+		velocities[i] = motors[i]->GetSpeed() * motorReversals[i];
+	}
+}
+
+void MecanumDrive::InverseKinematics(double x, double y, double rotation, double wheels[MOTOR_COUNT]) {
+	double x_out = y;
+	double y_out = x;
+	double rot_out = -rotation;
+
+	wheels[m_leftFront] = x_out + y_out + rot_out;
+	wheels[m_rightFront] = -x_out + y_out - rot_out;
+	wheels[m_leftRear] = -x_out + y_out + rot_out;
+	wheels[m_rightRear] = x_out + y_out - rot_out;
+}
+
+// Inverts the wheel mixing in Drive_v
+void MecanumDrive::ForwardKinematics(const double wheels[MOTOR_COUNT], double& x, double& y, double& rotation) {
+	y = (wheels[m_leftFront] - wheels[m_rightFront] - wheels[m_leftRear] + wheels[m_rightRear]) / 4.0;
+	x = (wheels[m_leftFront] + wheels[m_rightFront] + wheels[m_leftRear] + wheels[m_rightRear]) / 4.0;
+	rotation = -(wheels[m_leftFront] - wheels[m_rightFront] + wheels[m_leftRear] - wheels[m_rightRear]) / 4.0;
 }
 
 void MecanumDrive::Engage() {
@@ -121,7 +195,7 @@ void MecanumDrive::Disengage() {
 
 void MecanumDrive::SD_RetrievePID() {
 	for (uint8_t i = 0; i < MOTOR_COUNT; ++i) {
-		motors[i]->SetPID(SmartDashboard::GetNumber("P", 0.5), SmartDashboard::GetNumber("I", 0.0),SmartDashboard::GetNumber("D", 0.0));
+		SetVelocityPID(i, SmartDashboard::GetNumber("P", 0.5), SmartDashboard::GetNumber("I", 0.0),SmartDashboard::GetNumber("D", 0.0));
 	}
 }
 
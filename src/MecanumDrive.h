@@ -7,6 +7,9 @@
 #define MOTOR_COUNT 4
 #define STALL_MOTOR_CURRENT 50
 #define CONTROL_PERIOD 3
+#define POSITION_P 2.0 // Position loop gains (profile slot 1), in Talon units per encoder tick of error. Starting values; tune on the robot
+#define POSITION_I 0.0
+#define POSITION_D 0.0
 
 
 namespace dreadbot {
@@ -28,12 +31,20 @@ namespace dreadbot {
 		MecanumDrive(int motorId_lf, int motorId_rf, int motorId_lr, int motorId_rr);
 		~MecanumDrive();
 
-		void GoSlow();
+		void GoSlow(); //GoSlow, GoFast and GoSpeed set the velocity gains, in either drive mode
 		void GoFast();
 		void GoSpeed(double speed);
-		void Drive_p(double x, double y, double rotation); //Unimplemented position-based driving.
+		void Drive_p(double x, double y, double rotation); //Position based driving: moves to a displacement from the last ResetEncoders(), in encoder ticks along the Drive_v axes.
 		void Drive_v(double x, double y, double rotation); //Velocity based driving.
-		void SetDriveMode(drivemode newMode);
+		void SetDriveMode(drivemode newMode); //Drive_p and Drive_v switch modes as needed
+
+		//Wheel odometry from the Talon encoders, in encoder ticks, with the same axes and signs as Drive_v.
+		void ResetEncoders(); //Makes the current position the origin for GetDisplacement
+		void GetDisplacement(double& x, double& y, double& rotation);
+		void GetWheelPositions(double positions[MOTOR_COUNT]); //Per wheel, with motorReversals applied
+		void GetWheelVelocities(double velocities[MOTOR_COUNT]);
+		static void InverseKinematics(double x, double y, double rotation, double wheels[MOTOR_COUNT]); //The wheel mixing used by Drive_v and Drive_p
+		static void ForwardKinematics(const double wheels[MOTOR_COUNT], double& x, double& y, double& rotation); //Inverts the wheel mixing in Drive_v
 		
 		void Engage();
 		void Disengage();
@@ -42,12 +53,15 @@ namespace dreadbot {
 		void SD_OutputDiagnostics(); //Outputs a bunch of useful motor stats, many of which are disabled (commented out)
 
 	protected:
+		void SetVelocityPID(uint8_t motor, double p, double i, double d);
+
 		bool m_enabled = false;
 		const uint8_t syncGroup = 0x00;
 		const std::string motorNames[MOTOR_COUNT] = {"LF Drive [1]", "RF Drive [2]", "LB Drive [3]", "RB Drive [4]"};
 		const double motorReversals[MOTOR_COUNT] = {-1.0, 1.0, -1.0, 1.0};
 		drivemode mode = drivemode::relative;
 		CANTalon* motors[4];
+		double encoderOrigin[MOTOR_COUNT] = {0.0, 0.0, 0.0, 0.0};
 
 	private:
 		DISALLOW_COPY_AND_ASSIGN(MecanumDrive);
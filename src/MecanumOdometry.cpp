@@ -0,0 +1,143 @@
+#include "MecanumOdometry.h"
+#include <sstream>
+
+using namespace dreadbot;
+
+MecanumOdometry::MecanumOdometry(MecanumDrive* drivebase) : drivebase(drivebase), sequence(0), resetRequested(true),
+	samples(0), totalCost(0.0), worstCost(0.0) {
+	for (uint8_t i = 0; i < POSE_FIELDS; ++i) {
+		published[i].store(0.0, std::memory_order_relaxed);
+	}
+	notifier = new Notifier(SampleCallback, this);
+}
+
+MecanumOdometry::~MecanumOdometry() {
+	Stop();
+	delete notifier;
+}
+
+void MecanumOdometry::Start() {
+	if (!running) {
+		notifier->StartPeriodic(ODOMETRY_PERIOD);
+		running = true;
+	}
+}
+
+void MecanumOdometry::Stop() {
+	if (running) {
+		notifier->Stop();
+		running = false;
+	}
+}
+
+void MecanumOdometry::Reset() {
+	resetRequested.store(true);
+	if (!running) { // Nobody else is writing
+		Sample();
+	}
+}
+
+Pose MecanumOdometry::GetPose() const {
+	double values[POSE_FIELDS];
+	unsigned before, after;
+	do {
+		before = sequence.load(std::memory_order_acquire);
+		for (uint8_t i = 0; i < POSE_FIELDS; ++i) {
+			values[i] = published[i].load(std::memory_order_relaxed);
+		}
+		std::atomic_thread_fence(std::memory_order_acquire);
+		after = sequence.load(std::memory_order_relaxed);
+	} while ((before & 1) || before != after); // Retry if a sample was published while copying
+
+	Pose pose;
+	pose.x = values[p_x];
+	pose.y = values[p_y];
+	pose.heading = values[p_heading];
+	pose.vx = values[p_vx];
+	pose.vy = values[p_vy];
+	pose.omega = values[p_omega];
+	pose.timestamp = values[p_timestamp];
+	return pose;
+}
+
+void MecanumOdometry::SampleCallback(void* param) {
+	static_cast<MecanumOdometry*>(param)->Sample();
+}
+
+void MecanumOdometry::Sample() {
+	double start = Timer::GetFPGATimestamp();
+
+	double wheels[MOTOR_COUNT];
+	double speeds[MOTOR_COUNT];
+	drivebase->GetWheelPositions(wheels);
+	drivebase->GetWheelVelocities(speeds);
+
+	if (resetRequested.exchange(false)) {
+		for (uint8_t i = 0; i < MOTOR_COUNT; ++i) {
+			lastWheels[i] = wheels[i];
+		}
+		x = y = heading = 0.0;
+	}
+
+	// Robot-relative motion since the last sample
+	double delta[MOTOR_COUNT];
+	for (uint8_t i = 0; i < MOTOR_COUNT; ++i) {
+		delta[i] = wheels[i] - lastWheels[i];
+		lastWheels[i] = wheels[i];
+	}
+	double dx, dy, drotation;
+	MecanumDrive::ForwardKinematics(delta, dx, dy, drotation);
+
+	// Rotate into the field frame at the heading halfway through the sample
+	double dheading = ODOMETRY_TICKS_PER_RADIAN != 0.0 ? drotation / ODOMETRY_TICKS_PER_RADIAN : 0.0;
+	double midHeading = heading + dheading / 2.0;
+	double c = cos(midHeading);
+	double s = sin(midHeading);
+	x += dx * c - dy * s;
+	y += dx * s + dy * c;
+	heading += dheading;
+
+	double vx, vy, omega;
+	MecanumDrive::ForwardKinematics(speeds, vx, vy, omega);
+
+	unsigned seq = sequence.load(std::memory_order_relaxed);
+	sequence.store(seq + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	published[p_x].store(x, std::memory_order_relaxed);
+	published[p_y].store(y, std::memory_order_relaxed);
+	published[p_heading].store(heading, std::memory_order_relaxed);
+	published[p_vx].store(vx, std::memory_order_relaxed);
+	published[p_vy].store(vy, std::memory_order_relaxed);
+	published[p_omega].store(omega, std::memory_order_relaxed);
+	published[p_timestamp].store(start, std::memory_order_relaxed);
+	sequence.store(seq + 2, std::memory_order_release);
+
+	double cost = Timer::GetFPGATimestamp() - start;
+	samples.store(samples.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	totalCost.store(totalCost.load(std::memory_order_relaxed) + cost, std::memory_order_relaxed);
+	if (cost > worstCost.load(std::memory_order_relaxed)) {
+		worstCost.store(cost, std::memory_order_relaxed);
+	}
+}
+
+void MecanumOdometry::SD_OutputPose() {
+	Pose pose = GetPose();
+	SmartDashboard::PutNumber("Odometry x", pose.x);
+	SmartDashboard::PutNumber("Odometry y", pose.y);
+	SmartDashboard::PutNumber("Odometry heading", pose.heading);
+	SmartDashboard::PutNumber("Odometry vx", pose.vx);
+	SmartDashboard::PutNumber("Odometry vy", pose.vy);
+	SmartDashboard::PutNumber("Odometry omega", pose.omega);
+}
+
+void MecanumOdometry::LogSampleCost(Hydra::Log* log) {
+	unsigned count = samples.load(std::memory_order_relaxed);
+	if (count == 0) {
+		return;
+	}
+
+	std::stringstream message;
+	message << "Odometry: " << count << " samples, mean " << totalCost.load(std::memory_order_relaxed) / count * 1e6
+		<< " us, worst " << worstCost.load(std::memory_order_relaxed) * 1e6 << " us";
+	log->log(message.str());
+}
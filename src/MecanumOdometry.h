@@ -0,0 +1,64 @@
+#pragma once
+
+#include "WPILib.h"
+#include "MecanumDrive.h"
+#include "../lib/Logger.h"
+#include <atomic>
+
+#define ODOMETRY_PERIOD 0.01 // 100 Hz, the rate of the Talon encoder status frame; sampling faster would only reread the same values
+#define ODOMETRY_TICKS_PER_RADIAN 0.0 // Rotation ticks (see MecanumDrive::ForwardKinematics) per radian, negative if a positive Drive_v rotation turns clockwise. 0 until calibrated: heading stays 0 and the pose is robot-relative
+
+
+namespace dreadbot {
+	struct Pose {
+		double x, y;          // Field-relative encoder ticks from where Reset() was called; +y is the robot's forward at that time
+		double heading;       // Radians, counterclockwise
+		double vx, vy, omega; // Robot-relative, in Talon speed units, with the same axes as Drive_v
+		double timestamp;     // FPGA time of the sample
+	};
+
+	// Samples the drive encoders on a Notifier, independently of the periodic loop, and integrates a pose using the
+	// mecanum forward kinematics. The Notifier thread is the only writer; GetPose() can be called from any thread and never blocks it.
+	class MecanumOdometry {
+	public:
+		MecanumOdometry(MecanumDrive* drivebase);
+		~MecanumOdometry();
+
+		void Start();
+		void Stop();
+		void Reset(); // Makes the current position the origin. Takes effect at the next sample.
+		Pose GetPose() const;
+
+		void SD_OutputPose();
+		void LogSampleCost(Hydra::Log* log); // Mean and worst time spent in one sample since construction
+
+	protected:
+		enum poseField : uint8_t {
+			p_x, p_y, p_heading, p_vx, p_vy, p_omega, p_timestamp, POSE_FIELDS
+		};
+
+		static void SampleCallback(void* param);
+		void Sample();
+
+		MecanumDrive* drivebase;
+		Notifier* notifier;
+		bool running = false;
+
+		// Touched by the sampling thread only
+		double lastWheels[MOTOR_COUNT] = {0.0, 0.0, 0.0, 0.0};
+		double x = 0.0, y = 0.0, heading = 0.0;
+
+		// Published pose, guarded by a sequence lock: odd while the sampler is writing
+		std::atomic<unsigned> sequence;
+		std::atomic<double> published[POSE_FIELDS];
+		std::atomic<bool> resetRequested;
+
+		// Sample cost, written by the sampling thread only
+		std::atomic<unsigned> samples;
+		std::atomic<double> totalCost;
+		std::atomic<double> worstCost;
+
+	private:
+		DISALLOW_COPY_AND_ASSIGN(MecanumOdometry);
+	};
+}
@@ -1,5 +1,6 @@
 #include <WPILib.h>
 #include "MecanumDrive.h"
+#include "MecanumOdometry.h"
 #include "XMLInput.h"
 #include "Autonomous/HALBot.h"
 #include "Robot.h"
@@ -20,6 +21,7 @@ namespace dreadbot
 		Log* sysLog;
 		XMLInput* Input;
 		MecanumDrive *drivebase;
+		MecanumOdometry* odometry;
 
 		MotorGrouping* intake;
 		PneumaticGrouping* lift;
@@ -52,7 +54,13 @@ namespace dreadbot
 			drivebase = new MecanumDrive(1, 2, 3, 4);
 			Input = XMLInput::getInstance();
 			Input->setDrivebase(drivebase);
-			AutonBot = nullptr;
+			Input->parseXMLConfig(); //Every profile is parsed and resolved here, once
+			if (!Input->setProfile(isPracticeBot() ? "practice" : "competition"))
+				sysLog->log("XML config profile missing or invalid, using base config", Hydra::error);
+			Input->loadXMLConfig();
+			odometry = new MecanumOdometry(drivebase); //Only after loadXMLConfig, which replaces the drive Talons
+			odometry->Start(); //Samples on its own thread for the life of the program
+			AutonBot = new HALBot; //Holds every autonomous state; reset in place by each AutonomousInit
 
 			intake = nullptr;
 			lift = nullptr;
@@ -77,7 +85,6 @@ namespace dreadbot
 			compressor->Start();
 			drivebase->Engage();
 
-			Input->loadXMLConfig();
 			gamepad = Input->getController(COM_PRIMARY_DRIVER);
 			gamepad2 = Input->getController(COM_BACKUP_DRIVER);
 
@@ -91,10 +98,9 @@ namespace dreadbot
 		{
 			sysLog->log("Initializing Autonomous");
 			GlobalInit();
-			if (AutonBot == nullptr)
-				AutonBot = new HALBot;
 			sysLog->log("Auton mode is " + (int)GetAutonMode());
-			AutonBot->init(drivebase, intake, lift);
+			odometry->Reset();
+			AutonBot->init(drivebase, odometry, intake, lift);
 			drivebase->GoSlow();
 
 			if (GetAutonMode() == AUTON_MODE_STACK3 || GetAutonMode() == AUTON_MODE_STACK2)
@@ -107,6 +113,7 @@ namespace dreadbot
 		void AutonomousPeriodic()
 		{
 			AutonBot->update();
+			odometry->SD_OutputPose();
 		}
 
 		void TeleopInit()
@@ -119,6 +126,7 @@ namespace dreadbot
 		void TeleopPeriodic()
 		{
 			Input->updateDrivebase(); //Makes the robot drive using Config.h controls and a sensativity curve (tested)
+			odometry->SD_OutputPose();
 
 			//Output controls
 			intake->Set(((float) (gamepad->GetRawAxis(3) > 0.1f) * -0.74f) + gamepad2->GetRawAxis(3) - gamepad2->GetRawAxis(2));
@@ -189,15 +197,11 @@ namespace dreadbot
 		void DisabledInit()
 		{
 			sysLog->log("Disabled robot.");
+			AutonBot->reportProfile(); //No-op unless autonomous ran since the last report
+			odometry->LogSampleCost(sysLog);
 			logger->flushLogBuffers();
 			compressor->Stop();
 			drivebase->Disengage();
-
-			if (AutonBot != nullptr)
-			{
-				delete AutonBot;
-				AutonBot = nullptr;
-			}
 		}
 
 		void DisabledPeriodic()
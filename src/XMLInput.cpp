@@ -1,5 +1,7 @@
 #include "XMLInput.h"
 #include "Config.h"
+#include "ConfigProfiles.h"
+#include "../lib/Logger.h"
 
 namespace dreadbot
 {
@@ -95,6 +97,10 @@ namespace dreadbot
 	XMLInput::XMLInput()
 	{
 		drivebase = nullptr;
+		profileCount = 0;
+		activeProfile = 0;
+		for (int i = 0; i < MAX_PROFILES; i++)
+			profileValid[i] = false;
 		for (int i = 0; i < MAX_CONTROLLERS; i++)
 			controllers[i] = nullptr;
 		for (int i = 0; i < MAX_MOTORS; i++)
@@ -175,7 +181,7 @@ namespace dreadbot
 	}
 	CANTalon* XMLInput::getCANMotor(int ID)
 	{
-		if (ID < MAX_CONTROLLERS - 1 && ID > -1)
+		if (ID < MAX_MOTORS && ID > -1)
 		{
 			if (canMotors[ID] == nullptr)
 				canMotors[ID] = new CANTalon(ID);
@@ -185,7 +191,7 @@ namespace dreadbot
 	}
 	Talon* XMLInput::getPWMMotor(int ID)
 	{
-		if (ID < MAX_CONTROLLERS - 1 && ID > -1)
+		if (ID < MAX_MOTORS && ID > -1)
 		{
 			if (pwmMotors[ID] == nullptr)
 				pwmMotors[ID] = new Talon(ID);
@@ -219,76 +225,118 @@ namespace dreadbot
 			return &pGroups[name];
 		return nullptr;
 	}
+	void XMLInput::parseXMLConfig()
+	{
+		if (profileCount > 0)
+			return; //The config buffer was parsed in place and is gone; the resolved profiles are all we have
+
+		double startTime = Timer::GetFPGATimestamp();
+
+		//Config.h has no entities, CDATA or line endings worth normalizing, so skip all of that and parse in place
+		pugi::xml_parse_result result = profiles[0].load_buffer_inplace(config, sizeof(config) - 1, pugi::parse_minimal);
+		SmartDashboard::PutNumber("XML Load Status: ", result.status);
+		SmartDashboard::PutString("XML Load Result: ", result.description());
+
+		pugi::xml_node base = profiles[0].child("Dreadbot");
+		profileIDs["base"] = 0;
+		profileCount = 1;
+
+		for (auto profile = base.child("profile"); profile; profile = profile.next_sibling("profile"))
+		{
+			if (profileCount >= MAX_PROFILES)
+			{
+				SmartDashboard::PutBoolean("Too Many XML Profiles", true);
+				break;
+			}
+			resolveProfile(profiles[profileCount], base, profile);
+			profileIDs[profile.attribute("name").as_string()] = profileCount;
+			profileCount++;
+		}
+
+		//The base config is everything except the profiles themselves
+		while (base.child("profile"))
+			base.remove_child("profile");
+		activeProfile = 0;
+
+		//Only the base config still has its parse buffer, so only it gets line/column numbers
+		int errorCount = 0;
+		for (auto profile = profileIDs.begin(); profile != profileIDs.end(); profile++)
+		{
+			ConfigValidator validator(profile->second == 0 ? config : nullptr, CONFIG_FIRST_LINE);
+			profileValid[profile->second] = validator.validate(profiles[profile->second]);
+			for (auto err = validator.getErrors().begin(); err != validator.getErrors().end(); err++)
+				Hydra::Logger::getInstance()->log("XML config [" + profile->first + "] " + err->toString(), Hydra::error);
+			errorCount += validator.getErrors().size();
+		}
+		SmartDashboard::PutNumber("XML Config Errors: ", errorCount);
+
+		SmartDashboard::PutNumber("XML Parse Time (ms): ", (Timer::GetFPGATimestamp() - startTime) * 1000.0);
+	}
+	bool XMLInput::setProfile(string name)
+	{
+		auto profile = profileIDs.find(name);
+		if (profile == profileIDs.end() || !profileValid[profile->second])
+			return false;
+		activeProfile = profile->second;
+		SmartDashboard::PutString("XML Profile", name);
+		return true;
+	}
 	void XMLInput::loadXMLConfig()
 	{
 		pGroups.clear();
 		mGroups.clear();
 
-		pugi::xml_document doc;
-		pugi::xml_parse_result result = doc.load_string(config.c_str());
-		SmartDashboard::PutNumber("XML Load Status: ", result.status);
-		SmartDashboard::PutString("XML Load Result: ", result.description());
+		if (profileCount == 0)
+			parseXMLConfig(); //Nobody parsed the config yet; fall back to the base config
+		pugi::xml_document& doc = profiles[activeProfile];
 
 		//Load drivebase motors
 		int motorList[4];
+		int motorsFound = 0;
 		pugi::xml_node base = doc.child("Dreadbot").child("Drivebase");
 		for (auto motor = base.child("motors").child("motor"); motor; motor = motor.next_sibling())
 		{
 			string motorPos = motor.attribute("position").as_string();
+			int motorIndex;
 
 			if (motorPos == "frontLeft")
-				motorList[0] = atoi(motor.child_value());
+				motorIndex = 0;
 			else if (motorPos == "frontRight")
-				motorList[1] = atoi(motor.child_value());
+				motorIndex = 1;
 			else if (motorPos == "backLeft")
-				motorList[2] = atoi(motor.child_value());
+				motorIndex = 2;
 			else if (motorPos == "backRight")
-				motorList[3] = atoi(motor.child_value());
+				motorIndex = 3;
+			else
+				continue;
+			motorList[motorIndex] = motor.text().as_int();
+			motorsFound |= 1 << motorIndex;
 		}
-		drivebase->Set(motorList[0], motorList[1], motorList[2], motorList[3]);
+		if (motorsFound == 0xF) //Never hand the drivebase a half-filled motor list; it keeps its old motors instead
+			drivebase->Set(motorList[0], motorList[1], motorList[2], motorList[3]);
 
 		//Drivebase control loading - rig joystick
 		int controlID = base.child("controller").attribute("controllerID").as_int();
-		if (controllers[controlID] == nullptr)
-			controllers[controlID] = new Joystick(controlID);
-		driveController = controlID;
+		if (getController(controlID) != nullptr)
+			driveController = controlID;
 
 		//Drivebase control loading - get axes
-		string invert;
 		for (auto axis = base.child("controller").child("axis"); axis; axis = axis.next_sibling())
 		{
 			string axisDir = axis.attribute("dir").as_string();
-			invert = axis.child_value("invert");
+			int dir;
 			if (axisDir == "transY")
-			{
-				axes[y] = atoi(axis.child_value("ID"));
-				deadzones[y] = atof(axis.child_value("deadzone"));
-
-				if (invert.find("true")) //I really don't understand how this works...
-					inverts[y] = false;
-				else
-					inverts[y] = true;
-			}
+				dir = y;
 			else if (axisDir == "transX")
-			{
-				axes[x] = atoi(axis.child_value("ID"));
-				deadzones[x] = atof(axis.child_value("deadzone"));
-
-				if (invert.find("true"))
-					inverts[x] = false;
-				else
-					inverts[x] = true;
-			}
+				dir = x;
 			else if (axisDir == "rot")
-			{
-				axes[r] = atoi(axis.child_value("ID"));
-				deadzones[r] = atof(axis.child_value("deadzone"));
+				dir = r;
+			else
+				continue;
 
-				if (invert.find("true"))
-					inverts[r] = false;
-				else
-					inverts[r] = true;
-			}
+			axes[dir] = axis.child("ID").text().as_int();
+			deadzones[dir] = axis.child("deadzone").text().as_float();
+			inverts[dir] = axis.child("invert").text().as_bool();
 		}
 
 		//Load all motor groups
@@ -2,6 +2,7 @@
 #include <WPILib.h>
 #include "../lib/pugixml.hpp"
 #include "MecanumDrive.h"
+#include "ConfigValidator.h"
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -18,9 +19,7 @@ using std::unordered_map;
 
 namespace dreadbot
 {
-	const int MAX_CONTROLLERS = 5;
-	const int MAX_MOTORS = 10;
-	const int MAX_PNEUMS = 10;
+	const int MAX_PROFILES = 4; //Base config plus up to three <profile> elements in Config.h
 
 	const int VEL_DEADZONE = 0.05;
 
@@ -79,7 +78,9 @@ namespace dreadbot
 	public:
 		static XMLInput* getInstance();
 		void setDrivebase(MecanumDrive* newDrivebase); //Sets the drivebase that velocity information is sent to.
-		void loadXMLConfig(); //Clears previous configuration and loads from the XML doc in Config.h
+		void parseXMLConfig(); //Parses Config.h once and resolves every profile against the base config. Call this in RobotInit.
+		bool setProfile(string name); //Selects the resolved profile used by loadXMLConfig. Returns false if there is no such profile or it failed validation.
+		void loadXMLConfig(); //Clears previous configuration and loads from the active profile
 		void updateDrivebase(); //Handels all drivebase-related stuff, including inverts, deadzones, and the sensativity curve.
 		Joystick* getController(int ID); //!< Gets a joystick with the given ID. If joystick does not exist, creates joystick with ID and returns it.
 		CANTalon* getCANMotor(int ID); //!< Gets a CANTalon with the given ID. If the CANTalon does not exist, creates CANTalon with ID and returns it.
@@ -94,6 +95,13 @@ namespace dreadbot
 		unordered_map<string, PneumaticGrouping> pGroups;
 		unordered_map<string, MotorGrouping> mGroups;
 
+		//Resolved configs, parsed once. profiles[0] is always the base config.
+		pugi::xml_document profiles[MAX_PROFILES];
+		bool profileValid[MAX_PROFILES];
+		unordered_map<string, int> profileIDs;
+		int profileCount;
+		int activeProfile;
+
 		MecanumDrive* drivebase;
 		static XMLInput* singlePtr;
 		Joystick* controllers[MAX_CONTROLLERS];	//All pointers are *supposed* to be null unless they are in usage.
@@ -0,0 +1,112 @@
+/*
+ * Checks xml_document::add_attribute_index, run off-robot with make -C tools
+ * check. Queries that can use the index must return the same nodes, in the
+ * same order, as on a document without one: right after a load, from several
+ * threads at once (build with -fsanitize=thread to check they only read the
+ * index), after the tree is edited, and after the pair is registered again.
+ */
+#include "../lib/pugixml.hpp"
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+using std::string;
+
+static int runs = 0;
+static int failures = 0;
+
+static string ids(const pugi::xpath_node_set& nodes)
+{
+	string out;
+	for (size_t i = 0; i < nodes.size(); i++)
+		out += string(nodes[i].node().attribute("n").value()) + " ";
+	return out;
+}
+
+static void compare(const char* name, pugi::xml_document& indexed, pugi::xml_document& plain, const char* query)
+{
+	string expected = ids(plain.select_nodes(query));
+	string result = ids(indexed.select_nodes(query));
+
+	runs++;
+	if (expected.empty() || result != expected)
+	{
+		if (failures++ < 10)
+			printf("FAIL %s %s: [%s], scan gives [%s]\n", name, query, result.c_str(), expected.c_str());
+	}
+}
+
+int main()
+{
+	string text = "<r>";
+	for (int i = 0; i < 2000; i++)
+		text += "<g><a id='" + std::to_string(i % 50) + "' n='" + std::to_string(i) + "'/><b id='7' n='b" + std::to_string(i) + "'/></g>";
+	text += "</r>";
+
+	const char* queries[] = {"//a[@id='7']", "//a[@id = '49']", "/r/g/a[@id='0']", "//g[a/@id='3']/b"};
+
+	pugi::xml_document plain;
+	plain.load_string(text.c_str());
+
+	pugi::xml_document indexed;
+	indexed.add_attribute_index("a", "id");
+	indexed.load_string(text.c_str());
+
+	for (int q = 0; q < 4; q++)
+		compare("loaded", indexed, plain, queries[q]);
+
+	//Concurrent queries on a freshly loaded document
+	indexed.load_string(text.c_str());
+	std::vector<string> results(8);
+	std::vector<std::thread> threads;
+	for (size_t t = 0; t < results.size(); t++)
+		threads.push_back(std::thread([&indexed, &results, t]()
+		{
+			const pugi::xml_document& doc = indexed;
+			for (int i = 0; i < 20; i++)
+				results[t] = ids(doc.select_nodes("//a[@id='7']"));
+		}));
+	for (size_t t = 0; t < threads.size(); t++)
+		threads[t].join();
+
+	string expected = ids(plain.select_nodes("//a[@id='7']"));
+	for (size_t t = 0; t < results.size(); t++)
+	{
+		runs++;
+		if (results[t] != expected && failures++ < 10)
+			printf("FAIL thread %d: [%s]\n", (int)t, results[t].c_str());
+	}
+
+	//Edits make queries scan until the pair is registered again
+	pugi::xml_document* docs[] = {&indexed, &plain};
+	for (int d = 0; d < 2; d++)
+	{
+		pugi::xml_node g = docs[d]->child("r").prepend_child("g");
+		g.append_child("a").append_attribute("n") = "new";
+		g.child("a").prepend_attribute("id") = "7";
+		docs[d]->child("r").child("g").next_sibling("g").child("a").attribute("id") = "49";
+	}
+	for (int q = 0; q < 4; q++)
+		compare("edited", indexed, plain, queries[q]);
+
+	indexed.add_attribute_index("a", "id");
+	for (int q = 0; q < 4; q++)
+		compare("reindexed", indexed, plain, queries[q]);
+
+	//A document copied with reset(proto) and one appended to with append_buffer
+	pugi::xml_document copy;
+	copy.add_attribute_index("a", "id");
+	copy.reset(plain);
+	for (int q = 0; q < 4; q++)
+		compare("copied", copy, plain, queries[q]);
+
+	string more = "<g><a id='7' n='more'/></g>";
+	copy.child("r").append_buffer(more.data(), more.size());
+	plain.child("r").append_buffer(more.data(), more.size());
+	for (int q = 0; q < 4; q++)
+		compare("appended", copy, plain, queries[q]);
+
+	printf("%d run(s), %d failure(s)\n", runs, failures);
+	return failures == 0 ? 0 : 1;
+}
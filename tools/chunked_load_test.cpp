@@ -0,0 +1,97 @@
+/*
+ * Compares xml_document::load_begin/load_chunk/load_end against load_buffer,
+ * run off-robot with make -C tools check. Every document, and every prefix of
+ * it (a stream that stopped early), is fed in random chunk sizes under several
+ * option sets. Trees must match when the parse succeeds, and the status and
+ * offset of the error must match when it does not.
+ */
+#include "../lib/pugixml.hpp"
+#include "../src/Config.h"
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using std::string;
+
+static int runs = 0;
+static int failures = 0;
+
+static string dump(pugi::xml_document& doc)
+{
+	std::ostringstream out;
+	doc.save(out, "", pugi::format_raw | pugi::format_no_declaration);
+	return out.str();
+}
+
+static void compare(const string& text, unsigned int options, unsigned int seed, size_t maxChunk)
+{
+	pugi::xml_document whole;
+	pugi::xml_parse_result expected = whole.load_buffer(text.data(), text.size(), options);
+
+	srand(seed);
+	pugi::xml_document chunked;
+	chunked.load_begin(options);
+	pugi::xml_parse_result result = chunked.load_chunk(text.data(), 0);
+	for (size_t pos = 0; pos < text.size() && result; )
+	{
+		size_t length = 1 + rand() % maxChunk;
+		if (length > text.size() - pos)
+			length = text.size() - pos;
+		result = chunked.load_chunk(text.data() + pos, length);
+		pos += length;
+	}
+	if (result)
+		result = chunked.load_end();
+
+	runs++;
+	bool same = expected.status == result.status;
+	if (same && expected)
+		same = dump(whole) == dump(chunked);
+	else if (same)
+		same = expected.offset == result.offset;
+	if (!same)
+	{
+		if (failures++ < 10)
+			printf("FAIL options=%x chunks<=%u: %s at %d, chunked %s at %d\n  %.80s\n", options, (unsigned)maxChunk,
+				expected.description(), (int)expected.offset, result.description(), (int)result.offset, text.c_str());
+	}
+}
+
+int main()
+{
+	std::vector<string> documents = {
+		config,
+		"<?xml version='1.0'?><!DOCTYPE r [ <!ENTITY x 'y'> <!-- c ] --> ]><!-- pre --><r a='1>2' b=\"/\">t<![CDATA[<x></r>]]>"
+			"<!--</r>--><?pi </r>?><c/><d><e/></d>tail</r><!--post--><?p?>",
+		"<r/>", "<r/><!--x-->", "<r></r>", "<r><a></b></r>", "<r></r><s/>", "<r></r>junk", "<r a='1' a='2'/>",
+		"<r><a b='unterminated></r>", "</x><r/>", "<r>x</r >", "<r>&amp;&bad;</r>", "", "   ", "<!--only-->",
+		"\xef\xbb\xbf<r>bom</r>", "<?xml version='1.0' encoding='latin1'?><r>\xe9</r>", string("<\0r\0/\0>\0", 8)
+	};
+	string list = "<r>";
+	for (int i = 0; i < 20; i++)
+		list += "<i n='" + std::to_string(i) + "'>x<j/></i>\n";
+	documents.push_back(list + "</r>");
+
+	//Streams that stop early, at every byte of the small documents and at a spread of points in the config
+	size_t complete = documents.size();
+	for (size_t i = 0; i < complete; i++)
+	{
+		const string text = documents[i];
+		size_t step = text.size() > 200 ? text.size() / 97 : 1;
+		for (size_t cut = 1; cut < text.size(); cut += step)
+			documents.push_back(text.substr(0, cut));
+	}
+
+	const unsigned int options[] = {pugi::parse_minimal, pugi::parse_default, pugi::parse_full,
+		pugi::parse_default | pugi::parse_ws_pcdata, pugi::parse_default | pugi::parse_fragment};
+	const size_t chunks[] = {1, 3, 7, 64, 1 << 20};
+	for (auto text = documents.begin(); text != documents.end(); text++)
+		for (int o = 0; o < 5; o++)
+			for (int c = 0; c < 5; c++)
+				compare(*text, options[o], c, chunks[c]);
+
+	printf("%d run(s), %d failure(s)\n", runs, failures);
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,64 @@
+/*
+ * Off-robot check of the XML config in src/Config.h. Parses it the same way
+ * XMLInput::parseXMLConfig does, resolves every profile, runs ConfigValidator
+ * over the base config and each profile, and prints the errors as
+ * src/Config.h:line:column. Exits with 1 if there are any, so it can gate a
+ * deploy: make -C tools check
+ */
+#include "../src/Config.h"
+#include "../src/ConfigProfiles.h"
+#include "../src/ConfigValidator.h"
+#include <cstdio>
+
+using namespace dreadbot;
+
+static int report(const char* profile, const ConfigValidator& validator)
+{
+	const vector<ConfigError>& errors = validator.getErrors();
+	for (auto err = errors.begin(); err != errors.end(); err++)
+	{
+		if (err->line > 0)
+			printf("src/Config.h:%d:%d: [%s] %s: %s\n", err->line, err->column, profile, err->path.c_str(), err->message.c_str());
+		else
+			printf("src/Config.h: [%s] %s: %s\n", profile, err->path.c_str(), err->message.c_str());
+	}
+	return (int)errors.size();
+}
+
+int main()
+{
+	pugi::xml_document doc;
+	pugi::xml_parse_result result = doc.load_buffer_inplace(config, sizeof(config) - 1, pugi::parse_minimal);
+	if (!result)
+	{
+		//Count lines up to the error the same way the validator does
+		int line = CONFIG_FIRST_LINE;
+		for (ptrdiff_t i = 0; i < result.offset; i++)
+			if (config[i] == '\n')
+				line++;
+		printf("src/Config.h:%d: parse error: %s\n", line, result.description());
+		return 1;
+	}
+
+	pugi::xml_node base = doc.child("Dreadbot");
+	int errorCount = 0;
+	int profileCount = 0;
+	for (auto profile = base.child("profile"); profile; profile = profile.next_sibling("profile"))
+	{
+		pugi::xml_document resolved;
+		resolveProfile(resolved, base, profile);
+		ConfigValidator validator;
+		validator.validate(resolved);
+		errorCount += report(profile.attribute("name").as_string(), validator);
+		profileCount++;
+	}
+
+	while (base.child("profile"))
+		base.remove_child("profile");
+	ConfigValidator validator(config, CONFIG_FIRST_LINE);
+	validator.validate(doc);
+	errorCount += report("base", validator);
+
+	printf("Config.h: base and %d profile(s), %d error(s)\n", profileCount, errorCount);
+	return errorCount == 0 ? 0 : 1;
+}
@@ -0,0 +1,78 @@
+/*
+ * Cases for the profile merge rules in src/Config.h, run off-robot with
+ * make -C tools check. Each case resolves one profile against a small base
+ * config and compares the result, serialized without formatting.
+ */
+#include "../src/ConfigProfiles.h"
+#include <cstdio>
+#include <sstream>
+#include <string>
+
+using std::string;
+
+static int failures = 0;
+
+static void expect(const char* name, const char* config, const char* expected)
+{
+	pugi::xml_document doc;
+	if (!doc.load_string(config))
+	{
+		printf("FAIL %s: config does not parse\n", name);
+		failures++;
+		return;
+	}
+
+	pugi::xml_node base = doc.child("Dreadbot");
+	pugi::xml_document resolved;
+	dreadbot::resolveProfile(resolved, base, base.child("profile"));
+
+	std::ostringstream out;
+	resolved.save(out, "", pugi::format_raw | pugi::format_no_declaration);
+	if (out.str() != expected)
+	{
+		printf("FAIL %s\n  expected %s\n  got      %s\n", name, expected, out.str().c_str());
+		failures++;
+	}
+	else
+		printf("ok   %s\n", name);
+}
+
+int main()
+{
+	expect("attribute-only override keeps the children",
+		"<Dreadbot><controller controllerID=\"0\"><axis dir=\"transY\"><ID>1</ID></axis></controller>"
+		"<profile name=\"p\"><controller controllerID=\"1\"/></profile></Dreadbot>",
+		"<Dreadbot><controller controllerID=\"1\"><axis dir=\"transY\"><ID>1</ID></axis></controller></Dreadbot>");
+
+	expect("attribute-only override adds attributes",
+		"<Dreadbot><motors><motor position=\"frontLeft\">1</motor></motors>"
+		"<profile name=\"p\"><motors extra=\"yes\"/></profile></Dreadbot>",
+		"<Dreadbot><motors extra=\"yes\"><motor position=\"frontLeft\">1</motor></motors></Dreadbot>");
+
+	expect("keyed element is replaced in place",
+		"<Dreadbot><motors><motor position=\"frontLeft\">1</motor><motor position=\"frontRight\">2</motor></motors>"
+		"<profile name=\"p\"><motors><motor position=\"frontLeft\">5</motor></motors></profile></Dreadbot>",
+		"<Dreadbot><motors><motor position=\"frontLeft\">5</motor><motor position=\"frontRight\">2</motor></motors></Dreadbot>");
+
+	expect("value element replaces the value",
+		"<Dreadbot><controller controllerID=\"0\"><deadzone>0.05</deadzone><sensitivity>1</sensitivity></controller>"
+		"<profile name=\"p\"><controller><deadzone>0.1</deadzone></controller></profile></Dreadbot>",
+		"<Dreadbot><controller controllerID=\"0\"><deadzone>0.1</deadzone><sensitivity>1</sensitivity></controller></Dreadbot>");
+
+	expect("keyed child of a merged container",
+		"<Dreadbot><controller controllerID=\"0\"><axis dir=\"transX\"><ID>0</ID></axis><axis dir=\"transY\"><ID>1</ID></axis></controller>"
+		"<profile name=\"p\"><controller><axis dir=\"transY\"><ID>3</ID></axis></controller></profile></Dreadbot>",
+		"<Dreadbot><controller controllerID=\"0\"><axis dir=\"transX\"><ID>0</ID></axis><axis dir=\"transY\"><ID>3</ID></axis></controller></Dreadbot>");
+
+	expect("unknown element is appended",
+		"<Dreadbot><motorgroups><group name=\"intake\"/></motorgroups>"
+		"<profile name=\"p\"><motorgroups><group name=\"lift\"/></motorgroups></profile></Dreadbot>",
+		"<Dreadbot><motorgroups><group name=\"intake\" /><group name=\"lift\" /></motorgroups></Dreadbot>");
+
+	expect("profiles are not part of the resolved config",
+		"<Dreadbot><a>1</a><profile name=\"p\"/><profile name=\"q\"><a>2</a></profile></Dreadbot>",
+		"<Dreadbot><a>1</a></Dreadbot>");
+
+	printf("%d failure(s)\n", failures);
+	return failures == 0 ? 0 : 1;
+}
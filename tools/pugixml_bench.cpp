@@ -0,0 +1,602 @@
+/*
+ * Benchmark for the bundled pugixml, run off-robot with make -C tools bench.
+ * Build it from two commits and compare the output, since numbers from
+ * different machines or runs are not comparable. For every input it times
+ * each operation in its plain DOM form and in the forms our additions to
+ * pugixml provide, next to each other:
+ *
+ *   parse_minimal, parse_default, parse_full
+ *                       load_buffer_inplace under each option set
+ *   parse_reuse         the same document loaded again with set_memory_reuse
+ *   parse_arena         loaded into a caller-owned block with set_arena
+ *   load_chunked        load_begin, load_chunk in 64 KB pieces and load_end
+ *   read                xml_reader over the buffer, no tree built
+ *   load_file           load_file from a temporary copy of the input
+ *   load_file_mmap      load_file_mmap from the same copy
+ *   traverse            a DOM traversal
+ *   select_descendant   a descendant query, compiled once
+ *   select_parallel     the same with evaluate_node_set_parallel
+ *   select_predicate    an attribute predicate query, compiled once
+ *   select_indexed      the same on a document with add_attribute_index
+ *   select_nodes        the same through select_nodes, compiled every time
+ *   select_cached       the same through an xpath_query_cache
+ *   save                save to a memory writer
+ *   save_file           save_file to the temporary file
+ *   save_fd             save through xml_writer_fd to the temporary file
+ *   set_double          set_value(double) on every numeric attribute
+ *   set_float           set_value(float) on every numeric attribute
+ *
+ * and reports for each:
+ *
+ *   best_ms      best of the trials for one operation
+ *   mb_per_s     input size (output size for the save rows, text of the
+ *                numeric attributes for the set rows) over best_ms
+ *   allocations  calls to the pugixml allocator for one operation
+ *   peak_heap_kb most memory pugixml held at once during one operation
+ *   max_rss_kb   peak RSS of the process so far; rows run in order, so run one
+ *                row per process (--only input/operation) to get its own peak
+ *   result       nodes and attributes parsed, read or visited, nodes selected,
+ *                or a hash of the saved text (after set_value, of the new
+ *                values). Every form of an operation gives the same result as
+ *                its plain DOM form, and a change that is only meant to be
+ *                faster must not change it
+ *
+ * The inputs are the robot config from src/Config.h and three generated logs
+ * (telemetry: 200,000 <sample> elements with 9 numeric attributes, about
+ * 24 MB; telemetry_medium: the same with 4,000 samples, about 480 KB;
+ * scouting: 60,000 <entry> elements with prose text, about 28 MB). Files
+ * given on the command line are added to them; they get no indexed query.
+ * select_parallel needs PUGIXML_HAS_THREADS, and load_file_mmap and save_fd
+ * need PUGIXML_HAS_POSIX_IO.
+ *
+ *   pugixml_bench [--json] [--trials N] [--scale F] [--only input/operation] [file.xml...]
+ */
+#include "../lib/pugixml.hpp"
+#include "../src/Config.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+using std::string;
+using std::vector;
+
+//Allocator hooks, so that every pugixml allocation is counted and the heap it holds is tracked. Counters are atomic
+//because select_parallel allocates on worker threads
+static std::atomic<size_t> allocations(0);
+static std::atomic<size_t> heapBytes(0);
+static std::atomic<size_t> peakHeapBytes(0);
+
+static const size_t HEADER = 16; //Keeps the returned pointers aligned like malloc's
+
+static void* countingAllocate(size_t size)
+{
+	char* block = static_cast<char*>(malloc(size + HEADER));
+	if (!block)
+		return 0;
+	*reinterpret_cast<size_t*>(block) = size;
+	allocations++;
+	size_t heap = heapBytes += size;
+	size_t peak = peakHeapBytes;
+	while (heap > peak && !peakHeapBytes.compare_exchange_weak(peak, heap))
+		;
+	return block + HEADER;
+}
+static void countingDeallocate(void* ptr)
+{
+	if (!ptr)
+		return;
+	char* block = static_cast<char*>(ptr) - HEADER;
+	heapBytes -= *reinterpret_cast<size_t*>(block);
+	free(block);
+}
+static void resetCounters()
+{
+	allocations = 0;
+	peakHeapBytes = heapBytes.load();
+}
+
+//Set for the first, counted run of an operation, which also works out the result column
+static bool firstRun = false;
+
+static long maxRssKb()
+{
+	rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_maxrss; //Kilobytes on Linux
+}
+
+//Deterministic generator, so every build gets the same inputs; each input starts from its own seed, so that it is the
+//same whether or not --only skips the others
+static unsigned long long seed = 1;
+static unsigned int nextRandom()
+{
+	seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+	return (unsigned int)(seed >> 33);
+}
+static double uniform(double low, double high)
+{
+	return low + (high - low) * (nextRandom() / 2147483648.0);
+}
+
+static string telemetry(int samples)
+{
+	seed = 1;
+	string text = "<?xml version=\"1.0\"?>\n<match team=\"3656\">\n";
+	char line[256];
+	for (int i = 0; i < samples; i++)
+	{
+		snprintf(line, sizeof(line), "  <sample t=\"%.4f\" x=\"%.5f\" y=\"%.5f\" heading=\"%.3f\" lf=\"%d\" rf=\"%d\" lr=\"%d\" rr=\"%d\" battery=\"%.2f\"/>\n",
+			i * 0.02, uniform(-8, 8), uniform(-4, 4), uniform(-180, 180), (int)uniform(-600, 600), (int)uniform(-600, 600),
+			(int)uniform(-600, 600), (int)uniform(-600, 600), uniform(11, 13));
+		text += line;
+	}
+	return text + "</match>\n";
+}
+static string scouting(int entries)
+{
+	const char* words[] = {"the", "robot", "picked", "up", "a", "tote", "and", "stacked", "it", "near", "the", "landfill",
+		"while", "the", "drive", "team", "watched", "the", "container"};
+	const int wordCount = sizeof(words) / sizeof(words[0]);
+
+	seed = 2;
+	string text = "<?xml version=\"1.0\"?>\n<scouting>\n";
+	char line[128];
+	for (int i = 0; i < entries; i++)
+	{
+		snprintf(line, sizeof(line), "  <entry team=\"%d\" match=\"%d\" alliance=\"%s\">\n    <comment>",
+			1 + (int)(nextRandom() % 6000), i, nextRandom() % 2 ? "red" : "blue");
+		text += line;
+		for (int w = 0; w < 40; w++)
+			text += string(w ? " " : "") + words[nextRandom() % wordCount];
+		text += "</comment>\n    <notes>";
+		for (int w = 0; w < 25; w++)
+			text += string(w ? " " : "") + words[nextRandom() % wordCount];
+		text += " &amp; more</notes>\n  </entry>\n";
+	}
+	return text + "</scouting>\n";
+}
+
+struct Input
+{
+	string name;
+	string text;
+	string descendantQuery;
+	string predicateQuery;
+	string indexElement; //The element and attribute the predicate compares, for select_indexed
+	string indexAttribute;
+};
+
+struct Row
+{
+	string input;
+	string operation;
+	size_t bytes;
+	double bestMs;
+	size_t allocations;
+	size_t peakHeapBytes;
+	long maxRssKb;
+	unsigned long long result;
+};
+
+//Times op: one counted run, then trials of enough repetitions to take about 20 ms each
+template <typename Op> static Row measure(const Input& input, const char* operation, size_t bytes, int trials, Op op)
+{
+	Row row;
+	row.input = input.name;
+	row.operation = operation;
+	row.bytes = bytes;
+
+	resetCounters();
+	firstRun = true;
+	row.result = op();
+	firstRun = false;
+	row.allocations = allocations;
+	row.peakHeapBytes = peakHeapBytes - heapBytes;
+
+	double once = 1e9;
+	for (int reps = 1; ; reps *= 2)
+	{
+		auto start = std::chrono::steady_clock::now();
+		for (int r = 0; r < reps; r++)
+			op();
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		once = seconds / reps;
+		if (seconds > 0.002)
+			break;
+	}
+	int reps = once > 0.02 ? 1 : (int)(0.02 / once);
+
+	row.bestMs = 1e9;
+	for (int t = 0; t < trials; t++)
+	{
+		auto start = std::chrono::steady_clock::now();
+		for (int r = 0; r < reps; r++)
+			op();
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / reps;
+		if (ms < row.bestMs)
+			row.bestMs = ms;
+	}
+	row.maxRssKb = maxRssKb();
+	return row;
+}
+
+struct CountingWriter: pugi::xml_writer
+{
+	size_t size;
+	unsigned long long hash;
+
+	CountingWriter(): size(0), hash(14695981039346656037ULL) {}
+
+	virtual void write(const void* data, size_t length)
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		for (size_t i = 0; i < length; i++)
+			hash = (hash ^ bytes[i]) * 1099511628211ULL; //FNV-1a
+		size += length;
+	}
+};
+
+static unsigned long long traverse(pugi::xml_node root)
+{
+	unsigned long long count = 0;
+	pugi::xml_node node = root;
+	while (node)
+	{
+		count++;
+		for (pugi::xml_attribute attr = node.first_attribute(); attr; attr = attr.next_attribute())
+			count++;
+
+		if (node.first_child())
+			node = node.first_child();
+		else
+		{
+			while (node && !node.next_sibling() && node != root)
+				node = node.parent();
+			node = node == root ? pugi::xml_node() : node.next_sibling();
+		}
+	}
+	return count;
+}
+
+static bool readFile(const char* path, string& text)
+{
+	FILE* file = fopen(path, "rb");
+	if (!file)
+		return false;
+	char chunk[65536];
+	size_t read;
+	while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0)
+		text.append(chunk, read);
+	fclose(file);
+	return true;
+}
+
+//Counts what a parse_default DOM holds: the document node, elements, attributes and text nodes
+static unsigned long long readEvents(const string& text)
+{
+	pugi::xml_reader reader;
+	if (!reader.open_buffer(text.data(), text.size(), pugi::parse_default))
+		return 0;
+
+	unsigned long long count = 1;
+	bool inText = false;
+	for (pugi::xml_reader_event event; (event = reader.next()) != pugi::event_end_document && event != pugi::event_error; )
+	{
+		if (event == pugi::event_start_element)
+			count += 1 + reader.attribute_count();
+		else if (event == pugi::event_text && !inText)
+			count++; //Long text arrives as several events but is one node
+		inText = event == pugi::event_text;
+	}
+	return reader.event() == pugi::event_end_document ? count : 0;
+}
+
+static unsigned long long hashFile(const char* path)
+{
+	string text;
+	if (!readFile(path, text))
+		return 0;
+	CountingWriter writer;
+	writer.write(text.data(), text.size());
+	return writer.hash;
+}
+
+static void benchmark(const Input& input, int trials, const string& only, vector<Row>& rows)
+{
+	auto want = [&](const char* operation) { return only.empty() || only == input.name + "/" + operation; };
+
+	struct Flags
+	{
+		const char* operation;
+		unsigned int options;
+	};
+	const Flags parses[] = {{"parse_minimal", pugi::parse_minimal}, {"parse_default", pugi::parse_default}, {"parse_full", pugi::parse_full}};
+	vector<char> buffer(input.text.size());
+
+	for (int i = 0; i < 3; i++)
+	{
+		if (!want(parses[i].operation))
+			continue;
+		unsigned int options = parses[i].options;
+		rows.push_back(measure(input, parses[i].operation, input.text.size(), trials, [&]() -> unsigned long long
+		{
+			//The copy is part of the timing, like any load_buffer call that has to keep its input
+			memcpy(&buffer[0], input.text.data(), input.text.size());
+			pugi::xml_document doc;
+			pugi::xml_parse_result result = doc.load_buffer_inplace(&buffer[0], buffer.size(), options);
+			return result && firstRun ? traverse(doc) : 0;
+		}));
+	}
+
+	if (want("parse_reuse"))
+	{
+		//Loaded once beforehand, so that the counted run shows the steady state
+		pugi::xml_document doc;
+		doc.set_memory_reuse(true);
+		memcpy(&buffer[0], input.text.data(), input.text.size());
+		doc.load_buffer_inplace(&buffer[0], buffer.size());
+		rows.push_back(measure(input, "parse_reuse", input.text.size(), trials, [&]() -> unsigned long long
+		{
+			memcpy(&buffer[0], input.text.data(), input.text.size());
+			pugi::xml_parse_result result = doc.load_buffer_inplace(&buffer[0], buffer.size());
+			return result && firstRun ? traverse(doc) : 0;
+		}));
+	}
+	if (want("parse_arena"))
+	{
+		//Sized from what the heap held for the same load, with room for the arena's own page layout
+		size_t arenaSize;
+		{
+			memcpy(&buffer[0], input.text.data(), input.text.size());
+			resetCounters();
+			size_t before = heapBytes;
+			pugi::xml_document doc;
+			doc.load_buffer_inplace(&buffer[0], buffer.size());
+			arenaSize = 2 * (peakHeapBytes - before) + 65536;
+		}
+		vector<char> arena(arenaSize);
+		pugi::xml_document doc;
+		doc.set_arena(&arena[0], arena.size());
+		rows.push_back(measure(input, "parse_arena", input.text.size(), trials, [&]() -> unsigned long long
+		{
+			memcpy(&buffer[0], input.text.data(), input.text.size());
+			pugi::xml_parse_result result = doc.load_buffer_inplace(&buffer[0], buffer.size());
+			return result && firstRun ? traverse(doc) : 0;
+		}));
+	}
+	if (want("load_chunked"))
+		rows.push_back(measure(input, "load_chunked", input.text.size(), trials, [&]() -> unsigned long long
+		{
+			pugi::xml_document doc;
+			doc.load_begin();
+			pugi::xml_parse_result result = doc.load_chunk(input.text.data(), 0);
+			for (size_t pos = 0; pos < input.text.size() && result; pos += 65536)
+				result = doc.load_chunk(input.text.data() + pos, std::min<size_t>(65536, input.text.size() - pos));
+			if (result)
+				result = doc.load_end();
+			return result && firstRun ? traverse(doc) : 0;
+		}));
+	if (want("read"))
+		rows.push_back(measure(input, "read", input.text.size(), trials, [&]() { return readEvents(input.text); }));
+
+	//A copy of the input for the file rows; save_file and save_fd overwrite it with the same text
+	char path[] = "/tmp/pugixml_bench_XXXXXX";
+	int fd = mkstemp(path);
+	if (fd < 0 || write(fd, input.text.data(), input.text.size()) != (ssize_t)input.text.size())
+	{
+		fprintf(stderr, "cannot write %s\n", path);
+		exit(1);
+	}
+	close(fd);
+
+	if (want("load_file"))
+		rows.push_back(measure(input, "load_file", input.text.size(), trials, [&]() -> unsigned long long
+		{
+			pugi::xml_document doc;
+			pugi::xml_parse_result result = doc.load_file(path);
+			return result && firstRun ? traverse(doc) : 0;
+		}));
+#ifdef PUGIXML_HAS_POSIX_IO
+	if (want("load_file_mmap"))
+		rows.push_back(measure(input, "load_file_mmap", input.text.size(), trials, [&]() -> unsigned long long
+		{
+			pugi::xml_document doc;
+			pugi::xml_parse_result result = doc.load_file_mmap(path, pugi::parse_default);
+			return result && firstRun ? traverse(doc) : 0;
+		}));
+#endif
+
+	pugi::xml_document doc;
+	doc.load_buffer(input.text.data(), input.text.size());
+	pugi::xpath_query descendant(input.descendantQuery.c_str());
+	pugi::xpath_query predicate(input.predicateQuery.c_str());
+
+	if (want("traverse"))
+		rows.push_back(measure(input, "traverse", input.text.size(), trials, [&]() { return traverse(doc); }));
+	if (want("select_descendant"))
+		rows.push_back(measure(input, "select_descendant", input.text.size(), trials, [&]() -> unsigned long long { return descendant.evaluate_node_set(doc).size(); }));
+#ifdef PUGIXML_HAS_THREADS
+	if (want("select_parallel"))
+		rows.push_back(measure(input, "select_parallel", input.text.size(), trials, [&]() -> unsigned long long { return descendant.evaluate_node_set_parallel(doc).size(); }));
+#endif
+	if (want("select_predicate"))
+		rows.push_back(measure(input, "select_predicate", input.text.size(), trials, [&]() -> unsigned long long { return predicate.evaluate_node_set(doc).size(); }));
+	if (want("select_indexed") && !input.indexElement.empty())
+	{
+		//The index is built by the load, so only the lookups are timed
+		pugi::xml_document indexed;
+		indexed.add_attribute_index(input.indexElement.c_str(), input.indexAttribute.c_str());
+		indexed.load_buffer(input.text.data(), input.text.size());
+		rows.push_back(measure(input, "select_indexed", input.text.size(), trials, [&]() -> unsigned long long { return predicate.evaluate_node_set(indexed).size(); }));
+	}
+	if (want("select_nodes"))
+		rows.push_back(measure(input, "select_nodes", input.text.size(), trials, [&]() -> unsigned long long { return doc.select_nodes(input.predicateQuery.c_str()).size(); }));
+	if (want("select_cached"))
+	{
+		pugi::xpath_query_cache cache;
+		rows.push_back(measure(input, "select_cached", input.text.size(), trials, [&]() -> unsigned long long { return cache.get(input.predicateQuery.c_str())->evaluate_node_set(doc).size(); }));
+	}
+
+	CountingWriter sizing;
+	doc.save(sizing);
+	if (want("save"))
+		rows.push_back(measure(input, "save", sizing.size, trials, [&]()
+		{
+			CountingWriter writer;
+			doc.save(writer);
+			return writer.hash;
+		}));
+	if (want("save_file"))
+		rows.push_back(measure(input, "save_file", sizing.size, trials, [&]() -> unsigned long long
+		{
+			return doc.save_file(path) && firstRun ? hashFile(path) : 0;
+		}));
+#ifdef PUGIXML_HAS_POSIX_IO
+	if (want("save_fd"))
+		rows.push_back(measure(input, "save_fd", sizing.size, trials, [&]() -> unsigned long long
+		{
+			int out = open(path, O_WRONLY | O_TRUNC);
+			if (out < 0)
+				return 0;
+			bool saved;
+			{
+				pugi::xml_writer_fd writer(out);
+				doc.save(writer);
+				writer.flush();
+				saved = writer.error() == 0;
+			}
+			close(out);
+			return saved && firstRun ? hashFile(path) : 0;
+		}));
+#endif
+	unlink(path);
+
+	//Numbers are written back into the attributes they were read from; bytes is the size of the text they had
+	vector<pugi::xml_attribute> numbers;
+	vector<double> values;
+	size_t numberBytes = 0;
+	for (pugi::xpath_node node : doc.select_nodes("//@*"))
+	{
+		char* end;
+		double value = strtod(node.attribute().value(), &end);
+		if (*node.attribute().value() && !*end)
+		{
+			numbers.push_back(node.attribute());
+			values.push_back(value);
+			numberBytes += strlen(node.attribute().value());
+		}
+	}
+	if (numbers.empty())
+		return;
+
+	auto hashValues = [&]() -> unsigned long long
+	{
+		CountingWriter writer;
+		for (size_t i = 0; i < numbers.size(); i++)
+			writer.write(numbers[i].value(), strlen(numbers[i].value()) + 1);
+		return writer.hash;
+	};
+	if (want("set_double"))
+		rows.push_back(measure(input, "set_double", numberBytes, trials, [&]() -> unsigned long long
+		{
+			for (size_t i = 0; i < numbers.size(); i++)
+				numbers[i].set_value(values[i]);
+			return firstRun ? hashValues() : 0;
+		}));
+	if (want("set_float"))
+		rows.push_back(measure(input, "set_float", numberBytes, trials, [&]() -> unsigned long long
+		{
+			for (size_t i = 0; i < numbers.size(); i++)
+				numbers[i].set_value((float)values[i]);
+			return firstRun ? hashValues() : 0;
+		}));
+}
+
+static void printCsv(const vector<Row>& rows)
+{
+	printf("input,operation,bytes,best_ms,mb_per_s,allocations,peak_heap_kb,max_rss_kb,result\n");
+	for (auto row = rows.begin(); row != rows.end(); row++)
+		printf("%s,%s,%u,%.4f,%.1f,%u,%u,%ld,%llu\n", row->input.c_str(), row->operation.c_str(), (unsigned)row->bytes, row->bestMs,
+			row->bytes / row->bestMs / 1000, (unsigned)row->allocations, (unsigned)(row->peakHeapBytes / 1024), row->maxRssKb, row->result);
+}
+static void printJson(const vector<Row>& rows)
+{
+	printf("[\n");
+	for (auto row = rows.begin(); row != rows.end(); row++)
+		printf("  {\"input\": \"%s\", \"operation\": \"%s\", \"bytes\": %u, \"best_ms\": %.4f, \"mb_per_s\": %.1f, \"allocations\": %u, "
+			"\"peak_heap_kb\": %u, \"max_rss_kb\": %ld, \"result\": %llu}%s\n", row->input.c_str(), row->operation.c_str(),
+			(unsigned)row->bytes, row->bestMs, row->bytes / row->bestMs / 1000, (unsigned)row->allocations,
+			(unsigned)(row->peakHeapBytes / 1024), row->maxRssKb, row->result, row + 1 == rows.end() ? "" : ",");
+	printf("]\n");
+}
+
+static bool wanted(const string& input, const string& only)
+{
+	return only.empty() || only.compare(0, input.size() + 1, input + "/") == 0;
+}
+
+int main(int argc, char** argv)
+{
+	bool json = false;
+	int trials = 5;
+	double scale = 1;
+	string only;
+	vector<const char*> files;
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--json"))
+			json = true;
+		else if (!strcmp(argv[i], "--trials") && i + 1 < argc)
+			trials = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--scale") && i + 1 < argc)
+			scale = atof(argv[++i]);
+		else if (!strcmp(argv[i], "--only") && i + 1 < argc)
+			only = argv[++i];
+		else if (argv[i][0] == '-')
+		{
+			fprintf(stderr, "usage: %s [--json] [--trials N] [--scale F] [--only input/operation] [file.xml...]\n", argv[0]);
+			return 2;
+		}
+		else
+			files.push_back(argv[i]);
+	}
+
+	pugi::set_memory_management_functions(countingAllocate, countingDeallocate);
+
+	//Inputs are made one at a time, and only if --only asks for them, so that the others do not count towards max_rss_kb
+	vector<Row> rows;
+	if (wanted("config", only))
+		benchmark(Input{"config", config, "//motor", "//motor[@position='frontLeft']", "motor", "position"}, trials, only, rows);
+	if (wanted("telemetry", only))
+		benchmark(Input{"telemetry", telemetry((int)(200000 * scale)), "//sample", "//sample[@lf='0']", "sample", "lf"}, trials, only, rows);
+	if (wanted("telemetry_medium", only))
+		benchmark(Input{"telemetry_medium", telemetry((int)(4000 * scale)), "//sample", "//sample[@lf='0']", "sample", "lf"}, trials, only, rows);
+	if (wanted("scouting", only))
+		benchmark(Input{"scouting", scouting((int)(60000 * scale)), "//comment", "//entry[@alliance='red']", "entry", "alliance"}, trials, only, rows);
+	for (auto file = files.begin(); file != files.end(); file++)
+	{
+		if (!wanted(*file, only))
+			continue;
+		Input input = {*file, "", "//*", "//*[@*]", "", ""};
+		if (!readFile(*file, input.text))
+		{
+			fprintf(stderr, "cannot read %s\n", *file);
+			return 1;
+		}
+		benchmark(input, trials, only, rows);
+	}
+
+	if (json)
+		printJson(rows);
+	else
+		printCsv(rows);
+	return 0;
+}